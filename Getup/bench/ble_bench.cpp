@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------------
+// Getup! BLE Sync Benchmark
+// Plays the phone against the firmware over the simulated Bluefruit link.
+// Each scenario wakes the clock with a button tap so it advertises, connects,
+// sends its request frames, runs loop() until every reply is back and
+// disconnects. Reports the UART bytes, packets and bytes on air, connection
+// events and radio-on time per sync, once with all requests sent back to
+// back and once waiting for each reply before the next request, and the
+// bytes the same exchange would take as a line-based text protocol.
+//
+// usage: program [-c loop_us]
+//   -c  Virtual microseconds charged per loop() pass (default 10).
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "Adafruit_BluefruitLE_SPI.h"
+#include "RTClib.h"
+#include "alarms.h"
+#include "sim.h"
+#include "sync.h"
+
+#define PIN_QI_CHG    (A0)
+#define PIN_BTN_PLUS  (A1)
+#define PIN_BATT      (A5)
+#define BATT_ADC      (2389)  // 3.85 V through the 1:2 divider
+
+#define TAP_US        (60000)
+#define SETTLE_US     (200000)
+#define REPLY_US      (5000000)
+#define MAX_REQUESTS  (8)
+#define TEXT_ALARM    (28)    // "ALARM 01 07:30 -MTWTF- on 0\n"
+#define TEXT_OK       (3)     // "OK\n"
+
+typedef struct {
+  uint8_t type;
+  uint8_t len;
+  uint8_t payload[SYNC_MAX_PAYLOAD];
+  uint16_t text;            // Request and reply as text, bytes
+} request_t;
+
+typedef struct {
+  const char *name;
+  uint8_t count;
+  request_t req[MAX_REQUESTS];
+} scenario_t;
+
+typedef struct {
+  uint32_t payload_bytes;
+  uint32_t air_bytes;
+  uint32_t packets;
+  uint32_t conn_events;
+  uint64_t radio_us;
+  uint64_t elapsed_us;
+  uint32_t naks;
+  uint32_t missing;
+} result_t;
+
+static uint32_t loop_us = 10;
+
+//==============================================================================
+static void run(uint64_t us) {
+  uint64_t end = sim_micros() + us;
+
+  while(sim_micros() < end) {
+    loop();
+    sim_advance(loop_us);
+  }
+}
+
+//==============================================================================
+static void tap() {
+  sim_pin_set(PIN_BTN_PLUS, HIGH);
+  run(TAP_US);
+  sim_pin_set(PIN_BTN_PLUS, LOW);
+  run(SETTLE_US);
+}
+
+//==============================================================================
+static request_t *add(scenario_t *s, uint8_t type, uint16_t text) {
+  request_t *r = &s->req[s->count++];
+
+  r->type = type;
+  r->len = 0;
+  r->text = text;
+  return r;
+}
+
+//==============================================================================
+static void put_u32(request_t *r, uint32_t v) {
+  memcpy(r->payload + r->len, &v, sizeof(v));
+  r->len += sizeof(v);
+}
+
+//==============================================================================
+static void put_u16(request_t *r, uint16_t v) {
+  memcpy(r->payload + r->len, &v, sizeof(v));
+  r->len += sizeof(v);
+}
+
+//==============================================================================
+static void add_time_set(scenario_t *s, uint32_t epoch) {
+  // "TIME 2021-04-17 07:00:00.000\n", "OK\n"
+  request_t *r = add(s, SYNC_TIME_SET, 29 + TEXT_OK);
+
+  put_u32(r, epoch);
+  put_u16(r, 0);
+}
+
+//==============================================================================
+static void add_alarms_put(scenario_t *s, uint8_t first, uint8_t count) {
+  request_t *r = add(s, SYNC_ALARMS_PUT, count * (TEXT_ALARM + TEXT_OK));
+  alarm_t a;
+  uint32_t raw;
+  uint8_t k;
+
+  r->payload[r->len++] = first;
+  r->payload[r->len++] = count;
+  for(k = 0; k < count; k++) {
+    memset(&a, 0, sizeof(a));
+    a.minute = 6 * 60 + 15 * (first + k);
+    a.days = ALARM_DAYS_ALL;
+    a.enabled = (first + k) % 2;
+    a.sound = (first + k) % 4;
+    memcpy(&raw, &a, sizeof(raw));
+    put_u32(r, raw);
+  }
+}
+
+//==============================================================================
+static void add_alarms_get(scenario_t *s, uint8_t first, uint8_t count) {
+  // "ALARMS\n", one line per alarm and "OK\n"
+  request_t *r = add(s, SYNC_ALARMS_GET, 7 + count * TEXT_ALARM + TEXT_OK);
+
+  r->payload[r->len++] = first;
+  r->payload[r->len++] = count;
+}
+
+//==============================================================================
+// Builds the scenarios. Text sizes are for the obvious line protocol: one
+// command per line, OK after each write.
+//==============================================================================
+static uint8_t scenarios_build(scenario_t *s, uint32_t epoch) {
+  uint8_t n = 0;
+
+  memset(s, 0, sizeof(scenario_t) * 5);
+
+  s[n].name = "time";
+  add_time_set(&s[n], epoch);
+  n++;
+
+  s[n].name = "time + 5 alarms";
+  add_time_set(&s[n], epoch);
+  add_alarms_put(&s[n], 0, 5);
+  n++;
+
+  s[n].name = "read 32 alarms";
+  add_alarms_get(&s[n], 0, ALARM_MAX);
+  n++;
+
+  // "STATUS\n", "STATUS 1618642800 3600 412uA 3850mV 62% --- IDLE 03\n"
+  s[n].name = "telemetry";
+  add(&s[n], SYNC_TELEMETRY, 7 + 52);
+  n++;
+
+  // "HELLO\n", "GETUP 1 32 4\n"; "PREFS 10 1\n", "OK\n"; "PREFS\n", ...
+  s[n].name = "full sync";
+  add(&s[n], SYNC_HELLO, 6 + 13);
+  add_time_set(&s[n], epoch);
+  add_alarms_put(&s[n], 0, ALARM_MAX);
+  put_u32(add(&s[n], SYNC_PREFS_PUT, 11 + TEXT_OK), 10 | 1 << 8);
+  add(&s[n], SYNC_PREFS_GET, 6 + 11);
+  add(&s[n], SYNC_TELEMETRY, 7 + 52);
+  n++;
+
+  return n;
+}
+
+//==============================================================================
+// Reads whatever reached the phone and counts complete reply frames.
+//==============================================================================
+static uint8_t phone_receive(sync_parser_t *p, result_t *r) {
+  uint8_t buf[64];
+  uint8_t frames = 0;
+  size_t n, k;
+
+  while((n = sim_ble->sim_phone_read(buf, sizeof(buf)))) {
+    for(k = 0; k < n; k++) {
+      if(!sync_feed(p, buf[k])) continue;
+      if(p->type == SYNC_NAK) r->naks++;
+      frames++;
+    }
+  }
+  return frames;
+}
+
+//==============================================================================
+// Runs one scenario.
+//
+// param pipelined  Send every request at once rather than one per reply.
+//==============================================================================
+static result_t scenario_run(const scenario_t *s, bool pipelined) {
+  const sim_ble_stats_t *st = sim_ble->sim_stats();
+  uint8_t frame[SYNC_MAX_FRAME];
+  sync_parser_t p;
+  result_t r;
+  uint64_t t0, end;
+  uint8_t sent = 0, got = 0;
+  uint16_t n;
+
+  memset(&r, 0, sizeof(r));
+  sync_reset(&p);
+  tap();
+  if(!sim_ble->sim_advertising() || !sim_ble->sim_connect()) {
+    r.missing = s->count;
+    return r;
+  }
+
+  sim_ble->sim_reset();
+  t0 = sim_micros();
+  end = t0 + REPLY_US;
+  while(got < s->count && sim_micros() < end) {
+    while(sent < s->count && (pipelined || sent == got)) {
+      n = sync_frame(frame, s->req[sent].type, sent, s->req[sent].payload,
+        s->req[sent].len);
+      sim_ble->sim_phone_write(frame, n);
+      sent++;
+    }
+    loop();
+    sim_advance(loop_us);
+    got += phone_receive(&p, &r);
+  }
+  r.elapsed_us = sim_micros() - t0;
+  r.missing = s->count - got;
+  sim_ble->sim_disconnect();
+
+  r.payload_bytes = st->payload_bytes;
+  r.air_bytes = st->air_bytes;
+  r.packets = st->packets;
+  r.conn_events = st->conn_events;
+  r.radio_us = st->radio_us;
+  return r;
+}
+
+//==============================================================================
+static void print_row(const scenario_t *s, const result_t *r) {
+  uint32_t text = 0;
+  uint8_t k;
+
+  for(k = 0; k < s->count; k++) text += s->req[k].text;
+  printf("  %-16s %7u %7u %7u %7u %9.2f %9.1f %7u %5u%s\n", s->name,
+    r->payload_bytes, text, r->air_bytes, r->packets, r->radio_us / 1000.0,
+    r->elapsed_us / 1000.0, r->conn_events, r->naks,
+    r->missing ? "  MISSING REPLIES" : "");
+}
+
+//==============================================================================
+static void print_header(const char *title) {
+  printf("%s\n  %-16s %7s %7s %7s %7s %9s %9s %7s %5s\n", title, "scenario",
+    "uart B", "text B", "air B", "pkts", "radio ms", "took ms", "events",
+    "naks");
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  static scenario_t scenarios[5];
+  uint32_t epoch = DateTime(2021, 4, 17, 7, 0, 0).unixtime();
+  const sim_ble_stats_t *st;
+  uint64_t t0;
+  result_t r;
+  uint8_t n, k;
+  int opt;
+
+  while((opt = getopt(argc, argv, "c:")) != -1) {
+    switch(opt) {
+      case 'c': loop_us = strtoul(optarg, 0, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-c loop_us]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  sim_begin(epoch);
+  sim_pin_set(PIN_QI_CHG, HIGH);
+  sim_analog_set(PIN_BATT, BATT_ADC);
+  setup();
+  n = scenarios_build(scenarios, epoch);
+
+  print_header("pipelined");
+  for(k = 0; k < n; k++) {
+    r = scenario_run(&scenarios[k], true);
+    print_row(&scenarios[k], &r);
+  }
+  print_header("\none request per reply");
+  for(k = 0; k < n; k++) {
+    r = scenario_run(&scenarios[k], false);
+    print_row(&scenarios[k], &r);
+  }
+
+  // Radio cost between syncs: the tap above leaves it advertising until the
+  // display and the linger time run out, then it is off.
+  st = sim_ble->sim_stats();
+  sim_ble->sim_reset();
+  t0 = sim_micros();
+  run(60000000);
+  printf("\nafter the last sync: %u adv events, %.1f ms radio in %.0f s, "
+    "advertising %s\n", st->adv_events, st->radio_us / 1000.0,
+    (sim_micros() - t0) / 1e6, sim_ble->sim_advertising() ? "on" : "off");
+  return 0;
+}
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// Getup! Calendar Benchmark
+// Compares src/calendar.cpp with the RTClib DateTime paths it replaced in
+// the firmware:
+//   split    Unix time to fields, once per tick (DateTime(epoch))
+//   join     fields to Unix time, on every loop() pass and every save
+//            (DateTime::unixtime())
+//   weekday  day of the week of a date (DateTime::dayOfTheWeek())
+//   step     one date editor step: DateTime built from the six fields and
+//            its weekday taken for the redraw, against cal_step()
+// Every second of the run is also checked against DateTime, and every day
+// of 2000-2099 for month length and weekday.
+//
+// usage: program [-n seconds] [-e epoch]
+//   -n  Seconds to convert (default 2000000, a little over three weeks).
+//   -e  Unix time to start at (default 2023-12-31 00:00:00, to cross a year
+//       boundary and a leap day).
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "Arduino.h"
+#include "RTClib.h"
+#include "calendar.h"
+
+#define BATCH               (10000)
+#define STEPS               (1000000)
+
+//==============================================================================
+static uint64_t cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==============================================================================
+static uint8_t same(const cal_time_t &t, const DateTime &d) {
+  return t.year == d.year() && t.month == d.month() && t.day == d.day() &&
+    t.hour == d.hour() && t.minute == d.minute() && t.second == d.second() &&
+    t.wday == d.dayOfTheWeek();
+}
+
+//==============================================================================
+static void report(const char *name, uint64_t old_ns, uint64_t new_ns,
+  uint32_t calls) {
+  printf("  %-8s %12.1f %12.1f %9.1fx\n", name, (double)old_ns / calls,
+    (double)new_ns / calls, (double)old_ns / new_ns);
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint32_t seconds = 2000000;
+  uint32_t epoch = DateTime(2023, 12, 31, 0, 0, 0).unixtime();
+  std::vector<DateTime> dts;
+  std::vector<cal_time_t> cts;
+  uint64_t t0, ns[4][2] = {{0}};
+  uint32_t n, done, batch, mismatches = 0, day_errors = 0;
+  volatile uint32_t sink = 0;
+  cal_time_t t;
+  DateTime d;
+  uint16_t y;
+  uint8_t m, dd;
+  int opt;
+
+  while((opt = getopt(argc, argv, "n:e:")) != -1) {
+    switch(opt) {
+      case 'n': seconds = strtoul(optarg, 0, 0); break;
+      case 'e': epoch = strtoul(optarg, 0, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-n seconds] [-e epoch]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  dts.resize(BATCH);
+  cts.resize(BATCH);
+  for(done = 0; done < seconds; done += batch) {
+    batch = seconds - done < BATCH ? seconds - done : BATCH;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) dts[n] = DateTime(epoch + done + n);
+    ns[0][0] += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) cal_split(epoch + done + n, &cts[n]);
+    ns[0][1] += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) sink += dts[n].unixtime();
+    ns[1][0] += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) sink += cal_join(&cts[n]);
+    ns[1][1] += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) sink += dts[n].dayOfTheWeek();
+    ns[2][0] += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) {
+      sink += cal_weekday(cts[n].year, cts[n].month, cts[n].day);
+    }
+    ns[2][1] += cpu_ns() - t0;
+
+    for(n = 0; n < batch; n++) {
+      if(!same(cts[n], dts[n]) || cal_join(&cts[n]) != epoch + done + n) {
+        if(!mismatches) printf("mismatch at %u\n", epoch + done + n);
+        mismatches++;
+      }
+    }
+  }
+
+  // The date editor stepping the day, as before with the day clamped only
+  // on saving, and as now.
+  cal_split(epoch, &t);
+  y = t.year;
+  m = t.month;
+  dd = t.day;
+  t0 = cpu_ns();
+  for(n = 0; n < STEPS; n++) {
+    dd = dd == 31 ? 1 : dd + 1;
+    d = DateTime(y, m, dd, t.hour, t.minute, t.second);
+    sink += d.dayOfTheWeek() + d.day();
+  }
+  ns[3][0] = cpu_ns() - t0;
+
+  t0 = cpu_ns();
+  for(n = 0; n < STEPS; n++) {
+    cal_step(&t, CAL_DAY, 1);
+    sink += t.wday + t.day;
+  }
+  ns[3][1] = cpu_ns() - t0;
+
+  // Every day of the range, through both paths.
+  for(y = CAL_YEAR_MIN; y <= CAL_YEAR_MAX; y++) {
+    for(m = 1; m <= 12; m++) {
+      for(dd = 1; dd <= 31; dd++) {
+        d = DateTime(y, m, dd);
+        if(!d.isValid() != (dd > cal_days_in_month(y, m))) day_errors++;
+        if(d.isValid() && d.dayOfTheWeek() != cal_weekday(y, m, dd)) {
+          day_errors++;
+        }
+      }
+    }
+  }
+
+  printf("seconds converted    %u\n", seconds);
+  printf("mismatches           %u\n", mismatches);
+  printf("day table errors     %u\n", day_errors);
+  printf("\n  %-8s %12s %12s %10s\n", "ns/call", "DateTime", "calendar",
+    "speedup");
+  report("split", ns[0][0], ns[0][1], seconds);
+  report("join", ns[1][0], ns[1][1], seconds);
+  report("weekday", ns[2][0], ns[2][1], seconds);
+  report("step", ns[3][0], ns[3][1], STEPS);
+  return mismatches || day_errors;
+}
@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Drift Benchmark
+// Runs the firmware for days on the virtual clock with both crystals off:
+// the SAMD21 RTC's by a fixed rate plus a daily swing standing in for room
+// temperature, and the DS3231's by a fixed rate. A phone syncs the time
+// every few hours, as the app does on connecting. SysTicks with nothing due
+// are skipped (sim_tickless()), as in week_bench.
+//
+// Reports for each day the learned FREQCORR and aging offset, the worst
+// error of the RTC against the DS3231 (what the display and the alarms
+// follow between measurements) and of the DS3231 against true time, and
+// the DS3231 transactions the day cost. Before calibration the firmware
+// reread the DS3231 every RTC_TIME_RESYNC (3600 s) whatever the crystals
+// did: 24 reads, 48 transactions a day.
+//
+// usage: program [-d days] [-i ppb] [-w ppb] [-x ppb] [-s hours]
+//   -d  Days to run (default 60).
+//   -i  SAMD21 RTC crystal error, ppb, positive fast (default 25000).
+//   -w  Daily swing of the RTC crystal either side of that, ppb (default
+//       2000).
+//   -x  DS3231 error, ppb, positive fast (default 1500).
+//   -s  Hours between phone syncs, 0 for none (default 24).
+//------------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "RTCZero.h"
+#include "calib.h"
+#include "rtc_time.h"
+#include "scheduler.h"
+#include "systime.h"
+#include "sim.h"
+#include "sim_devices.h"
+
+#define START_EPOCH         (1704067200UL) // 2024-01-01 00:00:00
+#define PIN_QI_CHG          (A0)
+#define PIN_BATT            (A5)
+#define BATT_ADC            (2389)      // 3.85 V through the 1:2 divider
+#define DS3231_ADDR         (0x68)
+#define STEP_US             (600000000ull) // Crystal and error sampling
+#define DAY_US              (86400000000ull)
+
+void setup();
+void loop();
+
+static uint64_t until_us = 0;
+
+//==============================================================================
+// Lets sim_wfi() halt until the firmware's next task, but no further than
+// the harness's next step.
+//==============================================================================
+static uint32_t idle_ms() {
+  uint32_t ms = sched_idle(systime_ms());
+  uint64_t left;
+
+  if(until_us <= sim_micros()) return 1;
+  left = (until_us - sim_micros() + 999) / 1000;
+  return left < ms ? (uint32_t)left : ms;
+}
+
+//==============================================================================
+static void run_to(uint64_t us) {
+  until_us = us;
+  while(sim_micros() < us) {
+    loop();
+    sim_advance(10);
+  }
+}
+
+//==============================================================================
+static double true_seconds() {
+  return START_EPOCH + sim_micros() / 1e6;
+}
+
+//==============================================================================
+// The phone's time to the millisecond, as SYNC_TIME_SET carries it.
+//==============================================================================
+static void phone_sync() {
+  uint64_t ms = (uint64_t)START_EPOCH * 1000 + sim_micros() / 1000;
+
+  rtc_time_sync(ms / 1000, ms % 1000, systime_ms());
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint32_t days = 60, sync_h = 24, day, txn0, total0 = 0, late_txn = 0;
+  int32_t int_ppb = 25000, swing_ppb = 2000, ext_ppb = 1500;
+  uint64_t t, next_sync;
+  double rtc_err, ext_err, worst_rtc, worst_ext, late_worst = 0;
+  const calib_coef_t *c;
+  int opt;
+
+  while((opt = getopt(argc, argv, "d:i:w:x:s:")) != -1) {
+    switch(opt) {
+      case 'd': days = strtoul(optarg, 0, 0); break;
+      case 'i': int_ppb = strtol(optarg, 0, 0); break;
+      case 'w': swing_ppb = strtol(optarg, 0, 0); break;
+      case 'x': ext_ppb = strtol(optarg, 0, 0); break;
+      case 's': sync_h = strtoul(optarg, 0, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-d days] [-i ppb] [-w ppb] [-x ppb] "
+          "[-s hours]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  sim_begin(START_EPOCH);
+  sim_pin_set(PIN_QI_CHG, HIGH);
+  sim_analog_set(PIN_BATT, BATT_ADC);
+  sim_accel.set_sample(0, 0, 256);
+  sim_rtc.set_drift(ext_ppb);
+  setup();
+  sim_reset_stats();
+  sim_tickless(idle_ms);
+
+  printf("RTC %+d ppb (+/- %d daily), DS3231 %+d ppb, phone sync every "
+    "%u h\n\n", int_ppb, swing_ppb, ext_ppb, sync_h);
+  printf("%4s %9s %7s %12s %12s %10s\n", "day", "FREQCORR", "aging",
+    "RTC err ms", "DS3231 ms", "DS3231 txn");
+
+  next_sync = sync_h ? sync_h * 3600000000ull + STEP_US / 2 : ~0ull;
+  for(day = 0; day < days; day++) {
+    worst_rtc = worst_ext = 0;
+    txn0 = sim_bus_addr(DS3231_ADDR)->transactions;
+    for(t = day * DAY_US; t < (day + 1) * DAY_US; t += STEP_US) {
+      sim_rtc_zero->sim_drift(int_ppb + (int32_t)(swing_ppb *
+        sin(2 * M_PI * (t % DAY_US) / DAY_US)));
+      if(next_sync <= t + STEP_US) {
+        run_to(next_sync);
+        phone_sync();
+        next_sync += sync_h * 3600000000ull;
+      }
+      run_to(t + STEP_US);
+
+      rtc_err = (sim_rtc_zero->sim_seconds() - sim_rtc.seconds()) * 1000;
+      ext_err = (sim_rtc.seconds() - true_seconds()) * 1000;
+      if(fabs(rtc_err) > fabs(worst_rtc)) worst_rtc = rtc_err;
+      if(fabs(ext_err) > fabs(worst_ext)) worst_ext = ext_err;
+    }
+
+    c = calib_coef();
+    txn0 = sim_bus_addr(DS3231_ADDR)->transactions - txn0;
+    printf("%4u %9d %7d %12.1f %12.1f %10u\n", day + 1, c->freqcorr,
+      c->aging, worst_rtc, worst_ext, txn0);
+    if(day >= days / 2) {
+      late_txn += txn0;
+      if(fabs(worst_rtc) > late_worst) late_worst = fabs(worst_rtc);
+    }
+    total0 += txn0;
+  }
+
+  printf("\nDS3231 transactions  %u, %.1f/day over the second half "
+    "(hourly resync: 48/day)\n", total0,
+    (double)late_txn / (days - days / 2));
+  printf("worst RTC error over the second half  %.1f ms\n", late_worst);
+  return 0;
+}
@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Face Benchmark
+// Compares the incremental clock face renderer with the sprintf_P path it
+// replaced, over a run of consecutive seconds. Every second the renderer is
+// given the same change flags the time service produces, and its lines are
+// checked against a full sprintf_P format of the same time.
+//
+// The old path formatted both lines on every 20 ms FSM pass; the new one
+// draws once per second, and then only the fields that changed. Both are
+// reported per call and per simulated second.
+//
+// usage: program [-n seconds] [-e epoch]
+//   -n  Seconds to render (default 2000000, a little over three weeks).
+//   -e  Unix time to start at (default 2021-12-31 23:00:00, to cross a
+//       year boundary).
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "Arduino.h"
+#include "RTClib.h"
+#include "calendar.h"
+#include "clock_face.h"
+#include "rtc_time.h"
+
+#define BATCH               (10000)
+#define OLD_CALLS_PER_SEC   (50)
+#define LINE                (17)  // 16 characters and terminator
+
+//==============================================================================
+static uint64_t cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==============================================================================
+// The MENU_DATE formatting as it was, with the weekday buffer made big
+// enough for its terminator.
+//==============================================================================
+static void sprintf_face(char *line0, char *line1, const cal_time_t &t) {
+  static char weekday[4];
+  static const char *names[] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+  };
+
+  sprintf_P(weekday, names[t.wday], 0);
+  sprintf_P(line0, "    %.2d:%.2d:%.2d    ",
+    t.hour, t.minute, t.second);
+  sprintf_P(line1, " %s %.4d-%.2d-%.2d ",
+    weekday, t.year, t.month, t.day);
+}
+
+//==============================================================================
+static uint8_t changes(uint32_t prev, uint32_t epoch) {
+  uint8_t changed = RTC_TIME_CHG_SEC;
+
+  if(epoch / 60 != prev / 60) changed |= RTC_TIME_CHG_MIN;
+  if(epoch / 3600 != prev / 3600) changed |= RTC_TIME_CHG_HOUR;
+  if(epoch / 86400 != prev / 86400) changed |= RTC_TIME_CHG_DAY;
+  return changed;
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint32_t seconds = 2000000;
+  uint32_t epoch = DateTime(2021, 12, 31, 23, 0, 0).unixtime();
+  std::vector<cal_time_t> times;
+  cal_time_t t;
+  std::vector<uint8_t> masks;
+  char old0[LINE], old1[LINE];
+  char new0[LINE], new1[LINE];
+  uint64_t t0, old_ns = 0, new_ns = 0;
+  uint32_t n, done, batch, mismatches = 0;
+  uint32_t field_writes[4] = {0, 0, 0, 0};
+  volatile char sink = 0;
+  int opt;
+
+  while((opt = getopt(argc, argv, "n:e:")) != -1) {
+    switch(opt) {
+      case 'n': seconds = strtoul(optarg, 0, 0); break;
+      case 'e': epoch = strtoul(optarg, 0, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-n seconds] [-e epoch]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  cal_split(epoch, &t);
+  clock_face_draw(new0, new1, t, RTC_TIME_CHG_ALL);
+  times.resize(BATCH);
+  masks.resize(BATCH);
+
+  for(done = 0; done < seconds; done += batch) {
+    batch = seconds - done < BATCH ? seconds - done : BATCH;
+    for(n = 0; n < batch; n++) {
+      cal_split(epoch + done + n + 1, &times[n]);
+      masks[n] = changes(epoch + done + n, epoch + done + n + 1);
+    }
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) {
+      sprintf_face(old0, old1, times[n]);
+      sink ^= old0[CLOCK_SEC_X + 1];
+    }
+    old_ns += cpu_ns() - t0;
+
+    t0 = cpu_ns();
+    for(n = 0; n < batch; n++) {
+      clock_face_draw(new0, new1, times[n], masks[n]);
+      sink ^= new0[CLOCK_SEC_X + 1];
+    }
+    new_ns += cpu_ns() - t0;
+
+    // Check every second against a fresh full format.
+    cal_split(epoch + done, &t);
+    clock_face_draw(new0, new1, t, RTC_TIME_CHG_ALL);
+    for(n = 0; n < batch; n++) {
+      clock_face_draw(new0, new1, times[n], masks[n]);
+      sprintf_face(old0, old1, times[n]);
+      if(memcmp(old0, new0, LINE) || memcmp(old1, new1, LINE)) {
+        if(!mismatches) {
+          printf("mismatch at %u: [%s] [%s] vs [%s] [%s]\n",
+            cal_join(&times[n]), new0, new1, old0, old1);
+        }
+        mismatches++;
+      }
+      field_writes[0]++;
+      if(masks[n] & RTC_TIME_CHG_MIN) field_writes[1]++;
+      if(masks[n] & RTC_TIME_CHG_HOUR) field_writes[2]++;
+      if(masks[n] & RTC_TIME_CHG_DAY) field_writes[3]++;
+    }
+  }
+
+  printf("seconds rendered     %u\n", seconds);
+  printf("mismatches           %u\n", mismatches);
+  printf("field updates        sec %u, min %u, hour %u, day %u\n",
+    field_writes[0], field_writes[1], field_writes[2], field_writes[3]);
+  printf("sprintf_P ns / call  %.1f\n", (double)old_ns / seconds);
+  printf("face ns / call       %.1f\n", (double)new_ns / seconds);
+  printf("speedup / call       %.1fx\n", (double)old_ns / new_ns);
+  printf("host us / sim s      %.3f before (%d calls), %.3f after (1 call)\n",
+    (double)old_ns / seconds * OLD_CALLS_PER_SEC / 1000.0, OLD_CALLS_PER_SEC,
+    (double)new_ns / seconds / 1000.0);
+  return 0;
+}
@@ -0,0 +1,218 @@
+//------------------------------------------------------------------------------
+// Getup! I2C Queue Benchmark
+// Times every loop() pass on the virtual clock, less the time halted, while
+// the firmware runs through an idle minute, a burst of menu navigation that
+// repaints the display, and an alarm that rings and is shaken quiet. With
+// the I2C transaction queue no pass waits for the bus, so the worst pass is
+// set by CPU work and the few remaining blocking calls (the Bluefruit AT
+// round trips), not by display traffic. Also reports the I2C traffic and
+// bus occupancy per phase, and how long the shake took to silence the
+// buzzer.
+//
+// usage: program [-c loop_us]
+//   -c  Virtual microseconds charged per loop() pass (default 10).
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "RTClib.h"
+#include "sim.h"
+#include "sim_devices.h"
+
+#define PIN_QI_CHG    (A0)
+#define PIN_BTN_PLUS  (A1)
+#define PIN_BTN_MINUS (A2)
+#define PIN_BTN_SEL   (A3)
+#define PIN_BTN_SET   (A4)
+#define PIN_BATT      (A5)
+#define BATT_ADC      (2389)  // 3.85 V through the 1:2 divider
+
+#define TAP_MS        (60)
+#define GAP_MS        (200)
+#define BUCKET_US     (100)
+#define BUCKETS       (200)   // Passes up to 20 ms
+#define SHAKE_HZ      (5)
+#define SHAKE_MG      (1500)
+#define SHAKE_MS      (3000)
+#define RING_WAIT_US  (120000000)
+#define QUIET_MS      (1000)  // No notes this long means the buzzer stopped
+
+typedef struct {
+  uint32_t passes;
+  uint64_t busy_us;
+  uint32_t worst_us;
+  uint32_t hist[BUCKETS + 1];
+} timing_t;
+
+static uint32_t loop_us = 10;
+static timing_t timing;
+static uint32_t shake_step = 0;
+
+//==============================================================================
+static void pass() {
+  uint64_t t0 = sim_micros();
+  uint64_t idle0 = sim_idle_us();
+  uint32_t us;
+
+  loop();
+  us = (uint32_t)((sim_micros() - t0) - (sim_idle_us() - idle0));
+  timing.passes++;
+  timing.busy_us += us;
+  if(us > timing.worst_us) timing.worst_us = us;
+  timing.hist[us / BUCKET_US < BUCKETS ? us / BUCKET_US : BUCKETS]++;
+  sim_advance(loop_us);
+}
+
+//==============================================================================
+static void run(uint32_t ms) {
+  uint64_t end = sim_micros() + (uint64_t)ms * 1000;
+
+  while(sim_micros() < end) pass();
+}
+
+//==============================================================================
+static void tap(uint8_t pin) {
+  sim_pin_set(pin, HIGH);
+  run(TAP_MS);
+  sim_pin_set(pin, LOW);
+  run(GAP_MS);
+}
+
+//==============================================================================
+// Hand shake along X, a square wave at SHAKE_HZ, on its own event.
+//==============================================================================
+static void shake_event(void *ctx) {
+  int16_t lsb = SHAKE_MG / 4;   // 3.9 mg/LSB at full resolution
+
+  (void)ctx;
+  sim_accel.set_sample(shake_step & 1 ? lsb : -lsb, 0, 256);
+  shake_step++;
+  sim_at(sim_micros() + 500000 / SHAKE_HZ, shake_event, 0);
+}
+
+//==============================================================================
+static void phase_begin() {
+  memset(&timing, 0, sizeof(timing));
+  sim_reset_stats();
+}
+
+//==============================================================================
+// Smallest pass time that 99% of passes stay under.
+//==============================================================================
+static uint32_t p99() {
+  uint64_t seen = 0;
+  uint32_t k;
+
+  for(k = 0; k <= BUCKETS; k++) {
+    seen += timing.hist[k];
+    if(seen * 100 >= (uint64_t)timing.passes * 99) break;
+  }
+  return (k + 1) * BUCKET_US;
+}
+
+//==============================================================================
+static void phase_end(const char *name, uint64_t t0) {
+  const sim_bus_stats_t *bus = sim_bus_total();
+  double sim_s = (sim_micros() - t0) / 1e6;
+
+  printf("  %-14s %8u %9.1f %9u %9u %8.1f %8u %7.2f%%\n", name,
+    timing.passes, (double)timing.busy_us / timing.passes, p99(),
+    timing.worst_us, sim_s, bus->transactions,
+    100.0 * bus->bus_us / 1e6 / sim_s);
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint64_t t0, rang, last_note;
+  uint32_t notes;
+  uint8_t quiet;
+  int opt;
+  uint8_t k;
+
+  while((opt = getopt(argc, argv, "c:")) != -1) {
+    switch(opt) {
+      case 'c': loop_us = strtoul(optarg, 0, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-c loop_us]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  sim_begin(DateTime(2021, 4, 17, 7, 0, 0).unixtime());
+  sim_pin_set(PIN_QI_CHG, HIGH);
+  sim_analog_set(PIN_BATT, BATT_ADC);
+  sim_accel.set_sample(0, 0, 256);
+  setup();
+  run(1000);
+
+  printf("  %-14s %8s %9s %9s %9s %8s %8s %8s\n", "phase", "passes",
+    "mean us", "p99 us", "worst us", "sim s", "i2c txn", "bus");
+
+  // From the clock face: alarm view, alarm 1 on, into its editor and a
+  // minute later than now.
+  tap(PIN_BTN_SEL);
+  tap(PIN_BTN_MINUS);
+  tap(PIN_BTN_SET);
+  tap(PIN_BTN_SEL);
+  tap(PIN_BTN_PLUS);
+  tap(PIN_BTN_SET);
+
+  // Display times out and the clock sits idle until the alarm.
+  phase_begin();
+  t0 = sim_micros();
+  notes = sim_tone_count();
+  while(sim_tone_count() == notes && sim_micros() - t0 < RING_WAIT_US) pass();
+  rang = sim_micros() - t0;
+  phase_end("idle", t0);
+
+  phase_begin();
+  t0 = sim_micros();
+  run(5000);
+  phase_end("ringing", t0);
+
+  phase_begin();
+  t0 = sim_micros();
+  shake_event(0);
+  notes = sim_tone_count();
+  last_note = t0;
+  while(sim_micros() - t0 < (uint64_t)SHAKE_MS * 1000) {
+    pass();
+    if(sim_tone_count() != notes) {
+      notes = sim_tone_count();
+      last_note = sim_micros();
+    }
+  }
+  sim_cancel(shake_event, 0);
+  sim_accel.set_sample(0, 0, 256);
+  phase_end("shaken", t0);
+  quiet = sim_micros() - last_note >= (uint64_t)QUIET_MS * 1000;
+  last_note -= t0;
+
+  // Round the menus: date editor, alarm view and editor, preferences.
+  phase_begin();
+  t0 = sim_micros();
+  for(k = 0; k < 10; k++) {
+    tap(PIN_BTN_SET);
+    tap(PIN_BTN_PLUS);
+    tap(PIN_BTN_SEL);
+    tap(PIN_BTN_MINUS);
+    tap(PIN_BTN_SET);
+    tap(PIN_BTN_SEL);
+    tap(PIN_BTN_SEL);
+    tap(PIN_BTN_SEL);
+  }
+  run(2000);
+  phase_end("menu", t0);
+
+  printf("\nalarm rang after %.3f s idle; ", rang / 1e6);
+  if(quiet) {
+    printf("last note %.0f ms after the shake began\n", last_note / 1000.0);
+  }
+  else {
+    printf("still sounding after %u ms of shaking\n", SHAKE_MS);
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// Getup! loop() Cost Benchmark
+// Runs setup() and then N passes of loop() against the simulated shield and
+// reports host CPU time per pass, CPU duty cycle, task runs and I2C traffic
+// per simulated second, and how that splits across the TIMER_* tasks.
+// Afterwards it asks the firmware for its own current estimate over the
+// serial port, and can save a stats snapshot frame for tools/stats_decode.py.
+//
+// usage: program [-n passes] [-c loop_us] [-o snapshot]
+//   -n  Number of loop() passes (default 200000).
+//   -c  Virtual microseconds charged per pass on top of bus and delay time,
+//       standing in for the core's own execution time (default 10).
+//   -o  File to write the firmware's binary stats snapshot to.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "RTClib.h"
+#include "sim.h"
+#include "sim_devices.h"
+
+// Same order as timers_t in main.cpp.
+static const char *block_names[] = {
+  "BUTTONS", "RTC", "ACCEL", "QI", "BATT",
+  "SPKR", "LED", "LCD", "FSM", "ALM", "STATS", "BLE"
+};
+#define NUM_BLOCKS  (sizeof(block_names) / sizeof(block_names[0]))
+
+#define PIN_QI_CHG  (A0)
+#define PIN_BATT    (A5)
+#define BATT_ADC    (2389)  // 3.85 V through the 1:2 divider
+#define REPLY_MAX   (1024)
+#define REPLY_US    (2000000) // Longest task_stats() period in any profile
+
+//==============================================================================
+static uint64_t cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==============================================================================
+static void print_row(const char *name, const sim_tag_stats_t *t,
+  double sim_s, uint32_t total_txn) {
+  printf("  %-8s %10u %10.3f %10.1f %10.1f %6.1f%%\n", name, t->calls,
+    t->calls ? t->host_ns / 1000.0 / t->calls : 0.0,
+    t->bus.transactions / sim_s, t->bus.bytes / sim_s,
+    total_txn ? 100.0 * t->bus.transactions / total_txn : 0.0);
+}
+
+//==============================================================================
+// Sends a serial command and runs the loop long enough for the reply.
+//==============================================================================
+static size_t command(char cmd, uint8_t *reply, uint32_t loop_us) {
+  uint64_t end = sim_micros() + REPLY_US;
+
+  Serial.inject((const uint8_t *)&cmd, 1);
+  while(sim_micros() < end) {
+    loop();
+    sim_advance(loop_us);
+  }
+  return Serial.drain(reply, REPLY_MAX);
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint32_t passes = 200000;
+  uint32_t loop_us = 10;
+  uint32_t n, runs = 0;
+  uint64_t t0, cpu0, cpu;
+  double sim_s;
+  const sim_bus_stats_t *bus;
+  const char *snapshot = 0;
+  uint8_t reply[REPLY_MAX];
+  size_t len;
+  FILE *f;
+  int opt;
+
+  while((opt = getopt(argc, argv, "n:c:o:")) != -1) {
+    switch(opt) {
+      case 'n': passes = strtoul(optarg, 0, 0); break;
+      case 'c': loop_us = strtoul(optarg, 0, 0); break;
+      case 'o': snapshot = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-n passes] [-c loop_us] [-o snapshot]\n",
+          argv[0]);
+        return 1;
+    }
+  }
+
+  sim_begin(DateTime(2021, 4, 17, 7, 0, 0).unixtime());
+  sim_pin_set(PIN_QI_CHG, HIGH);
+  sim_analog_set(PIN_BATT, BATT_ADC);
+
+  setup();
+  bus = sim_bus_total();
+  printf("setup(): %u transactions, %u bytes, %.3f ms virtual\n\n",
+    bus->transactions, bus->bytes, sim_micros() / 1000.0);
+
+  sim_reset_stats();
+  t0 = sim_micros();
+  cpu0 = cpu_ns();
+  for(n = 0; n < passes; n++) {
+    loop();
+    sim_advance(loop_us);
+  }
+  cpu = cpu_ns() - cpu0;
+  sim_s = (sim_micros() - t0) / 1e6;
+
+  printf("passes            %u\n", passes);
+  printf("simulated time    %.3f s\n", sim_s);
+  printf("host cpu / pass   %.3f us\n", cpu / 1000.0 / passes);
+  printf("passes / sim s    %.1f\n", passes / sim_s);
+  printf("cpu duty cycle    %.1f%%\n",
+    100.0 - 100.0 * sim_idle_us() / 1e6 / sim_s);
+  for(n = 0; n < NUM_BLOCKS; n++) runs += sim_tag_stats(n)->calls;
+  printf("task runs / sim s %.1f\n", runs / sim_s);
+  printf("i2c txn / sim s   %.1f\n", bus->transactions / sim_s);
+  printf("i2c bytes / sim s %.1f\n", bus->bytes / sim_s);
+  printf("i2c bus busy      %.1f%%\n\n", 100.0 * bus->bus_us / 1e6 / sim_s);
+
+  printf("  %-8s %10s %10s %10s %10s %7s\n", "block", "runs", "host us",
+    "txn/s", "bytes/s", "txn");
+  for(n = 0; n < NUM_BLOCKS; n++) {
+    print_row(block_names[n], sim_tag_stats(n), sim_s, bus->transactions);
+  }
+  print_row("other", sim_tag_stats(SIM_TAG_NONE), sim_s, bus->transactions);
+
+  printf("\nlcd: [%.16s]\n     [%.16s]\n", sim_lcd.row(0), sim_lcd.row(1));
+
+  len = command('e', reply, loop_us);
+  printf("\nfirmware estimate: %.*s", (int)len, (const char *)reply);
+
+  if(snapshot) {
+    len = command('s', reply, loop_us);
+    f = fopen(snapshot, "wb");
+    if(!f || fwrite(reply, 1, len, f) != len) {
+      perror(snapshot);
+      return 1;
+    }
+    fclose(f);
+    printf("snapshot: %u bytes to %s\n", (unsigned)len, snapshot);
+  }
+  return 0;
+}
@@ -0,0 +1,238 @@
+//------------------------------------------------------------------------------
+// Getup! Shake Classifier Benchmark
+// Replays labelled ADXL343 traces through shake_feed() and scores it against
+// the labels: missed shakes, false detections per hour of non-shake time, and
+// latency from the start of a shake to the first detection. Also reports the
+// kernel's host cost per sample.
+//
+// A trace is a CSV of 100 Hz samples, "x,y,z,shake" per line, where shake is
+// 1 inside a labelled shake. Lines starting with '#' and the header are
+// skipped. A detection is a rising edge of shake_feed(); edges closer than
+// the refractory time to the previous one are merged.
+//
+// usage: program [-g grace_ms] [-r refractory_ms] [-n repeat] trace.csv...
+//   -g  A detection up to this long after a shake ends still counts for it
+//       (default 500).
+//   -r  Refractory time between detections (default 1000).
+//   -n  Passes over each trace for the timing figures (default 200).
+//
+// Cycle counts are host TSC cycles, not Cortex-M0+ cycles; time the kernel
+// on the board with SysTick for target figures.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+#include "shake.h"
+
+#define SAMPLE_MS   (10)
+
+typedef struct {
+  int16_t x, y, z;
+  uint8_t label;
+} sample_t;
+
+typedef struct {
+  uint32_t shakes;
+  uint32_t missed;
+  uint32_t false_pos;
+  uint32_t quiet_samples;
+  uint32_t latency_sum;
+  uint32_t latency_max;
+} score_t;
+
+//==============================================================================
+static uint64_t cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==============================================================================
+static int load(const char *path, std::vector<sample_t> &out) {
+  char line[128];
+  int x, y, z, label;
+  sample_t s;
+  FILE *f;
+
+  f = fopen(path, "r");
+  if(!f) return -1;
+  while(fgets(line, sizeof(line), f)) {
+    if(line[0] == '#') continue;
+    if(sscanf(line, "%d,%d,%d,%d", &x, &y, &z, &label) != 4) continue;
+    s.x = x;
+    s.y = y;
+    s.z = z;
+    s.label = label ? 1 : 0;
+    out.push_back(s);
+  }
+  fclose(f);
+  return 0;
+}
+
+//==============================================================================
+// One pass of the classifier. Marks det[i] where a detection starts.
+//==============================================================================
+static void detect(const std::vector<sample_t> &t, std::vector<uint8_t> &det,
+  uint32_t refractory) {
+  shake_t s;
+  uint32_t i, last = 0;
+  uint8_t prev = 0, cur, seen = 0;
+
+  shake_init(&s);
+  det.assign(t.size(), 0);
+  for(i = 0; i < t.size(); i++) {
+    cur = shake_feed(&s, t[i].x, t[i].y, t[i].z);
+    if(cur && !prev && (!seen || i - last >= refractory)) {
+      det[i] = 1;
+      last = i;
+      seen = 1;
+    }
+    prev = cur;
+  }
+}
+
+//==============================================================================
+static void score(const std::vector<sample_t> &t,
+  const std::vector<uint8_t> &det, uint32_t grace, score_t *sc) {
+  std::vector<uint8_t> used(t.size(), 0);
+  uint32_t i, j, start, end, lat;
+  uint8_t hit;
+
+  memset(sc, 0, sizeof(*sc));
+  for(i = 0; i < t.size(); i++) {
+    if(!t[i].label) {
+      sc->quiet_samples++;
+      continue;
+    }
+    start = i;
+    while(i < t.size() && t[i].label) i++;
+    end = i;
+
+    // First detection inside the shake or its grace period.
+    sc->shakes++;
+    hit = 0;
+    for(j = start; j < end + grace && j < t.size(); j++) {
+      if(det[j]) {
+        if(!hit) {
+          lat = (j - start) * SAMPLE_MS;
+          sc->latency_sum += lat;
+          if(lat > sc->latency_max) sc->latency_max = lat;
+          hit = 1;
+        }
+        used[j] = 1;
+      }
+    }
+    if(!hit) sc->missed++;
+    i--;
+  }
+  for(i = 0; i < t.size(); i++) {
+    if(det[i] && !used[i]) sc->false_pos++;
+  }
+}
+
+//==============================================================================
+static void print_row(const char *name, const score_t *sc) {
+  double quiet_h = sc->quiet_samples * SAMPLE_MS / 3600000.0;
+  uint32_t hits = sc->shakes - sc->missed;
+
+  printf("  %-24s %6u %6u %6u %8.1f %8.0f %8u\n", name, sc->shakes,
+    sc->missed, sc->false_pos, quiet_h > 0 ? sc->false_pos / quiet_h : 0.0,
+    hits ? (double)sc->latency_sum / hits : 0.0, sc->latency_max);
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  uint32_t grace_ms = 500;
+  uint32_t refractory_ms = 1000;
+  uint32_t repeat = 200;
+  std::vector<std::vector<sample_t> > traces;
+  std::vector<uint8_t> det;
+  score_t sc, total;
+  uint64_t samples = 0, cpu0, cpu;
+#ifdef HAVE_TSC
+  uint64_t tsc0, tsc;
+#endif
+  volatile uint8_t sink = 0;
+  shake_t s;
+  uint32_t n, r, i;
+  int opt;
+
+  while((opt = getopt(argc, argv, "g:r:n:")) != -1) {
+    switch(opt) {
+      case 'g': grace_ms = strtoul(optarg, 0, 0); break;
+      case 'r': refractory_ms = strtoul(optarg, 0, 0); break;
+      case 'n': repeat = strtoul(optarg, 0, 0); break;
+      default: optind = argc + 1; break;
+    }
+  }
+  if(optind >= argc) {
+    fprintf(stderr, "usage: %s [-g grace_ms] [-r refractory_ms] [-n repeat] "
+      "trace.csv...\n", argv[0]);
+    return 1;
+  }
+
+  traces.resize(argc - optind);
+  for(n = 0; n < traces.size(); n++) {
+    if(load(argv[optind + n], traces[n]) || traces[n].empty()) {
+      fprintf(stderr, "%s: cannot read trace\n", argv[optind + n]);
+      return 1;
+    }
+  }
+
+  printf("  %-24s %6s %6s %6s %8s %8s %8s\n", "trace", "shakes", "missed",
+    "false", "false/h", "lat ms", "max ms");
+  memset(&total, 0, sizeof(total));
+  for(n = 0; n < traces.size(); n++) {
+    detect(traces[n], det, refractory_ms / SAMPLE_MS);
+    score(traces[n], det, grace_ms / SAMPLE_MS, &sc);
+    print_row(argv[optind + n], &sc);
+
+    total.shakes += sc.shakes;
+    total.missed += sc.missed;
+    total.false_pos += sc.false_pos;
+    total.quiet_samples += sc.quiet_samples;
+    total.latency_sum += sc.latency_sum;
+    if(sc.latency_max > total.latency_max) total.latency_max = sc.latency_max;
+  }
+  print_row("total", &total);
+  printf("\nmiss rate         %.1f%%\n",
+    total.shakes ? 100.0 * total.missed / total.shakes : 0.0);
+
+  // Kernel cost alone, no scoring.
+  cpu0 = cpu_ns();
+#ifdef HAVE_TSC
+  tsc0 = __rdtsc();
+#endif
+  for(r = 0; r < repeat; r++) {
+    for(n = 0; n < traces.size(); n++) {
+      shake_init(&s);
+      for(i = 0; i < traces[n].size(); i++) {
+        sink |= shake_feed(&s, traces[n][i].x, traces[n][i].y,
+          traces[n][i].z);
+      }
+      samples += traces[n].size();
+    }
+  }
+#ifdef HAVE_TSC
+  tsc = __rdtsc() - tsc0;
+#endif
+  cpu = cpu_ns() - cpu0;
+
+  printf("samples timed     %llu\n", (unsigned long long)samples);
+  printf("host ns / sample  %.2f\n", (double)cpu / samples);
+#ifdef HAVE_TSC
+  printf("host tsc / sample %.1f\n", (double)tsc / samples);
+#else
+  printf("host tsc / sample n/a\n");
+#endif
+  printf("state bytes       %u\n", (unsigned)sizeof(shake_t));
+  return 0;
+}
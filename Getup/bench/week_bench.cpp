@@ -0,0 +1,601 @@
+//------------------------------------------------------------------------------
+// Getup! Week Scenario Runner
+// Plays a script of a user's days against the firmware on the virtual
+// clock: alarms programmed by button presses through the menus, shakes
+// injected as ADXL343 samples, the clock lifted off and put back on the Qi
+// pad (PIN_QI_CHG) and the battery drooping. SysTicks with nothing due are
+// skipped (sim_tickless()), so a week of device time runs in seconds.
+//
+// For every alarm occurrence it reports when the buzzer started relative to
+// the programmed minute, and whether the firmware's ALM task ran in the
+// first three seconds of that minute. The polled check this firmware used
+// before the DS3231 alarm interrupt, second() <= alarms[i].second() + 2 in
+// TIMER_ALM, only fired if it did; a profile or sleep mode that stretches
+// the ALM period past that window would have missed the alarm. Ends with
+// missed alarms, wakeups, I2C traffic and the firmware's own energy
+// estimate for the run.
+//
+// usage: program [-c loop_us] [-v] [-t trace] script
+//   -c  Virtual microseconds charged per loop() pass (default 10).
+//   -v  Print each script step and ring as it happens.
+//   -t  File to write the firmware's event trace to ('t' on the serial
+//       port), dumped after every step, for tools/trace_decode.py.
+//
+// Script lines, # starts a comment:
+//   start YYYY-MM-DD HH:MM:SS           Wall clock at boot; day 0 is this date
+//   <day> HH:MM:SS alarm <n> HH:MM <days> <sound>
+//                                       Program alarm n (from 1) and turn it
+//                                       on; days as on the display, -MTWTF-
+//   <day> HH:MM:SS alarm <n> off
+//   <day> HH:MM:SS press plus|minus|sel|set
+//   <day> HH:MM:SS shake <ms>           Hand shake along X
+//   <day> HH:MM:SS qi on|off            On or off the charging pad
+//   <day> HH:MM:SS batt <mV>            Battery voltage
+//   <day> HH:MM:SS end                  Stop here
+// Steps must be in time order. The script must leave the menus on the
+// clock face between steps and must not set the clock.
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "RTClib.h"
+#include "alarms.h"
+#include "scheduler.h"
+#include "sound.h"
+#include "stats.h"
+#include "systime.h"
+#include "sim.h"
+#include "sim_devices.h"
+
+#define PIN_QI_CHG    (A0)
+#define PIN_BTN_PLUS  (A1)
+#define PIN_BTN_MINUS (A2)
+#define PIN_BTN_SEL   (A3)
+#define PIN_BTN_SET   (A4)
+#define PIN_BATT      (A5)
+#define ADC_FULL_MV   (6600)  // 3.3 V reference behind the 1:2 divider
+#define BATT_MV       (3850)
+
+#define TIMER_ALM     (9)     // timers_t in main.cpp
+#define HOURS         (24)
+#define MINUTES       (60)
+#define TAP_MS        (60)
+#define GAP_MS        (200)
+#define SHAKE_HZ      (5)
+#define SHAKE_MG      (1500)
+#define QUIET_MS      (1000)  // No notes this long ends a ring
+#define FIRE_S        (60)    // A ring later than this is not the alarm's
+#define OLD_WINDOW_S  (2)
+
+#define REPLY_MAX     (4096)
+#define REPLY_US      (2000000) // Longest task_stats() period in any profile
+
+#define MAX_STEPS     (1024)
+#define MAX_FIRES     (512)
+
+enum {
+  CMD_ALARM,
+  CMD_ALARM_OFF,
+  CMD_PRESS,
+  CMD_SHAKE,
+  CMD_QI,
+  CMD_BATT,
+  CMD_END
+};
+
+typedef struct {
+  uint32_t when;            // Unix time
+  uint8_t cmd;
+  uint8_t id;
+  int16_t minute;
+  uint8_t days;
+  uint8_t sound;
+  uint32_t arg;
+} step_t;
+
+typedef struct {
+  uint8_t enabled;
+  int16_t minute;
+  uint8_t days;
+} expect_t;
+
+typedef struct {
+  uint32_t due;             // Unix time of the programmed minute
+  uint8_t id;
+  uint8_t on_pad;
+  uint8_t polled;           // ALM ran inside the old +2 s window
+  uint8_t rang;
+  uint32_t latency_ms;
+} fire_t;
+
+static uint32_t loop_us = 10;
+static uint8_t verbose = 0;
+static FILE *trace_out = 0;
+static step_t steps[MAX_STEPS];
+static uint32_t num_steps = 0;
+static uint32_t start_epoch = 0;
+static uint64_t until_us = 0;
+static expect_t expect[ALARM_MAX];
+static fire_t fires[MAX_FIRES];
+static uint32_t num_fires = 0;
+static uint32_t other_rings = 0;
+static uint32_t last_minute = 0;
+static uint32_t alm_calls = 0;
+static uint32_t notes = 0;
+static uint64_t last_note_us = 0;
+static uint8_t ringing = 0;
+static uint64_t passes = 0;
+static uint64_t halts = 0;
+static uint32_t shake_step = 0;
+
+//==============================================================================
+static uint64_t epoch_us(uint32_t epoch) {
+  return (uint64_t)(epoch - start_epoch) * 1000000;
+}
+
+//==============================================================================
+static void print_when(uint32_t epoch) {
+  static const char *names[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri",
+    "Sat"};
+  DateTime t(epoch);
+
+  printf("%s %04d-%02d-%02d %02d:%02d:%02d", names[t.dayOfTheWeek()],
+    t.year(), t.month(), t.day(), t.hour(), t.minute(), t.second());
+}
+
+//==============================================================================
+static uint8_t parse_days(const char *s) {
+  uint8_t days = 0;
+  uint8_t d;
+
+  if(strlen(s) != 7) return 0xFF;
+  for(d = 0; d < 7; d++) {
+    if(s[d] != '-') days |= 1 << d;
+  }
+  return days;
+}
+
+//==============================================================================
+// Reads the script into steps[].
+//
+// return  Nonzero on success.
+//==============================================================================
+static uint8_t load(const char *path) {
+  char line[128], cmd[16], a[16], b[16];
+  int y, mo, d, h, mi, s, day, n, snd;
+  uint32_t midnight = 0, last = 0;
+  uint32_t lineno = 0;
+  step_t *st;
+  FILE *f;
+
+  f = fopen(path, "r");
+  if(!f) return 0;
+  while(fgets(line, sizeof(line), f)) {
+    lineno++;
+    if(line[0] == '#' || line[strspn(line, " \t\r\n")] == 0) continue;
+    if(sscanf(line, "start %d-%d-%d %d:%d:%d", &y, &mo, &d, &h, &mi, &s) == 6) {
+      midnight = DateTime(y, mo, d).unixtime();
+      start_epoch = DateTime(y, mo, d, h, mi, s).unixtime();
+      last = start_epoch;
+      continue;
+    }
+    a[0] = b[0] = 0;
+    n = sscanf(line, "%d %d:%d:%d %15s %15s %15s", &day, &h, &mi, &s, cmd, a,
+      b);
+    if(n < 5 || !start_epoch || num_steps == MAX_STEPS) goto bad;
+
+    st = &steps[num_steps];
+    memset(st, 0, sizeof(*st));
+    st->when = midnight + day * 86400u + h * 3600u + mi * 60u + s;
+    if(st->when < last) goto bad;
+    last = st->when;
+
+    if(!strcmp(cmd, "alarm") && n == 7 && !strcmp(b, "off")) {
+      st->cmd = CMD_ALARM_OFF;
+      st->id = atoi(a) - 1;
+    }
+    else if(!strcmp(cmd, "alarm") && n == 7) {
+      st->cmd = CMD_ALARM;
+      st->id = atoi(a) - 1;
+      if(sscanf(b, "%d:%d", &h, &mi) != 2) goto bad;
+      st->minute = h * MINUTES + mi;
+      if(sscanf(line, "%*d %*s %*s %*s %*s %15s %d", a, &snd) != 2) goto bad;
+      st->days = parse_days(a);
+      st->sound = snd;
+      if(st->days == 0xFF) goto bad;
+    }
+    else if(!strcmp(cmd, "press") && n == 6) {
+      st->cmd = CMD_PRESS;
+      if(!strcmp(a, "plus")) st->arg = PIN_BTN_PLUS;
+      else if(!strcmp(a, "minus")) st->arg = PIN_BTN_MINUS;
+      else if(!strcmp(a, "sel")) st->arg = PIN_BTN_SEL;
+      else if(!strcmp(a, "set")) st->arg = PIN_BTN_SET;
+      else goto bad;
+    }
+    else if(!strcmp(cmd, "shake") && n == 6) {
+      st->cmd = CMD_SHAKE;
+      st->arg = strtoul(a, 0, 0);
+    }
+    else if(!strcmp(cmd, "qi") && n == 6) {
+      st->cmd = CMD_QI;
+      st->arg = !strcmp(a, "on");
+    }
+    else if(!strcmp(cmd, "batt") && n == 6) {
+      st->cmd = CMD_BATT;
+      st->arg = strtoul(a, 0, 0);
+    }
+    else if(!strcmp(cmd, "end") && n == 5) {
+      st->cmd = CMD_END;
+    }
+    else {
+      goto bad;
+    }
+    if((st->cmd == CMD_ALARM || st->cmd == CMD_ALARM_OFF) &&
+      st->id >= ALARM_MAX) goto bad;
+    num_steps++;
+  }
+  fclose(f);
+  return num_steps && steps[num_steps - 1].cmd == CMD_END;
+
+bad:
+  fprintf(stderr, "%s:%u: bad line\n", path, lineno);
+  fclose(f);
+  return 0;
+}
+
+//==============================================================================
+// Lets sim_wfi() halt until the firmware's next task, but no further than
+// the harness's next step.
+//==============================================================================
+static uint32_t idle_ms() {
+  uint32_t ms = sched_idle(systime_ms());
+  uint64_t left;
+
+  if(until_us <= sim_micros()) return 1;
+  left = (until_us - sim_micros() + 999) / 1000;
+  return left < ms ? (uint32_t)left : ms;
+}
+
+//==============================================================================
+// Notes alarm occurrences as their minute starts, ALM runs inside the old
+// window, and the start and end of each ring.
+//==============================================================================
+static void watch() {
+  uint32_t now = sim_rtc.epoch();
+  uint32_t minute = now / 60;
+  uint32_t calls = sim_tag_stats(TIMER_ALM)->calls;
+  uint8_t dow, k;
+  fire_t *f;
+
+  if(minute != last_minute) {
+    last_minute = minute;
+    dow = DateTime(now).dayOfTheWeek();
+    for(k = 0; k < ALARM_MAX && num_fires < MAX_FIRES; k++) {
+      if(!expect[k].enabled || !(expect[k].days & (1 << dow))) continue;
+      if(expect[k].minute != (int16_t)(now % 86400 / 60)) continue;
+      f = &fires[num_fires++];
+      memset(f, 0, sizeof(*f));
+      f->due = minute * 60;
+      f->id = k;
+      f->on_pad = !sim_pin_get(PIN_QI_CHG);
+    }
+  }
+
+  if(calls != alm_calls) {
+    alm_calls = calls;
+    for(f = fires; f < fires + num_fires; f++) {
+      if(now >= f->due && now - f->due <= OLD_WINDOW_S) f->polled = 1;
+    }
+  }
+
+  if(sim_tone_count() != notes) {
+    notes = sim_tone_count();
+    last_note_us = sim_micros();
+    if(ringing) return;
+    ringing = 1;
+    for(f = fires; f < fires + num_fires; f++) {
+      if(f->rang || sim_micros() < epoch_us(f->due) ||
+        sim_micros() - epoch_us(f->due) >= FIRE_S * 1000000ull) continue;
+      f->rang = 1;
+      f->latency_ms = (sim_micros() - epoch_us(f->due)) / 1000;
+      break;
+    }
+    if(f == fires + num_fires) other_rings++;
+    if(verbose) {
+      print_when(now);
+      printf("  ring%s\n", f == fires + num_fires ? " (snooze or stray)" :
+        "");
+    }
+  }
+  else if(ringing && sim_micros() - last_note_us >= QUIET_MS * 1000ull) {
+    ringing = 0;
+    if(verbose) {
+      print_when(now);
+      printf("  quiet\n");
+    }
+  }
+}
+
+//==============================================================================
+static void pass() {
+  uint64_t idle0 = sim_idle_us();
+
+  loop();
+  passes++;
+  if(sim_idle_us() != idle0) halts++;
+  sim_advance(loop_us);
+  watch();
+}
+
+//==============================================================================
+static void run_to(uint64_t us) {
+  until_us = us;
+  while(sim_micros() < us) pass();
+}
+
+//==============================================================================
+static void tap(uint8_t pin) {
+  sim_pin_set(pin, HIGH);
+  run_to(sim_micros() + TAP_MS * 1000);
+  sim_pin_set(pin, LOW);
+  run_to(sim_micros() + GAP_MS * 1000);
+}
+
+//==============================================================================
+// Reads the alarm screen off the display.
+//
+// return  Nonzero if the display shows an alarm.
+//==============================================================================
+static uint8_t read_alarm(uint8_t *id, uint8_t *on, int16_t *minute,
+  uint8_t *days, uint8_t *sound) {
+  char row[17], mask[8];
+  int n, h, m, snd;
+
+  memcpy(row, sim_lcd.row(0), 16);
+  row[16] = 0;
+  if(sscanf(row, "Alarm %d", &n) != 1) return 0;
+  *id = n - 1;
+  *on = strstr(row, " on") != 0;
+
+  memcpy(row, sim_lcd.row(1), 16);
+  row[16] = 0;
+  if(sscanf(row, "%d:%d %7s s%d", &h, &m, mask, &snd) != 4) return 0;
+  *minute = h * MINUTES + m;
+  *days = parse_days(mask);
+  *sound = snd;
+  return 1;
+}
+
+//==============================================================================
+// Steps the field under the cursor from cur to want the short way round.
+//==============================================================================
+static void step_field(int16_t cur, int16_t want, int16_t range) {
+  int16_t up = ((want - cur) % range + range) % range;
+  int16_t k;
+
+  if(up <= range / 2) {
+    for(k = 0; k < up; k++) tap(PIN_BTN_PLUS);
+  }
+  else {
+    for(k = 0; k < range - up; k++) tap(PIN_BTN_MINUS);
+  }
+}
+
+//==============================================================================
+// From the clock face: the alarm list, PLUS to the alarm, SET into the
+// editor and through its fields, SET to save, MINUS if it must be turned on
+// or off, then SEL to the preferences and SET back to the clock face.
+//
+// return  Nonzero if the display shows the wanted alarm afterwards.
+//==============================================================================
+static uint8_t program(const step_t *st) {
+  uint8_t id, on, days, sound, d, k;
+  uint8_t want_on = st->cmd == CMD_ALARM;
+  int16_t minute;
+
+  tap(PIN_BTN_SEL);
+  for(k = 0; k < ALARM_MAX; k++) {
+    if(!read_alarm(&id, &on, &minute, &days, &sound)) return 0;
+    if(id == st->id) break;
+    tap(PIN_BTN_PLUS);
+  }
+
+  if(want_on) {
+    tap(PIN_BTN_SET);
+    step_field(minute / MINUTES, st->minute / MINUTES, HOURS);
+    tap(PIN_BTN_SEL);
+    step_field(minute % MINUTES, st->minute % MINUTES, MINUTES);
+    for(d = 0; d < 7; d++) {
+      tap(PIN_BTN_SEL);
+      if(((days ^ st->days) >> d) & 1) tap(PIN_BTN_PLUS);
+    }
+    tap(PIN_BTN_SEL);
+    step_field(sound, st->sound, NUM_SOUNDS);
+    tap(PIN_BTN_SET);
+  }
+  if(!read_alarm(&id, &on, &minute, &days, &sound)) return 0;
+  if(on != want_on) tap(PIN_BTN_MINUS);
+  if(!read_alarm(&id, &on, &minute, &days, &sound)) return 0;
+
+  tap(PIN_BTN_SEL);
+  tap(PIN_BTN_SET);
+  return id == st->id && on == want_on && (!want_on ||
+    (minute == st->minute && days == st->days && sound == st->sound));
+}
+
+//==============================================================================
+// Hand shake along X, a square wave at SHAKE_HZ, on its own event.
+//==============================================================================
+static void shake_event(void *ctx) {
+  int16_t lsb = SHAKE_MG / 4;   // 3.9 mg/LSB at full resolution
+
+  (void)ctx;
+  sim_accel.set_sample(shake_step & 1 ? lsb : -lsb, 0, 256);
+  shake_step++;
+  sim_at(sim_micros() + 500000 / SHAKE_HZ, shake_event, 0);
+}
+
+//==============================================================================
+static void shake_stop(void *ctx) {
+  (void)ctx;
+  sim_cancel(shake_event, 0);
+  sim_accel.set_sample(0, 0, 256);
+}
+
+//==============================================================================
+static void step(const step_t *st) {
+  if(verbose) {
+    print_when(sim_rtc.epoch());
+    printf("  step %u\n", (unsigned)(st - steps) + 1);
+  }
+  switch(st->cmd) {
+    case CMD_ALARM:
+    case CMD_ALARM_OFF:
+      if(!program(st)) {
+        fprintf(stderr, "step %u: alarm %u not programmed; menus left on "
+          "[%.16s]\n", (unsigned)(st - steps) + 1, st->id + 1, sim_lcd.row(0));
+        exit(1);
+      }
+      expect[st->id].enabled = st->cmd == CMD_ALARM;
+      expect[st->id].minute = st->minute;
+      expect[st->id].days = st->days;
+      break;
+    case CMD_PRESS:
+      tap(st->arg);
+      break;
+    case CMD_SHAKE:
+      shake_event(0);
+      sim_at(sim_micros() + st->arg * 1000ull, shake_stop, 0);
+      break;
+    case CMD_QI:
+      sim_pin_set(PIN_QI_CHG, st->arg ? LOW : HIGH);
+      break;
+    case CMD_BATT:
+      sim_analog_set(PIN_BATT, st->arg * 4096 / ADC_FULL_MV);
+      break;
+  }
+}
+
+//==============================================================================
+// Asks the firmware for its event trace and appends the frame to trace_out.
+//==============================================================================
+static void dump_trace() {
+  static uint8_t reply[REPLY_MAX];
+  char cmd = 't';
+  size_t len;
+
+  Serial.inject((const uint8_t *)&cmd, 1);
+  run_to(sim_micros() + REPLY_US);
+  len = Serial.drain(reply, sizeof(reply));
+  fwrite(reply, 1, len, trace_out);
+}
+
+//==============================================================================
+static uint64_t wall_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==============================================================================
+int main(int argc, char **argv) {
+  static const char *wake_names[STATS_NUM_WAKE] = {"button", "tick", "alarm",
+    "accel", "qi", "ble"};
+  uint32_t k, rang = 0, missed = 0, on_pad = 0, window = 0;
+  uint64_t host0, host;
+  const sim_bus_stats_t *bus;
+  const stats_t *s;
+  const char *trace_path = 0;
+  double days, sim_s;
+  fire_t *f;
+  int opt;
+
+  while((opt = getopt(argc, argv, "c:vt:")) != -1) {
+    switch(opt) {
+      case 'c': loop_us = strtoul(optarg, 0, 0); break;
+      case 'v': verbose = 1; break;
+      case 't': trace_path = optarg; break;
+      default: optind = argc; break;
+    }
+  }
+  if(optind != argc - 1) {
+    fprintf(stderr, "usage: %s [-c loop_us] [-v] [-t trace] script\n",
+      argv[0]);
+    return 1;
+  }
+  if(!load(argv[optind])) {
+    fprintf(stderr, "%s: cannot read script\n", argv[optind]);
+    return 1;
+  }
+  if(trace_path && !(trace_out = fopen(trace_path, "wb"))) {
+    perror(trace_path);
+    return 1;
+  }
+
+  host0 = wall_ns();
+  sim_begin(start_epoch);
+  sim_pin_set(PIN_QI_CHG, HIGH);
+  sim_analog_set(PIN_BATT, BATT_MV * 4096 / ADC_FULL_MV);
+  sim_accel.set_sample(0, 0, 256);
+  setup();
+  sim_reset_stats();
+  sim_tickless(idle_ms);
+  last_minute = sim_rtc.epoch() / 60;
+
+  for(k = 0; k < num_steps && steps[k].cmd != CMD_END; k++) {
+    run_to(epoch_us(steps[k].when));
+    step(&steps[k]);
+    if(trace_out) dump_trace();
+  }
+  run_to(epoch_us(steps[k].when));
+  if(trace_out) {
+    dump_trace();
+    fclose(trace_out);
+  }
+  host = wall_ns() - host0;
+
+  sim_s = sim_micros() / 1e6;
+  days = sim_s / 86400;
+  printf("scenario   %s, %.2f days from ", argv[optind], days);
+  print_when(start_epoch);
+  printf("\nhost time  %.2f s, %.0fx real time, %llu loop() passes\n\n",
+    host / 1e9, sim_s / (host / 1e9), (unsigned long long)passes);
+
+  printf("  %-23s %5s %10s  %s\n", "alarm minute", "alarm", "latency",
+    "old +2 s window");
+  for(f = fires; f < fires + num_fires; f++) {
+    printf("  ");
+    print_when(f->due);
+    printf("  %5u ", f->id + 1);
+    if(f->rang) printf("%7u ms ", f->latency_ms);
+    else printf("%10s ", f->on_pad ? "on pad" : "MISSED");
+    printf(" %s\n", f->polled ? "ALM ran" : "MISSED");
+    // Going on the pad cancels an alarm on purpose.
+    rang += f->rang;
+    on_pad += !f->rang && f->on_pad;
+    missed += !f->rang && !f->on_pad;
+    window += !f->polled;
+  }
+  printf("\nalarms     %u due, %u rang, %u on pad, %u missed, %u outside the "
+    "old window; %u other rings (snooze)\n", num_fires, rang, on_pad, missed,
+    window, other_rings);
+
+  s = stats_get(sim_rtc.epoch(), millis());
+  printf("wakeups    %llu from __WFI(), %u from standby\n",
+    (unsigned long long)halts, s->standby_count);
+  printf("irqs      ");
+  for(k = 0; k < STATS_NUM_WAKE; k++) {
+    printf(" %s %u", wake_names[k], s->irqs[k]);
+  }
+  bus = sim_bus_total();
+  printf("\ni2c        %u transactions, %u bytes, bus busy %.3f%%\n",
+    bus->transactions, bus->bytes, 100.0 * bus->bus_us / 1e6 / sim_s);
+  printf("energy     %u uA average, %.1f mAh, %.1f mAh/day (firmware "
+    "estimate)\n", stats_avg_ua(s), stats_avg_ua(s) * sim_s / 3600 / 1000,
+    stats_avg_ua(s) * 24 / 1000.0);
+  return 0;
+}
@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+// Getup! Alarm Store
+// Packed alarm records with weekday recurrence. Every enabled weekday of every
+// alarm is kept as a slot in a list sorted by minute of the week, and a cursor
+// into that list always points at the next one due, so finding the next fire
+// time does not depend on how many alarms there are.
+//------------------------------------------------------------------------------
+
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <stdint.h>
+
+#define ALARM_MAX           (32)
+#define ALARM_NONE          (0xFF)
+#define ALARM_MINUTES       (1440)
+
+// Weekday masks, bit n = dayOfTheWeek() n
+#define ALARM_SUN           (0x01)
+#define ALARM_SAT           (0x40)
+#define ALARM_DAYS_ALL      (0x7F)
+#define ALARM_DAYS_WEEKDAYS (0x3E)
+#define ALARM_DAYS_WEEKEND  (0x41)
+
+//==============================================================================
+// One alarm in 4 bytes.
+//==============================================================================
+typedef struct {
+  uint32_t minute : 11;   // Minute of day, 0 to ALARM_MINUTES - 1
+  uint32_t days : 7;      // Weekdays it repeats on
+  uint32_t enabled : 1;
+  uint32_t sound : 4;
+  uint32_t : 9;
+} alarm_t;
+
+//==============================================================================
+// Sets every alarm to a template and rebuilds the index. Call alarms_seek()
+// before asking for the next fire time.
+//
+// param a  Record copied into all ALARM_MAX entries.
+//==============================================================================
+void alarms_begin(alarm_t a);
+
+//==============================================================================
+// Returns an alarm record. Ids are 0 to ALARM_MAX - 1.
+//==============================================================================
+alarm_t alarms_get(uint8_t id);
+
+//==============================================================================
+// Replaces an alarm and updates its slots in the index. The cursor is moved
+// to the first fire time after now.
+//
+// param id   Alarm id.
+// param a    New record.
+// param now  Current time as Unix time.
+//==============================================================================
+void alarms_set(uint8_t id, alarm_t a, uint32_t now);
+
+//==============================================================================
+// Moves the cursor to the first fire time after now. Needed when the clock
+// is changed.
+//
+// param now  Current time as Unix time.
+//==============================================================================
+void alarms_seek(uint32_t now);
+
+//==============================================================================
+// Moves the cursor past the fire time it points at, and past any other
+// alarms due at the same minute.
+//==============================================================================
+void alarms_advance();
+
+//==============================================================================
+// Next fire time at the cursor.
+//
+// param id  Set to the alarm due then, ALARM_NONE if none. May be null.
+// return  Fire time as Unix time, 0 if no alarm is enabled.
+//==============================================================================
+uint32_t alarms_next(uint8_t *id);
+
+#endif // ALARMS_H
@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+// Getup! Battery Gauge
+// Measures the LiPo cell through the divider on PIN_BATT_LOW. Each
+// measurement is a short burst of ADC reads summed to 14 bits, taken only
+// when the caller asks (every 30 s from TIMER_BATT), and smoothed so that
+// the sag while the backlight or buzzer is on does not move the gauge.
+// State of charge comes from a resting-voltage table of a typical LiPo cell,
+// interpolated between 10 % steps.
+//------------------------------------------------------------------------------
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdint.h>
+
+// ADC reads summed per measurement; 16 12-bit reads make one 14-bit result
+#define BATTERY_SAMPLES     (16)
+#define BATTERY_BITS        (14)
+
+// Low-battery flag thresholds, percent. Set at or below LOW, cleared at or
+// above OK.
+#define BATTERY_LOW_PCT     (10)
+#define BATTERY_OK_PCT      (15)
+
+//==============================================================================
+// Sets up the ADC and takes the first measurement.
+//
+// param pin          Analog pin on the cell divider.
+// param full_scale   Cell voltage in mV that reads as ADC full scale.
+//==============================================================================
+void battery_begin(uint8_t pin, uint16_t full_scale);
+
+//==============================================================================
+// Takes a measurement.
+//
+// return  Nonzero if the percentage or the low-battery flag changed.
+//==============================================================================
+uint8_t battery_update();
+
+//==============================================================================
+// Smoothed cell voltage in mV.
+//==============================================================================
+uint16_t battery_mv();
+
+//==============================================================================
+// State of charge, 0 to 100 percent.
+//==============================================================================
+uint8_t battery_percent();
+
+//==============================================================================
+// Nonzero while the cell is low. Subsystems can use it to cut their draw.
+//==============================================================================
+uint8_t battery_low();
+
+//==============================================================================
+// State of charge of a resting cell.
+//
+// param mv  Cell voltage in mV.
+// return  0 to 100 percent.
+//==============================================================================
+uint8_t battery_soc(uint16_t mv);
+
+#endif // BATTERY_H
@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+// Getup! Button Input
+// Interrupt-driven push buttons. Every button pin interrupts on both edges;
+// the ISR debounces by timestamp and queues press and release events in a
+// single-producer, single-consumer ring, so nothing samples the pins while
+// they sit still. The reader adds long-press and auto-repeat events for a
+// button held down, and buttons_due() says when the next of those is due.
+// Buttons are active high.
+//------------------------------------------------------------------------------
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+
+#define BUTTONS_MAX         (8)
+#define BUTTONS_QUEUE       (16)    // Events, a power of two
+
+// An edge this soon after the last accepted one on the same button is bounce
+#define BUTTONS_DEBOUNCE_MS (5)
+
+// Hold time to BUTTONS_LONG, then the interval between BUTTONS_REPEATs
+#define BUTTONS_LONG_MS     (500)
+#define BUTTONS_REPEAT_MS   (500)
+
+// buttons_due() with nothing to wait for
+#define BUTTONS_IDLE        (0xFFFFFFFF)
+
+typedef enum {
+  BUTTONS_PRESS,
+  BUTTONS_RELEASE,
+  BUTTONS_LONG,             // Held for BUTTONS_LONG_MS, once per press
+  BUTTONS_REPEAT            // Still held, every BUTTONS_REPEAT_MS after that
+} buttons_type_t;
+
+//==============================================================================
+// One button event.
+//==============================================================================
+typedef struct {
+  uint32_t ms;              // systime_ms() at the edge or when the hold
+                            // was due
+  uint8_t button;           // Index into the pins given to buttons_begin()
+  uint8_t type;             // buttons_type_t
+} buttons_event_t;
+
+//==============================================================================
+// Configures the pins and attaches their interrupts.
+//
+// param pins  Button pins; a button's index in here is its id in events.
+// param num   Number of pins, up to BUTTONS_MAX.
+//==============================================================================
+void buttons_begin(const uint8_t *pins, uint8_t num);
+
+//==============================================================================
+// Nonzero if the ISR has queued an event not read yet. Cheap enough to call
+// before every sleep.
+//==============================================================================
+uint8_t buttons_pending();
+
+//==============================================================================
+// Takes the next event: queued edges first, then any long-press or repeat
+// that has come due.
+//
+// param e    Filled in with the event.
+// param now  Current time in ms, systime_ms().
+// return  Nonzero if there was an event.
+//==============================================================================
+uint8_t buttons_read(buttons_event_t *e, uint64_t now);
+
+//==============================================================================
+// Time until buttons_read() has something new without another interrupt.
+//
+// param now  Current time in ms.
+// return  ms until the next long-press or repeat, 0 if one is due or events
+//         are queued, BUTTONS_IDLE if no button is down.
+//==============================================================================
+uint32_t buttons_due(uint64_t now);
+
+//==============================================================================
+// Events lost to a full queue since buttons_begin().
+//==============================================================================
+uint32_t buttons_dropped();
+
+#endif // BUTTONS_H
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Getup! Calendar
+// Wall-clock time as a 32-bit Unix second count, with conversion to and from
+// calendar fields and field-wise stepping for the date editor. Covers
+// 2000-01-01 to 2099-12-31, the DS3231's range, where every fourth year is
+// a leap year; the day count within each four-year block comes from
+// compile-time tables, so conversion needs no loop over years or months.
+//------------------------------------------------------------------------------
+
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <stdint.h>
+
+// Range, as Unix time
+#define CAL_EPOCH_MIN       (946684800UL)   // 2000-01-01 00:00:00
+#define CAL_EPOCH_MAX       (4102444799UL)  // 2099-12-31 23:59:59
+
+#define CAL_YEAR_MIN        (2000)
+#define CAL_YEAR_MAX        (2099)
+
+#define CAL_DAY_SECS        (86400UL)
+
+// Fields for cal_step()
+#define CAL_YEAR            (0)
+#define CAL_MONTH           (1)
+#define CAL_DAY             (2)
+#define CAL_HOUR            (3)
+#define CAL_MINUTE          (4)
+#define CAL_SECOND          (5)
+
+//==============================================================================
+// Broken-down time.
+//==============================================================================
+typedef struct {
+  uint16_t year;            // CAL_YEAR_MIN to CAL_YEAR_MAX
+  uint8_t month;            // 1 to 12
+  uint8_t day;              // 1 to cal_days_in_month()
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint8_t wday;             // 0 = Sunday, as DateTime::dayOfTheWeek()
+} cal_time_t;
+
+//==============================================================================
+// Nonzero for a leap year within the range.
+//==============================================================================
+constexpr uint8_t cal_leap(uint16_t year) {
+  return year % 4 == 0;
+}
+
+//==============================================================================
+// Days in a month.
+//
+// param year   CAL_YEAR_MIN to CAL_YEAR_MAX.
+// param month  1 to 12.
+//==============================================================================
+uint8_t cal_days_in_month(uint16_t year, uint8_t month);
+
+//==============================================================================
+// Day of the week of a date; 0 is Sunday.
+//==============================================================================
+uint8_t cal_weekday(uint16_t year, uint8_t month, uint8_t day);
+
+//==============================================================================
+// Splits Unix time into fields. Times before CAL_EPOCH_MIN give
+// CAL_EPOCH_MIN.
+//==============================================================================
+void cal_split(uint32_t epoch, cal_time_t *t);
+
+//==============================================================================
+// Joins fields into Unix time. t->wday is ignored.
+//==============================================================================
+uint32_t cal_join(const cal_time_t *t);
+
+//==============================================================================
+// Steps one field, wrapping within its own range and leaving the others
+// alone, as a watch is set. The day wraps at the end of its month, and a
+// change of month or year pulls it back into the new month. t->wday
+// follows.
+//
+// param t      Time to change; its fields must be in range.
+// param field  CAL_*.
+// param n      Steps, either way.
+//==============================================================================
+void cal_step(cal_time_t *t, uint8_t field, int16_t n);
+
+#endif // CALENDAR_H
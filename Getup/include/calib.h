@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Calibration
+// Learns how fast the SAMD21 RTC runs against the DS3231 and how fast the
+// DS3231 runs against an outside reference, and turns both into trims: the
+// RTC's FREQCORR and the DS3231's aging offset.
+//
+// The time service measures the RTC's offset from the DS3231 to a tick of
+// systime (under 1 ms) by timing the DS3231's 1 Hz square wave against the
+// RTC's own second. Two offsets some hours apart give the drift that the
+// current FREQCORR leaves, and FREQCORR is moved by the nearest whole step.
+// Each measurement that finds the drift within the timing jitter plus
+// CALIB_SETTLED_PPB doubles the wait to the next, up to
+// CALIB_INTERVAL_MAX; one that does not halves it, down to
+// CALIB_INTERVAL_MIN.
+//
+// The RTC can only be stepped by whole seconds, and a step of FREQCORR is
+// about 80 ms over two days, so the phase would wander up to half a second
+// either side. Up to CALIB_STEER_MAX steps more or less are applied until
+// the next measurement to pull it back in.
+//
+// The DS3231 is a TCXO and already far better than the RTC, so the only
+// reference good enough to trim it is time from the phone, which comes to
+// the millisecond. The DS3231 is set to it only when that brings it
+// closer by more than CALIB_REF_SLACK, as a write can only start a whole
+// second, and its error is summed over at least CALIB_AGING_SPAN before
+// the aging offset is moved. The link's latency is the same in the error
+// before and after a set, so it drops out of the sum.
+//
+// Nothing here touches hardware or flash; the time service applies the
+// trims and the firmware stores calib_coef().
+//------------------------------------------------------------------------------
+
+#ifndef CALIB_H
+#define CALIB_H
+
+#include <stdint.h>
+
+// SAMD21 RTC FREQCORR: one prescaler clock in 2^20 per step. Values here
+// are positive to speed the RTC up; the register has SIGN set for that,
+// and the time service flips the sign when it writes it.
+#define CALIB_FREQCORR_PPB  (954)
+#define CALIB_FREQCORR_MAX  (127)
+#define CALIB_STEER_MAX     (2)
+
+// DS3231 aging offset: about 0.1 ppm per step at 25 C, positive slows the
+// oscillator. Moved by at most CALIB_AGING_STEP at a time.
+#define CALIB_AGING_PPB     (100)
+#define CALIB_AGING_MAX     (127)
+#define CALIB_AGING_STEP    (10)
+
+// Seconds between RTC measurements. The first only takes the phase.
+#define CALIB_INTERVAL_FIRST  (60)
+#define CALIB_INTERVAL_MIN    (900)
+#define CALIB_INTERVAL_MAX    (172800)
+
+// Drift left after a FREQCORR step that still counts as settled, and drift
+// too large to be the crystal's, ppb
+#define CALIB_SETTLED_PPB   (1000)
+#define CALIB_DRIFT_MAX     (200000)
+
+// Offset measurement jitter, systime ticks: one per time stamp
+#define CALIB_JITTER        (2)
+
+// The DS3231 is set to the reference when that gains more than this many
+// ms; more than CALIB_REF_LOST ms off, it lost power or was set wrong
+// rather than drifted
+#define CALIB_REF_SLACK     (100)
+#define CALIB_REF_LOST      (60000L)
+
+// The DS3231's error against the reference must have built up over this
+// long, and to this many ms, to move the aging offset
+#define CALIB_AGING_SPAN    (30 * 86400UL)
+#define CALIB_AGING_ERR     (1000)
+
+//==============================================================================
+// What is learned, stored as CALIB_WORDS 32-bit values.
+//==============================================================================
+typedef struct {
+  int8_t freqcorr;          // RTC FREQCORR, CALIB_FREQCORR_PPB steps
+  int8_t aging;             // DS3231 aging offset, CALIB_AGING_PPB steps
+  uint16_t reserved;        // Zero
+  int32_t ref_err;          // DS3231 error so far less its current one, ms
+  uint32_t ref_epoch;       // Reference time the error runs from, 0 if none
+} calib_coef_t;
+
+#define CALIB_WORDS         (3)
+
+static_assert(sizeof(calib_coef_t) == CALIB_WORDS * sizeof(uint32_t),
+  "calib_coef_t is stored as CALIB_WORDS words");
+
+//==============================================================================
+// Starts from stored coefficients, or from none.
+//
+// param saved  What calib_coef() returned before the reset, or null.
+//==============================================================================
+void calib_begin(const calib_coef_t *saved);
+
+//==============================================================================
+// Returns the coefficients, for the trims and for storing.
+//==============================================================================
+const calib_coef_t *calib_coef();
+
+//==============================================================================
+// Returns the FREQCORR to apply: the learned one and the phase steering.
+//==============================================================================
+int8_t calib_freqcorr();
+
+//==============================================================================
+// Takes one measurement of the RTC against the DS3231 and moves FREQCORR if
+// the drift since the last one calls for it.
+//
+// param epoch   DS3231 time of the measurement as Unix time.
+// param offset  DS3231 less RTC time at a DS3231 second, systime ticks;
+//               positive if the RTC is behind.
+// return  Whole seconds to add to the RTC to bring it within half a second
+//         of the DS3231.
+//==============================================================================
+int16_t calib_measure(uint32_t epoch, int32_t offset);
+
+//==============================================================================
+// Seconds to wait before the next calib_measure().
+//==============================================================================
+uint32_t calib_interval();
+
+//==============================================================================
+// Forgets the last measurement, after either clock was set. The next one
+// only takes the phase again.
+//==============================================================================
+void calib_restart();
+
+//==============================================================================
+// Takes time from an outside reference, and moves the aging offset once the
+// DS3231's error against it has built up long enough.
+//
+// param err    DS3231 less reference time, ms.
+// param after  What err would be right after setting the DS3231 to the
+//              reference's nearest second, ms.
+// param ref    Reference time as Unix time.
+// return  1 if the DS3231 should be set, else 0.
+//==============================================================================
+uint8_t calib_reference(int32_t err, int16_t after, uint32_t ref);
+
+//==============================================================================
+// Forgets the DS3231's error against the reference, after it was set by
+// hand.
+//==============================================================================
+void calib_unreferenced();
+
+#endif // CALIB_H
@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+// Getup! Qi Charger Status
+// Follows the Qi receiver's CHG output, low while charging, from a pin
+// interrupt on both edges instead of polling. The first edge after a quiet
+// spell is taken at once, so a change is seen within a loop pass; edges in
+// the CHARGER_DEBOUNCE_MS after it are bounce, and the pin is read once
+// more when that window closes in case it settled the other way. The
+// interrupt also wakes the core from standby.
+//------------------------------------------------------------------------------
+
+#ifndef CHARGER_H
+#define CHARGER_H
+
+#include <stdint.h>
+
+// Edges this soon after an accepted one are bounce
+#define CHARGER_DEBOUNCE_MS (50)
+
+// charger_due() with nothing to wait for
+#define CHARGER_IDLE        (0xFFFFFFFF)
+
+//==============================================================================
+// Configures the pin, takes its level as it is now and attaches the
+// interrupt.
+//
+// param pin  CHG pin, active low.
+//==============================================================================
+void charger_begin(uint8_t pin);
+
+//==============================================================================
+// Nonzero if the ISR has seen an edge charger_update() has not taken yet.
+// Cheap enough to call before every sleep.
+//==============================================================================
+uint8_t charger_pending();
+
+//==============================================================================
+// Takes edges from the ISR and rereads the pin once a bounce has had time
+// to settle.
+//
+// param now  Current time in ms, systime_ms().
+// return  Nonzero if charger_on() changed since the last call.
+//==============================================================================
+uint8_t charger_update(uint64_t now);
+
+//==============================================================================
+// Debounced charge state as of the last charger_update(); 1 if charging.
+//==============================================================================
+uint8_t charger_on();
+
+//==============================================================================
+// Time until charger_update() must look at the pin again without another
+// interrupt.
+//
+// param now  Current time in ms.
+// return  ms until a bounce has settled, CHARGER_IDLE if none is pending.
+//==============================================================================
+uint32_t charger_due(uint64_t now);
+
+#endif // CHARGER_H
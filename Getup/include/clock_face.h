@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Face
+// Renders the time and date screen into the two LCD line buffers. Only the
+// fields flagged as changed are rewritten, straight from lookup tables, so a
+// normal second costs two byte copies instead of two full sprintf_P calls.
+//
+//  !    07:30:00  85%
+//    Sat 2021-04-17
+//
+// The battery field sits in the margins and is drawn separately, since it
+// changes on its own schedule.
+//------------------------------------------------------------------------------
+
+#ifndef CLOCK_FACE_H
+#define CLOCK_FACE_H
+
+#include <stdint.h>
+#include "calendar.h"
+
+// Cells of each field
+#define CLOCK_TIME_Y        (0)
+#define CLOCK_HR_X          (4)
+#define CLOCK_MIN_X         (7)
+#define CLOCK_SEC_X         (10)
+#define CLOCK_LOW_X         (0)
+#define CLOCK_BATT_X        (13)
+
+#define CLOCK_DATE_Y        (1)
+#define CLOCK_WDAY_X        (1)
+#define CLOCK_YR_X          (5)
+#define CLOCK_MO_X          (10)
+#define CLOCK_DY_X          (13)
+
+//==============================================================================
+// Brings the line buffers up to date with a time.
+//
+// param line0, line1  16-character line buffers plus terminator.
+// param t             Time to show.
+// param changed       RTC_TIME_CHG_* bits for the fields that changed since
+//                     the last call. All of RTC_TIME_CHG_ALL redraws
+//                     everything, including the separators.
+//==============================================================================
+void clock_face_draw(char *line0, char *line1, const cal_time_t &t,
+  uint8_t changed);
+
+//==============================================================================
+// Draws the battery field. Call after any full redraw, which blanks it.
+//
+// param line0    Time line buffer.
+// param percent  State of charge; 100 shows as 99.
+// param low      Nonzero to show the low-battery mark.
+//==============================================================================
+void clock_face_battery(char *line0, uint8_t percent, uint8_t low);
+
+#endif // CLOCK_FACE_H
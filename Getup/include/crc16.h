@@ -0,0 +1,25 @@
+//------------------------------------------------------------------------------
+// Getup! CRC-16
+// CRC-16/CCITT (polynomial 0x1021) shared by the settings store and the
+// serial snapshots.
+//------------------------------------------------------------------------------
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC16_INIT          (0xFFFF)
+
+//==============================================================================
+// Runs bytes through the CRC. Chain calls by passing the previous result.
+//
+// param data  Bytes to add.
+// param len   Number of bytes.
+// param crc   CRC16_INIT, or the result of the previous call.
+// return  Updated CRC.
+//==============================================================================
+uint16_t crc16(const void *data, size_t len, uint16_t crc);
+
+#endif // CRC16_H
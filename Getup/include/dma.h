@@ -0,0 +1,64 @@
+//------------------------------------------------------------------------------
+// Getup! DMA Controller
+// Owns the DMAC descriptor and write-back sections, which every channel
+// shares, and sets channels up for peripheral-triggered transfers. Channel
+// numbers are handed out here so users do not collide. A channel may have a
+// transfer-complete callback, run from the DMAC interrupt.
+//------------------------------------------------------------------------------
+
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+
+#define DMA_CHANNELS        (4)
+
+// Channel assignments
+#define DMA_CH_SOUND_NOTE   (0)   // Buzzer period and duty per note
+#define DMA_CH_SOUND_TIME   (1)   // Buzzer note lengths
+#define DMA_CH_I2C_TX       (2)   // SERCOM3 I2C master, to DATA
+#define DMA_CH_I2C_RX       (3)   // SERCOM3 I2C master, from DATA
+
+// Transfer-complete callback, run in interrupt context.
+typedef void (*dma_done_t)(uint8_t ch);
+
+#ifndef GETUP_NATIVE
+#include <Arduino.h>
+
+//==============================================================================
+// Enables the DMAC. Safe to call more than once.
+//==============================================================================
+void dma_begin();
+
+//==============================================================================
+// First descriptor of a channel, in the shared descriptor section.
+//==============================================================================
+DmacDescriptor *dma_descriptor(uint8_t ch);
+
+//==============================================================================
+// Resets a channel and sets its trigger. The channel is left disabled.
+//
+// param ch        Channel.
+// param trigsrc   Peripheral trigger, *_DMAC_ID_*.
+// param trigact   DMAC_CHCTRLB_TRIGACT_* action per trigger.
+// param level     Priority level, 0 (lowest) to 3.
+//==============================================================================
+void dma_channel(uint8_t ch, uint8_t trigsrc, uint32_t trigact, uint8_t level);
+
+//==============================================================================
+// Starts or stops a channel.
+//==============================================================================
+void dma_enable(uint8_t ch);
+void dma_disable(uint8_t ch);
+
+//==============================================================================
+// Sets or clears a channel's transfer-complete callback. Set it after
+// dma_channel(), which resets the channel's interrupt enables.
+//
+// param ch  Channel.
+// param fn  Callback, or null for none.
+//==============================================================================
+void dma_on_done(uint8_t ch, dma_done_t fn);
+#endif
+
+#endif // DMA_H
@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+// Getup! Power Governor
+// Picks a power profile from the state of the unit and retunes the scheduler
+// to it. Each profile is a row of task periods in a constant table owned by
+// the firmware, indexed by scheduler task id; switching profile is a
+// sched_set_period() per task, so a task whose period shrinks runs as soon
+// as its last run is a new period old.
+//
+// Profiles, in order of precedence:
+//   GOV_RINGING      Alarm ringing: buzzer, shake and display all live
+//   GOV_INTERACTIVE  Backlight on: someone is using the buttons
+//   GOV_LOW_BATT     Display off, cell low and not charging
+//   GOV_IDLE         Display off, an alarm is due soon
+//   GOV_NIGHT        Display off, nothing due for a while
+//------------------------------------------------------------------------------
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdint.h>
+
+// An alarm closer than this keeps the unit out of GOV_NIGHT, seconds
+#define GOV_NIGHT_LEAD      (900)
+
+// alarm_in when no alarm is set
+#define GOV_NO_ALARM        (0xFFFFFFFF)
+
+// Table entry for a task that sets its own period
+#define GOV_KEEP            (0)
+
+typedef enum {
+  GOV_INTERACTIVE,
+  GOV_IDLE,
+  GOV_NIGHT,
+  GOV_RINGING,
+  GOV_LOW_BATT,
+  GOV_NUM_PROFILES
+} gov_profile_t;
+
+//==============================================================================
+// What the governor decides on.
+//==============================================================================
+typedef struct {
+  uint8_t display_on;       // Backlight timeout still running
+  uint8_t ringing;
+  uint8_t charging;
+  uint8_t battery_low;
+  uint32_t alarm_in;        // Seconds to the next alarm or snooze
+} gov_state_t;
+
+//==============================================================================
+// Loads the profile table and applies the first profile.
+//
+// param table      GOV_NUM_PROFILES rows of num_tasks periods in ms, or
+//                  GOV_KEEP to leave a task alone.
+// param num_tasks  Tasks per row, scheduler ids 0 to num_tasks - 1.
+// param first      Profile to start in.
+//==============================================================================
+void gov_begin(const uint16_t *table, uint8_t num_tasks, uint8_t first);
+
+//==============================================================================
+// Picks the profile for a state.
+//
+// return  GOV_* profile.
+//==============================================================================
+uint8_t gov_choose(const gov_state_t *s);
+
+//==============================================================================
+// Switches to the profile for a state. Does nothing if already there.
+//
+// return  Nonzero if the profile changed.
+//==============================================================================
+uint8_t gov_update(const gov_state_t *s);
+
+//==============================================================================
+// Current profile.
+//==============================================================================
+uint8_t gov_profile();
+
+#endif // GOVERNOR_H
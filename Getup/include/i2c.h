@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// Getup! I2C Transaction Queue
+// Non-blocking I2C master on SERCOM3, the Zero's Wire port, moving bytes
+// with the DMAC. Callers queue whole transactions, a write or a register
+// read, and get a completion callback; nothing waits for the bus. Each
+// transaction has a priority, and the next one started is the oldest of
+// the highest priority queued, so a long display update cannot hold up a
+// clock or accelerometer read by more than the transaction already on the
+// bus. Transactions to one address keep their order as long as that
+// address always uses the same priority.
+//
+// i2c_poll() drives the queue from the main loop: it finishes the
+// transaction on the bus, starts the next and runs the finished one's
+// callback, all in main context. Wire may still be used directly before
+// i2c_begin() and while i2c_idle().
+//------------------------------------------------------------------------------
+
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+#define I2C_QUEUE           (16)    // Transactions queued or on the bus
+#define I2C_DATA_MAX        (64)    // Bytes per write, register included
+
+// Priorities, lowest first
+#define I2C_PRIO_LOW        (0)
+#define I2C_PRIO_HIGH       (1)
+
+// Write flags. I2C_MERGE appends the write to one still queued for the same
+// address and register, for registers that take repeated bytes in place.
+#define I2C_MERGE           (0x01)
+
+// Completion codes
+#define I2C_OK              (0)
+#define I2C_ERR_NACK        (1)     // Address or data not acknowledged
+#define I2C_ERR_BUS         (2)     // Bus error or arbitration lost
+
+//==============================================================================
+// Completion callback, run from i2c_poll().
+//
+// param ctx  Pointer given with the transaction.
+// param err  I2C_OK or an I2C_ERR_* code.
+//==============================================================================
+typedef void (*i2c_done_t)(void *ctx, uint8_t err);
+
+//==============================================================================
+// Takes over SERCOM3 from Wire, which must already be begun, and sets up
+// its DMA channels.
+//==============================================================================
+void i2c_begin();
+
+//==============================================================================
+// Queues a write. The data is copied.
+//
+// param addr   7-bit device address.
+// param data   Bytes to send, register pointer first.
+// param len    1 to I2C_DATA_MAX.
+// param prio   I2C_PRIO_*.
+// param flags  I2C_MERGE or 0.
+// param cb     Completion callback, or null.
+// param ctx    Handed back to cb.
+// return  Nonzero if queued, 0 if the queue is full.
+//==============================================================================
+uint8_t i2c_write(uint8_t addr, const uint8_t *data, uint8_t len,
+  uint8_t prio, uint8_t flags, i2c_done_t cb, void *ctx);
+
+//==============================================================================
+// Queues a register read: the register pointer is written, then len bytes
+// read. The write ends in a STOP, so the read starts the bus afresh; the
+// DS3231, ADXL343 and MCP23008 all keep the pointer across it.
+//
+// param addr  7-bit device address.
+// param reg   First register.
+// param buf   Filled in by the time cb runs; must stay valid until then.
+// param len   Bytes to read, at least 1.
+// param prio  I2C_PRIO_*.
+// param cb    Completion callback, or null.
+// param ctx   Handed back to cb.
+// return  Nonzero if queued, 0 if the queue is full.
+//==============================================================================
+uint8_t i2c_read(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len,
+  uint8_t prio, i2c_done_t cb, void *ctx);
+
+//==============================================================================
+// Advances the queue. Call on every loop pass; returns at once when the bus
+// is still busy.
+//==============================================================================
+void i2c_poll();
+
+//==============================================================================
+// Nonzero if nothing is queued or on the bus.
+//==============================================================================
+uint8_t i2c_idle();
+
+//==============================================================================
+// Transaction slots free.
+//==============================================================================
+uint8_t i2c_free();
+
+#endif // I2C_H
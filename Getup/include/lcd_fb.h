@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+// Getup! LCD Framebuffer
+// 16x2 shadow of the HD44780 behind the MCP23008 backpack. Only cells that
+// differ from what the display already shows are sent, and each run of them
+// goes out as one multi-byte I2C burst to the GPIO register, queued at low
+// priority on the I2C transaction queue.
+//------------------------------------------------------------------------------
+
+#ifndef LCD_FB_H
+#define LCD_FB_H
+
+#include <stdint.h>
+
+#define LCD_FB_COLS         (16)
+#define LCD_FB_ROWS         (2)
+
+//==============================================================================
+// Takes over the display after Adafruit_LiquidCrystal::begin() has
+// initialized it, before i2c_begin(). Puts the MCP23008 in byte mode so
+// repeated writes land on GPIO, and assumes a blank screen with the
+// backlight on and no cursor.
+//
+// param addr  7-bit I2C address of the MCP23008.
+//==============================================================================
+void lcd_fb_begin(uint8_t addr);
+
+//==============================================================================
+// Copies up to LCD_FB_COLS characters of text into a row of the shadow.
+//
+// param row   Display row.
+// param text  Null-terminated text; short lines leave the rest unchanged.
+//==============================================================================
+void lcd_fb_write(uint8_t row, const char *text);
+
+//==============================================================================
+// Shows the underline cursor at a cell.
+//==============================================================================
+void lcd_fb_cursor(uint8_t col, uint8_t row);
+
+//==============================================================================
+// Hides the cursor.
+//==============================================================================
+void lcd_fb_no_cursor();
+
+//==============================================================================
+// Sets the backlight state sent with the next flush.
+//==============================================================================
+void lcd_fb_backlight(uint8_t on);
+
+//==============================================================================
+// Queues everything that differs from the display. Sends nothing if the
+// I2C queue is too full to take a whole update.
+//
+// return  Number of character cells queued.
+//==============================================================================
+uint8_t lcd_fb_flush();
+
+//==============================================================================
+// Nonzero if a flush was put off for want of queue room and the queue now
+// has room for it.
+//==============================================================================
+uint8_t lcd_fb_pending();
+
+//==============================================================================
+// Nonzero if the last flush was put off for want of queue room.
+//==============================================================================
+uint8_t lcd_fb_deferred();
+
+#endif // LCD_FB_H
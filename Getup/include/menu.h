@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+// Getup! Menu Engine
+// Runs the menu from a constant table of screens. A screen lists the fields
+// it edits, with their cursor cells and ranges, and the callbacks that load,
+// draw and commit its values; PLUS and MINUS step the field under the
+// cursor, SEL moves to the next field and SET commits. The engine only does
+// work when a button event or a relevant time change arrives, and only
+// redraws then. Auto-repeat comes from the button driver as repeat events.
+//------------------------------------------------------------------------------
+
+#ifndef MENU_H
+#define MENU_H
+
+#include <stdint.h>
+
+// Button bits for menu_update(), in the firmware's BTN_* order
+#define MENU_PLUS           (0x01)
+#define MENU_MINUS          (0x02)
+#define MENU_SEL            (0x04)
+#define MENU_SET            (0x08)
+
+// Field flags
+#define MENU_WRAP           (0x01)  // Step past an end wraps to the other
+#define MENU_REPEAT         (0x02)  // Takes repeats of PLUS and MINUS
+
+// Screen id meaning "stay here"; SEL then wraps to the first field
+#define MENU_STAY           (0xFF)
+
+// Change bits handed to draw() when the whole screen must be drawn
+#define MENU_DRAW_ALL       (0xFF)
+
+#define MENU_MAX_VALUES     (12)
+
+//==============================================================================
+// One editable value. The field's index in its screen is the index of the
+// value it edits.
+//==============================================================================
+typedef struct {
+  uint8_t x, y;             // Cursor cell
+  int16_t min, max;
+  int16_t step;
+  uint8_t flags;
+} menu_field_t;
+
+//==============================================================================
+// One screen. Any callback may be null.
+//==============================================================================
+typedef struct {
+  const menu_field_t *fields;
+  uint8_t num_fields;
+  uint8_t next;             // Screen after SEL on the last field, commits
+  uint8_t done;             // Screen after SET, commits
+  uint8_t live;             // RTC_TIME_CHG_* bits that redraw the screen
+
+  // Loads the values when the screen is entered
+  void (*enter)(int16_t *v);
+  // Formats the screen from the values. changed is MENU_DRAW_ALL, or the
+  // live bits that triggered the redraw.
+  void (*draw)(const int16_t *v, uint8_t changed);
+  // Applies the values
+  void (*commit)(const int16_t *v, uint64_t now);
+  // PLUS (+1) or MINUS (-1) on a screen with no fields
+  void (*adjust)(int8_t dir);
+  // Steps value field by n in place of its range, for values whose range
+  // depends on the others
+  void (*step)(int16_t *v, uint8_t field, int16_t n);
+} menu_screen_t;
+
+//==============================================================================
+// Starts the menu on a screen.
+//
+// param table  Screens, indexed by id.
+// param first  Id of the first screen.
+//==============================================================================
+void menu_begin(const menu_screen_t *table, uint8_t first);
+
+//==============================================================================
+// Handles button events and time changes. Returns at once if nothing
+// concerns the current screen.
+//
+// param pressed   MENU_* bits of buttons that went down.
+// param repeated  MENU_* bits of buttons that auto-repeated.
+// param changed   RTC_TIME_CHG_* bits since the last call.
+// param now       Current time in ms.
+//==============================================================================
+void menu_update(uint8_t pressed, uint8_t repeated, uint8_t changed,
+  uint64_t now);
+
+#endif // MENU_H
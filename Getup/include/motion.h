@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+// Getup! Motion Sensing
+// Interrupt-driven ADXL343 handling. With the alarm quiet the sensor runs in
+// low-power mode with only activity detection enabled, and nothing is read
+// over I2C until it reports movement. While the alarm rings it streams
+// 3-axis samples into its FIFO and raises a watermark interrupt; each
+// interrupt drains the batch through the shake classifier. All bus traffic
+// goes through the I2C transaction queue, so servicing an interrupt is a
+// chain of reads that finishes over later loop passes.
+//------------------------------------------------------------------------------
+
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stdint.h>
+#include "Adafruit_ADXL343.h"
+
+// Quiet: 12.5 Hz low-power, activity only
+#define MOTION_IDLE_RATE    (0x17)
+// Ringing: 100 Hz, FIFO stream mode, watermark every MOTION_BATCH samples
+#define MOTION_ARMED_RATE   (0x0A)
+#define MOTION_BATCH        (16)
+
+// Activity threshold, 62.5 mg/LSB
+#define MOTION_ACT_THRESH   (0x10)
+
+// Flags returned by motion_update()
+#define MOTION_ACTIVITY     (0x01)
+#define MOTION_SHAKE        (0x02)
+
+//==============================================================================
+// Queues the ADXL343 set-up for quiet mode and attaches its interrupt. All
+// interrupt sources are routed to INT2. Needs i2c_begin() first.
+//
+// param addr     7-bit I2C address of the ADXL343, already begun.
+// param irq_pin  Pin wired to ADXL343 INT2.
+//==============================================================================
+void motion_begin(uint8_t addr, uint8_t irq_pin);
+
+//==============================================================================
+// Switches between quiet and ringing mode. Does nothing if already there.
+//
+// param on  Nonzero while the alarm is ringing.
+//==============================================================================
+void motion_arm(uint8_t on);
+
+//==============================================================================
+// Starts servicing a pending ADXL343 interrupt and collects what earlier
+// ones found. No bus traffic if none is pending.
+//
+// return  MOTION_* flags for what interrupts reported since the last call,
+//         0 if none.
+//==============================================================================
+uint8_t motion_update();
+
+//==============================================================================
+// Nonzero if an interrupt is waiting for motion_update() to service it, or
+// its reads have finished with something to report.
+//==============================================================================
+uint8_t motion_pending();
+
+#endif // MOTION_H
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// Getup! Power States
+// Decides how deep the core sleeps between loop passes and what is switched
+// off around it. The firmware picks one of three states each pass:
+//   POWER_ACTIVE   Display lit. The core halts in __WFI() between SysTicks.
+//   POWER_IDLE     Display off, but the radio or the buzzer still needs the
+//                  clocks. Halts as above.
+//   POWER_STANDBY  Nothing running. The core goes into SAMD21 standby
+//                  whenever no work is due for POWER_STANDBY_MIN_MS, and
+//                  wakes on the next 1 Hz RTC tick or a wake source.
+// Each state may have entry and exit hooks, run once per change of state.
+//
+// Wake sources are registered once at startup: an interrupt source, a check
+// for events its ISR has left for the firmware, and the scheduler task that
+// takes them. The pin interrupts themselves stay with their drivers, whose
+// attachInterrupt() also enables the pin's EIC wakeup; power_begin() gives
+// the EIC a clock that keeps running in standby, so edges are still seen.
+//
+// SysTick stops in standby, and millis() with it; deadlines and edge time
+// stamps use systime_ms(), which does not.
+//
+// Nothing is received on the serial port in standby; wake the unit with a
+// button before sending a stats or trace command.
+//------------------------------------------------------------------------------
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "RTCZero.h"
+
+// Work due sooner than this keeps the core out of standby, ms. Later work
+// may run up to a tick late.
+#define POWER_STANDBY_MIN_MS  (2)
+
+// Most wake sources that can be registered
+#define POWER_MAX_WAKE      (8)
+
+typedef enum {
+  POWER_ACTIVE,
+  POWER_IDLE,
+  POWER_STANDBY,
+  POWER_NUM_STATES
+} power_state_t;
+
+//==============================================================================
+// Nonzero while a wake source has events for its task.
+//==============================================================================
+typedef uint8_t (*power_pending_fn)();
+
+//==============================================================================
+// Entry or exit hook.
+//==============================================================================
+typedef void (*power_hook_fn)();
+
+//==============================================================================
+// Starts in POWER_ACTIVE and sets up the SAMD21 for standby.
+//
+// param rtc  Internal RTC driver, already begun; wakes the core each second.
+//==============================================================================
+void power_begin(RTCZero *rtc);
+
+//==============================================================================
+// Registers a wake source, replacing any earlier one with the same id.
+//
+// param source   STATS_WAKE_* id.
+// param pending  Check for unhandled events. Called before every halt, so
+//                it must be cheap.
+// param task     Scheduler task id triggered while pending() is nonzero.
+//==============================================================================
+void power_wake(uint8_t source, power_pending_fn pending, uint8_t task);
+
+//==============================================================================
+// Sets the hooks run on entering and leaving a state. Either may be null.
+//==============================================================================
+void power_hooks(uint8_t state, power_hook_fn enter, power_hook_fn exit);
+
+//==============================================================================
+// Triggers the task of every wake source with events pending.
+//
+// return  Nonzero if any was pending.
+//==============================================================================
+uint8_t power_poll();
+
+//==============================================================================
+// Moves to a state, running the old state's exit hook and the new one's
+// entry hook. Does nothing if already there.
+//
+// param state  POWER_*.
+//==============================================================================
+void power_set(uint8_t state);
+
+//==============================================================================
+// Current state.
+//==============================================================================
+uint8_t power_state();
+
+//==============================================================================
+// Halts the core until the next SysTick, or in POWER_STANDBY with enough
+// time to spare, puts it in standby until the next tick. Either way an
+// interrupt ends it early. Returns at once if idle_ms is 0 or a wake source
+// has events pending. Standby also waits for the I2C queue to drain, and
+// only halts until then.
+//
+// param idle_ms  Time until any task is due, from sched_idle().
+//==============================================================================
+void power_sleep(uint32_t idle_ms);
+
+#endif // POWER_H
@@ -0,0 +1,22 @@
+//------------------------------------------------------------------------------
+// Getup! Profiling Hooks
+// Brackets the TIMER_* blocks in loop(). The stats counters see them on
+// every build; the native build also attributes simulated bus traffic and
+// host CPU time to them.
+//------------------------------------------------------------------------------
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "stats.h"
+
+#ifdef GETUP_NATIVE
+#include "sim.h"
+#define PROFILE_BEGIN(id)   do { sim_tag_enter(id); stats_enter(id); } while(0)
+#define PROFILE_END()       do { stats_exit(); sim_tag_exit(); } while(0)
+#else
+#define PROFILE_BEGIN(id)   stats_enter(id)
+#define PROFILE_END()       stats_exit()
+#endif
+
+#endif // PROFILE_H
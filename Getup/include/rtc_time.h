@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+// Getup! Time Service
+// Keeps wall-clock time without polling the DS3231. The DS3231 is read at
+// boot; in between, the SAMD21 RTC seeded from it raises a once-a-second
+// alarm and the cached time is advanced from that. Wake-up alarms are held
+// in the DS3231's Alarm1, whose INT output is an edge interrupt on the
+// SAMD21. After rtc_time_begin() every DS3231 access goes through the I2C
+// transaction queue and nothing here waits for the bus.
+//
+// In place of a fixed resync, the internal RTC is measured against the
+// DS3231 on the schedule calib_interval() sets: INT/SQW is switched to the
+// 1 Hz square wave for a second or two, and its edge is timed against the
+// internal RTC's tick. The RTC is stepped by whole seconds to within half
+// a second of the DS3231, and src/calib.cpp trims its FREQCORR from the
+// drift, so measurements grow from minutes to days apart as it settles.
+// Square wave edges count as DS3231 INT wakeups.
+//------------------------------------------------------------------------------
+
+#ifndef RTC_TIME_H
+#define RTC_TIME_H
+
+#include <stdint.h>
+#include "RTClib.h"
+#include "calendar.h"
+#include "RTCZero.h"
+
+// Resync interval, seconds, if the DS3231 gives no square wave
+#define RTC_TIME_RESYNC     (3600)
+#define RTC_TIME_TICK_LATE  (1500)
+
+// Change flags returned by rtc_time_update()
+#define RTC_TIME_CHG_SEC    (0x01)
+#define RTC_TIME_CHG_MIN    (0x02)
+#define RTC_TIME_CHG_HOUR   (0x04)
+#define RTC_TIME_CHG_DAY    (0x08)
+#define RTC_TIME_CHG_ALL    (0x0F)
+#define RTC_TIME_ALARM      (0x10)
+#define RTC_TIME_CALIB      (0x20)  // calib_coef() changed; store it
+
+//==============================================================================
+// Reads the DS3231, seeds the internal RTC from it and starts the 1 Hz tick.
+// Takes over the internal RTC's alarm and interrupt callback, and puts the
+// DS3231 INT/SQW pin in interrupt mode with both alarms off. Talks to the
+// DS3231 through ext, so call it while the I2C queue is idle.
+//
+// param ext      DS3231 driver, already begun.
+// param in       Internal RTC driver, already begun.
+// param int_pin  Pin wired to DS3231 INT/SQW.
+// param now      System time in ms.
+//==============================================================================
+void rtc_time_begin(RTC_DS3231 *ext, RTCZero *in, uint8_t int_pin,
+  uint64_t now);
+
+//==============================================================================
+// Advances the cached time by any ticks taken since the last call and starts
+// a DS3231 read if a resync is due. Cheap when nothing happened.
+//
+// param now  System time in ms.
+// return  RTC_TIME_CHG_* flags for the fields that changed, plus
+//         RTC_TIME_ALARM if the DS3231 alarm fired and RTC_TIME_CALIB if
+//         the calibration changed. 0 if none.
+//==============================================================================
+uint8_t rtc_time_update(uint64_t now);
+
+//==============================================================================
+// Nonzero if a tick or the DS3231 alarm has come in that rtc_time_update()
+// has not taken yet. Cheap enough to call before every sleep.
+//==============================================================================
+uint8_t rtc_time_pending();
+
+//==============================================================================
+// Returns the cached wall-clock time, split into fields once per tick.
+//==============================================================================
+const cal_time_t &rtc_time_now();
+
+//==============================================================================
+// Returns the cached wall-clock time as Unix time.
+//==============================================================================
+uint32_t rtc_time_epoch();
+
+//==============================================================================
+// Sets the time on both clocks after the user edits it. The cached time
+// changes at once; the DS3231 write is queued.
+//
+// param epoch  New wall-clock time as Unix time, CAL_EPOCH_MIN to
+//              CAL_EPOCH_MAX.
+// param now    System time in ms.
+//==============================================================================
+void rtc_time_set(uint32_t epoch, uint64_t now);
+
+//==============================================================================
+// Takes the time from a reference, e.g. the phone. The DS3231's error
+// against it, to the ms, feeds its aging trim, and both clocks are set as
+// rtc_time_set() does to the reference's nearest second when that brings
+// the DS3231 more than CALIB_REF_SLACK closer.
+//
+// param epoch  Reference time as Unix time, CAL_EPOCH_MIN to CAL_EPOCH_MAX.
+// param ms     Milliseconds into that second, below 1000.
+// param now    System time in ms.
+//==============================================================================
+void rtc_time_sync(uint32_t epoch, uint16_t ms, uint64_t now);
+
+//==============================================================================
+// Makes the next rtc_time_update() measure against the DS3231.
+//==============================================================================
+void rtc_time_resync();
+
+//==============================================================================
+// Programs DS3231 Alarm1 to fire once at a date and time, replacing any
+// alarm already set.
+//
+// param when  Fire time as Unix time. Must be within the next month.
+//==============================================================================
+void rtc_time_set_alarm(uint32_t when);
+
+//==============================================================================
+// Disables DS3231 Alarm1.
+//==============================================================================
+void rtc_time_clear_alarm();
+
+#endif // RTC_TIME_H
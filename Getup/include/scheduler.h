@@ -0,0 +1,70 @@
+//------------------------------------------------------------------------------
+// Getup! Task Scheduler
+// Runs the periodic subsystem tasks from a min-heap ordered by next deadline,
+// so loop() only does work that is actually due.
+//------------------------------------------------------------------------------
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS     (16)
+#define SCHED_IDLE_FOREVER  (0xFFFFFFFF)
+
+//==============================================================================
+// Task body.
+//
+// param now  System time in ms at dispatch.
+//==============================================================================
+typedef void (*task_fn_t)(uint64_t now);
+
+//==============================================================================
+// Registers a task. The first run is due immediately.
+//
+// param id      Task id, below SCHED_MAX_TASKS. Ties run in id order.
+// param period  Time between runs in ms.
+// param fn      Task body.
+// param now     System time in ms.
+//==============================================================================
+void sched_add(uint8_t id, uint32_t period, task_fn_t fn, uint64_t now);
+
+//==============================================================================
+// Changes a task's period. The next deadline becomes last run + period; a
+// task changing its own period from its body is next due period after the
+// run it is in.
+//
+// param id      Task id.
+// param period  Time between runs in ms.
+//==============================================================================
+void sched_set_period(uint8_t id, uint32_t period);
+
+//==============================================================================
+// Returns a task's current period in ms.
+//==============================================================================
+uint32_t sched_period(uint8_t id);
+
+//==============================================================================
+// Makes a task due now, e.g. from an event that needs it handled early.
+//
+// param id  Task id.
+//==============================================================================
+void sched_trigger(uint8_t id);
+
+//==============================================================================
+// Runs every task whose deadline has passed, in deadline order.
+//
+// param now  System time in ms.
+// return  Time in ms until the next deadline, SCHED_IDLE_FOREVER if none.
+//==============================================================================
+uint32_t sched_run(uint64_t now);
+
+//==============================================================================
+// Time in ms until the next deadline without running anything.
+//
+// param now  System time in ms.
+// return  0 if a task is due, SCHED_IDLE_FOREVER if no tasks.
+//==============================================================================
+uint32_t sched_idle(uint64_t now);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+// Getup! Shake Classifier
+// Integer-only shake detector for 3-axis ADXL343 samples at 100 Hz. Gravity
+// is removed with a first-order high-pass filter; a shake needs both enough
+// |a|^2 energy over a sliding window and several direction reversals spaced
+// like a hand shake, so a single knock on the nightstand does not count.
+//------------------------------------------------------------------------------
+
+#ifndef SHAKE_H
+#define SHAKE_H
+
+#include <stdint.h>
+
+// Gravity tracker time constant as a shift, 2^5 samples (~0.5 Hz corner)
+#define SHAKE_HPF_SHIFT     (5)
+// Filtered samples are clamped so the energy sum cannot overflow
+#define SHAKE_HP_MAX        (4095)
+// Energy window in samples and threshold on the window's sum of |a|^2.
+// Samples are 3.9 mg/LSB; 102 LSB is ~0.4 g RMS.
+#define SHAKE_WINDOW        (32)
+#define SHAKE_ENERGY        (102L * 102L * SHAKE_WINDOW)
+// A reversal is a sign change on one axis beyond SHAKE_REV_LEVEL, at least
+// SHAKE_REV_GAP samples after that axis last reversed. SHAKE_REVERSALS of
+// them must fall within SHAKE_REV_SPAN samples.
+#define SHAKE_REV_LEVEL     (102)
+#define SHAKE_REV_GAP       (4)
+#define SHAKE_REVERSALS     (3)
+#define SHAKE_REV_SPAN      (100)
+
+//==============================================================================
+// Detector state. One per sample stream.
+//==============================================================================
+typedef struct {
+  int32_t gravity[3];                 // Q8 low-passed sample
+  uint32_t energy[SHAKE_WINDOW];
+  uint32_t energy_sum;
+  uint32_t reversal[SHAKE_REVERSALS]; // Sample index of the last few
+  uint32_t last_rev[3];
+  int8_t sign[3];
+  uint8_t head;
+  uint8_t rev_head;
+  uint8_t rev_count;
+  uint32_t index;
+} shake_t;
+
+//==============================================================================
+// Resets a detector. The next sample seeds the gravity estimate.
+//==============================================================================
+void shake_init(shake_t *s);
+
+//==============================================================================
+// Runs one sample through the detector.
+//
+// param s        Detector state.
+// param x, y, z  Raw sample, 3.9 mg/LSB.
+// return  1 while the recent samples look like a shake, else 0.
+//==============================================================================
+uint8_t shake_feed(shake_t *s, int16_t x, int16_t y, int16_t z);
+
+#endif // SHAKE_H
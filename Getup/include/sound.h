@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------------
+// Getup! Alarm Sounds
+// Plays looping note patterns on the buzzer with no CPU work per note. TCC0
+// generates the tone, with its period setting the pitch and its duty the
+// volume. TC4 times the notes, and on each TC4 overflow two DMA channels
+// load the next note's period and duty into the TCC0 buffers and its length
+// into TC4. The CPU only steps the volume ramp, a few times a minute, and
+// can stay halted in __WFI() while the alarm rings.
+//
+// The buzzer must be on a TCC0 output: D3 on the Zero (PA09, TCC0/WO[1]).
+//------------------------------------------------------------------------------
+
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <stdint.h>
+
+#define SOUND_MAX_NOTES     (16)
+#define SOUND_MAX_MS        (1398)  // Longest note TC4 can time
+
+// Volume ramp: starts at 1/SOUND_RAMP_STEPS and reaches full volume after
+// SOUND_RAMP_MS
+#define SOUND_RAMP_STEPS    (8)
+#define SOUND_RAMP_MS       (32000ul)
+
+typedef enum {
+  SOUND_BEEP,               // 440 Hz pips, the original alarm
+  SOUND_CHIRP,
+  SOUND_SIREN,
+  SOUND_MELODY,
+  NUM_SOUNDS
+} sound_t;
+
+//==============================================================================
+// One note of a pattern.
+//==============================================================================
+typedef struct {
+  uint16_t hz;              // Pitch, 0 for a rest
+  uint16_t ms;              // Length, up to SOUND_MAX_MS
+  uint8_t volume;           // Full-ramp volume, 255 is loudest
+} sound_note_t;
+
+//==============================================================================
+// Sets up the timers and DMA channels. The buzzer is silent until
+// sound_start().
+//
+// param pin  Buzzer pin.
+//==============================================================================
+void sound_begin(uint8_t pin);
+
+//==============================================================================
+// Starts a sound from the bottom of its volume ramp, replacing any that is
+// playing. It loops until sound_stop().
+//
+// param sound  SOUND_*. Out-of-range ids play SOUND_BEEP.
+// param now    Current time in ms.
+//==============================================================================
+void sound_start(uint8_t sound, uint64_t now);
+
+//==============================================================================
+// Silences the buzzer.
+//==============================================================================
+void sound_stop();
+
+//==============================================================================
+// Nonzero while a sound is playing.
+//==============================================================================
+uint8_t sound_playing();
+
+//==============================================================================
+// Steps the volume ramp. Only touches the note table when the ramp moves.
+//
+// param now  Current time in ms.
+//==============================================================================
+void sound_update(uint64_t now);
+
+#endif // SOUND_H
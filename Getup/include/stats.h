@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// Getup! Power and Bus Statistics
+// Always-on counters in one fixed RAM struct: per scheduler task runs, CPU
+// time and I2C traffic, interrupts and standby wakeups by source, time
+// halted and in standby, and on-time of the big loads. Each kind of cost
+// has a current weight, so the counters turn into an average current and a
+// mAh/day figure. The struct is sent as is over USB serial; see
+// tools/stats_decode.py.
+//
+// I2C is counted below Wire on the board: the SERCOM master calls are
+// wrapped at link time (-Wl,--wrap in platformio.ini), so traffic from every
+// driver library is seen. The I2C transaction queue bypasses Wire and calls
+// the hooks itself.
+//------------------------------------------------------------------------------
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "scheduler.h"
+
+#define STATS_MAGIC         (0x53505547)  // "GUPS"
+#define STATS_VERSION       (1)
+
+// One block per scheduler task id, plus one for everything outside a task
+#define STATS_BLOCKS        (SCHED_MAX_TASKS + 1)
+#define STATS_OTHER         (SCHED_MAX_TASKS)
+
+// Interrupt and wakeup sources
+#define STATS_WAKE_BUTTON   (0)
+#define STATS_WAKE_TICK     (1)   // RTCZero 1 Hz alarm
+#define STATS_WAKE_ALARM    (2)   // DS3231 INT
+#define STATS_WAKE_ACCEL    (3)
+#define STATS_WAKE_QI       (4)
+#define STATS_WAKE_BLE      (5)
+#define STATS_NUM_WAKE      (6)
+
+// Switched loads
+#define STATS_LOAD_BACKLIGHT  (0)
+#define STATS_LOAD_BUZZER     (1)
+#define STATS_NUM_LOADS       (2)
+
+// Nominal supply current of each state and load, uA, for a Zero at 3.3 V.
+// Replace with bench measurements of the actual unit when available.
+#define STATS_UA_ACTIVE     (4500)  // Core running at 48 MHz
+#define STATS_UA_IDLE       (2000)  // Core halted in __WFI()
+#define STATS_UA_STANDBY    (10)    // Standby, RTC on the 32 kHz crystal
+#define STATS_UA_BASE       (1500)  // DS3231, ADXL343, LCD logic, BLE idle
+#define STATS_UA_BACKLIGHT  (20000)
+#define STATS_UA_BUZZER     (25000)
+// Charge per I2C byte at 100 kHz through 4.7k pull-ups, nA*s
+#define STATS_NAS_I2C_BYTE  (32)
+
+//==============================================================================
+typedef struct {
+  uint32_t active_ua;
+  uint32_t idle_ua;
+  uint32_t standby_ua;
+  uint32_t base_ua;
+  uint32_t load_ua[STATS_NUM_LOADS];
+  uint32_t i2c_byte_nas;
+} stats_weights_t;
+
+//==============================================================================
+typedef struct {
+  uint64_t active_us;
+  uint32_t runs;
+  uint32_t max_us;          // Longest single run
+  uint32_t i2c_txn;
+  uint32_t i2c_bytes;
+} stats_block_t;
+
+//==============================================================================
+// Snapshot layout. Little-endian with natural alignment on both the board
+// and the host; the decoder relies on it.
+//==============================================================================
+typedef struct {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t num_blocks;
+  uint8_t num_wake;
+  uint8_t num_loads;
+  uint32_t wall_s;          // RTC time since reset
+  uint32_t awake_ms;        // SysTick time since reset; stops in standby
+  uint64_t idle_us;         // Halted in __WFI()
+  uint32_t standby_count;
+  uint32_t load_ms[STATS_NUM_LOADS];
+  uint32_t irqs[STATS_NUM_WAKE];
+  uint32_t wakeups[STATS_NUM_WAKE];  // First interrupt after each standby
+  stats_weights_t weights;
+  stats_block_t blocks[STATS_BLOCKS];
+} stats_t;
+
+//==============================================================================
+// Clears the counters.
+//
+// param epoch  Current time as Unix time.
+// param ms     Current SysTick time in ms.
+//==============================================================================
+void stats_reset(uint32_t epoch, uint32_t ms);
+
+//==============================================================================
+// Brings the time totals up to date and returns the counters.
+//
+// param epoch  Current time as Unix time.
+// param ms     Current SysTick time in ms.
+//==============================================================================
+const stats_t *stats_get(uint32_t epoch, uint32_t ms);
+
+//==============================================================================
+// Average supply current over the counted time from the weights.
+//
+// return  Average current in uA, 0 if no time has been counted.
+//==============================================================================
+uint32_t stats_avg_ua(const stats_t *s);
+
+//==============================================================================
+// Attributes CPU time and I2C traffic to a scheduler task until
+// stats_exit(). Called around every task by the scheduler.
+//==============================================================================
+void stats_enter(uint8_t id);
+void stats_exit();
+
+//==============================================================================
+// I2C hooks, called by the SERCOM wrappers (or the native Wire stand-in) and
+// by the I2C transaction queue.
+//==============================================================================
+void stats_i2c_txn();
+void stats_i2c_bytes(uint32_t n);
+
+//==============================================================================
+// Counts an interrupt. Safe from an ISR.
+//
+// param source  STATS_WAKE_*.
+//==============================================================================
+void stats_irq(uint8_t source);
+
+//==============================================================================
+// Adds time halted in __WFI().
+//==============================================================================
+void stats_idle(uint32_t us);
+
+//==============================================================================
+// Marks entry to standby. The next stats_irq() is counted as its wakeup.
+//==============================================================================
+void stats_standby();
+
+//==============================================================================
+// Adds on-time to a load.
+//
+// param load  STATS_LOAD_*.
+// param ms    Time it was on.
+//==============================================================================
+void stats_load(uint8_t load, uint32_t ms);
+
+#endif // STATS_H
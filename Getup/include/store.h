@@ -0,0 +1,47 @@
+//------------------------------------------------------------------------------
+// Getup! Settings Store
+// Log-structured key/value store in on-chip flash. Each change is appended
+// as one 8-byte record with a CRC, so an edit costs a single page write
+// instead of a row erase. The area is split into segments of two NVM rows;
+// when the current segment fills, the live values are compacted into the
+// next one, so erases rotate over the whole area. Boot reads the segment
+// headers and then only the newest segment.
+//------------------------------------------------------------------------------
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+
+// Keys are 0 to STORE_KEYS - 1
+#define STORE_KEYS          (40)
+
+// Two 256-byte NVM rows per segment, four segments
+#define STORE_SEGMENT       (512)
+#define STORE_SEGMENTS      (4)
+#define STORE_SIZE          (STORE_SEGMENT * STORE_SEGMENTS)
+
+//==============================================================================
+// Finds the newest segment and loads every value in it. Formats the area if
+// it holds no valid segment, as after a firmware upload.
+//==============================================================================
+void store_begin();
+
+//==============================================================================
+// Looks up a value.
+//
+// param key    Key.
+// param value  Set to the stored value if there is one.
+// return  1 if the key has been stored, else 0.
+//==============================================================================
+uint8_t store_get(uint8_t key, uint32_t *value);
+
+//==============================================================================
+// Stores a value. Nothing is written if it is already stored.
+//
+// param key    Key.
+// param value  New value.
+//==============================================================================
+void store_put(uint8_t key, uint32_t value);
+
+#endif // STORE_H
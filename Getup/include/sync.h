@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// Getup! Sync Protocol
+// Framed binary messages carried over the Bluefruit BLE UART service. A
+// frame is
+//
+//   SOF | type | seq | len | payload[len] | CRC-16 (LE, over type..payload)
+//
+// Requests carry a SYNC_* type. The reply to a request echoes its seq and has
+// SYNC_REPLY set in its type, or is a SYNC_NAK. A phone may send several
+// requests back to back; they are answered in order, so a whole sync (time,
+// every alarm, preferences, telemetry) fits in one exchange. Multi-byte
+// fields are little-endian. Alarms and preferences travel as their stored
+// 32-bit records.
+//------------------------------------------------------------------------------
+
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+
+#define SYNC_SOF            (0xA5)
+#define SYNC_VERSION        (2)
+#define SYNC_MAX_PAYLOAD    (160)
+#define SYNC_OVERHEAD       (6)
+#define SYNC_MAX_FRAME      (SYNC_MAX_PAYLOAD + SYNC_OVERHEAD)
+
+// Request types
+#define SYNC_HELLO          (0x01)  // -> version, alarm slots, sounds, flags
+#define SYNC_TIME_SET       (0x02)  // epoch u32 [, ms u16 since v2] ->
+#define SYNC_TIME_GET       (0x03)  // -> epoch u32
+#define SYNC_ALARMS_PUT     (0x04)  // first u8, count u8, alarm_t[count] ->
+#define SYNC_ALARMS_GET     (0x05)  // first u8, count u8 -> same as PUT
+#define SYNC_PREFS_PUT      (0x06)  // prefs u32 ->
+#define SYNC_PREFS_GET      (0x07)  // -> prefs u32
+#define SYNC_TELEMETRY      (0x08)  // -> sync_telemetry_t
+#define SYNC_NUM_TYPES      (0x09)
+
+#define SYNC_REPLY          (0x80)
+#define SYNC_NAK            (0x7F)  // type u8, error u8
+
+// NAK errors
+#define SYNC_ERR_TYPE       (1)     // Unknown request
+#define SYNC_ERR_LENGTH     (2)     // Payload the wrong size
+#define SYNC_ERR_RANGE      (3)     // Value out of range
+
+// Flags in sync_telemetry_t
+#define SYNC_TEL_LOW_BATT   (0x01)
+#define SYNC_TEL_CHARGING   (0x02)
+#define SYNC_TEL_RINGING    (0x04)
+
+//==============================================================================
+// SYNC_TELEMETRY reply.
+//==============================================================================
+typedef struct __attribute__((__packed__)) {
+  uint32_t epoch;
+  uint32_t uptime_s;        // RTC time since the stats were last reset
+  uint32_t avg_ua;          // Estimated average current
+  uint16_t batt_mv;
+  uint8_t batt_pct;
+  uint8_t flags;            // SYNC_TEL_*
+  uint8_t profile;          // GOV_*
+  uint8_t next_alarm;       // Alarm slot due next, ALARM_NONE if none
+} sync_telemetry_t;
+
+//==============================================================================
+// Receive state. Holds the last complete frame after sync_feed() returns
+// nonzero.
+//==============================================================================
+typedef struct {
+  uint8_t state;
+  uint8_t type;
+  uint8_t seq;
+  uint8_t len;
+  uint8_t pos;
+  uint16_t crc;
+  uint8_t payload[SYNC_MAX_PAYLOAD];
+  uint32_t errors;          // Frames dropped for bad length or CRC
+} sync_parser_t;
+
+//==============================================================================
+// Readies a parser to look for a start of frame.
+//==============================================================================
+void sync_reset(sync_parser_t *p);
+
+//==============================================================================
+// Feeds one received byte. Bytes outside a frame are skipped.
+//
+// return  Nonzero when a frame with a good CRC is complete in p.
+//==============================================================================
+uint8_t sync_feed(sync_parser_t *p, uint8_t byte);
+
+//==============================================================================
+// Builds a frame.
+//
+// param out      Buffer of at least len + SYNC_OVERHEAD bytes.
+// param type     Message type.
+// param seq      Sequence number.
+// param payload  Payload, may be null if len is 0.
+// param len      Payload length, up to SYNC_MAX_PAYLOAD.
+// return  Frame length.
+//==============================================================================
+uint16_t sync_frame(uint8_t *out, uint8_t type, uint8_t seq,
+  const void *payload, uint8_t len);
+
+#endif // SYNC_H
@@ -0,0 +1,44 @@
+//------------------------------------------------------------------------------
+// Getup! System Time
+// Monotonic 64-bit firmware time that keeps running through standby, for
+// every deadline and edge time stamp. SysTick, and millis() with it, stops
+// in standby, and the internal RTC belongs to RTCZero in calendar mode with
+// one-second resolution. So TC3 counts the 32.768 kHz crystal divided down
+// to SYSTIME_HZ, on a clock generator left running in standby, and its
+// overflow interrupt carries into a 32-bit high word: 48 bits in all, which
+// wrap after some 8700 years.
+//
+// Reads take no lock and never mask interrupts: the high word is read on
+// either side of the counter and the read is retried if the carry ISR ran
+// in between. A carry still pending, as seen from a higher-priority ISR or
+// with interrupts masked, is folded in from the overflow flag.
+//
+// The carry wakes the core from standby once every 65536 / SYSTIME_HZ
+// seconds; it does not count as a wake source in the stats.
+//------------------------------------------------------------------------------
+
+#ifndef SYSTIME_H
+#define SYSTIME_H
+
+#include <stdint.h>
+
+// Counter rate, Hz
+#define SYSTIME_HZ          (1024)
+
+//==============================================================================
+// Starts the counter from 0. Call once, before anything takes a time stamp.
+//==============================================================================
+void systime_begin();
+
+//==============================================================================
+// Counter ticks since systime_begin(), at SYSTIME_HZ. Safe from an ISR.
+//==============================================================================
+uint64_t systime_ticks();
+
+//==============================================================================
+// Time since systime_begin() in ms, to the counter's resolution of just
+// under 1 ms. Safe from an ISR.
+//==============================================================================
+uint64_t systime_ms();
+
+#endif // SYSTIME_H
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+// Getup! Event Trace
+// Fixed RAM ring of timestamped events at the points that set user-visible
+// latency: the DS3231 alarm interrupt, the alarm starting and stopping, the
+// buzzer, shakes, the charger, button edges and the display flush that
+// answers a button. Each record is a 32-bit micros() stamp, an event id and
+// a 16-bit argument. Logging is safe from an ISR and takes a few
+// instructions; once the ring is full the oldest events are overwritten.
+// The ring is sent as is over USB serial; see tools/trace_decode.py, which
+// pairs the events and prints latency histograms.
+//------------------------------------------------------------------------------
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_MAGIC         (0x54505547)  // "GUPT"
+#define TRACE_VERSION       (1)
+#define TRACE_DEPTH         (256)   // Events, a power of two
+
+// Event ids
+#define TRACE_ALARM_IRQ     (1)     // DS3231 INT fell
+#define TRACE_ALARM_RING    (2)     // Alarm started; arg alarm id, or
+                                    // TRACE_SNOOZE for the rearmed ring
+#define TRACE_ALARM_QUIET   (3)     // Alarm stopped; arg TRACE_BY_*
+#define TRACE_SOUND_START   (4)     // arg sound
+#define TRACE_SOUND_STOP    (5)
+#define TRACE_SHAKE         (6)     // Classifier found a shake
+#define TRACE_QI            (7)     // Charger changed; arg 1 if charging
+#define TRACE_BUTTON        (8)     // Debounced edge; arg button << 8 | type
+#define TRACE_LCD_FLUSH     (9)     // Display flush after a button; arg cells
+
+#define TRACE_SNOOZE        (0xFFFF)
+#define TRACE_BY_SHAKE      (0)
+#define TRACE_BY_CHARGER    (1)
+
+//==============================================================================
+typedef struct {
+  uint32_t us;              // micros() when logged
+  uint16_t arg;
+  uint8_t id;
+  uint8_t reserved;
+} trace_event_t;
+
+//==============================================================================
+// Dump layout. events[] is the ring as it stands: with count at or below
+// TRACE_DEPTH the events run from index 0, otherwise the oldest is at
+// count % TRACE_DEPTH. Little-endian on both the board and the host.
+//==============================================================================
+typedef struct {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t reserved;
+  uint16_t depth;
+  uint32_t count;           // Events logged since reset
+  trace_event_t events[TRACE_DEPTH];
+} trace_t;
+
+//==============================================================================
+// Empties the ring.
+//==============================================================================
+void trace_reset();
+
+//==============================================================================
+// Adds an event. Safe from an ISR.
+//
+// param id   TRACE_* event id.
+// param arg  Event argument.
+//==============================================================================
+void trace_log(uint8_t id, uint16_t arg);
+
+//==============================================================================
+// Returns the ring for dumping.
+//==============================================================================
+const trace_t *trace_get();
+
+#endif // TRACE_H
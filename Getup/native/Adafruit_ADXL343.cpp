@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_ADXL343 stand-in.
+//------------------------------------------------------------------------------
+
+#include "Adafruit_ADXL343.h"
+
+//==============================================================================
+Adafruit_ADXL343::Adafruit_ADXL343(int32_t sensorID) :
+  _wire(&Wire), _i2caddr(ADXL343_ADDRESS), _sensorID(sensorID) {
+}
+
+//==============================================================================
+Adafruit_ADXL343::Adafruit_ADXL343(int32_t sensorID, TwoWire *wireBus) :
+  _wire(wireBus), _i2caddr(ADXL343_ADDRESS), _sensorID(sensorID) {
+}
+
+//==============================================================================
+bool Adafruit_ADXL343::begin(uint8_t i2caddr) {
+  _i2caddr = i2caddr;
+  _wire->begin();
+  if(getDeviceID() != 0xE5) return false;
+  writeRegister(ADXL343_REG_POWER_CTL, 0x08);
+  return true;
+}
+
+//==============================================================================
+void Adafruit_ADXL343::setRange(adxl34x_range_t range) {
+  uint8_t format = readRegister(ADXL343_REG_DATA_FORMAT);
+  format &= ~0x0F;
+  format |= range;
+  format |= 0x08;
+  writeRegister(ADXL343_REG_DATA_FORMAT, format);
+}
+
+//==============================================================================
+adxl34x_range_t Adafruit_ADXL343::getRange(void) {
+  return (adxl34x_range_t)(readRegister(ADXL343_REG_DATA_FORMAT) & 0x03);
+}
+
+//==============================================================================
+void Adafruit_ADXL343::setDataRate(dataRate_t dataRate) {
+  writeRegister(ADXL343_REG_BW_RATE, dataRate);
+}
+
+//==============================================================================
+dataRate_t Adafruit_ADXL343::getDataRate(void) {
+  return (dataRate_t)(readRegister(ADXL343_REG_BW_RATE) & 0x0F);
+}
+
+//==============================================================================
+uint8_t Adafruit_ADXL343::getDeviceID(void) {
+  return readRegister(ADXL343_REG_DEVID);
+}
+
+//==============================================================================
+void Adafruit_ADXL343::writeRegister(uint8_t reg, uint8_t value) {
+  _wire->beginTransmission(_i2caddr);
+  _wire->write(reg);
+  _wire->write(value);
+  _wire->endTransmission();
+}
+
+//==============================================================================
+uint8_t Adafruit_ADXL343::readRegister(uint8_t reg) {
+  _wire->beginTransmission(_i2caddr);
+  _wire->write(reg);
+  _wire->endTransmission();
+  _wire->requestFrom(_i2caddr, (size_t)1);
+  return _wire->read();
+}
+
+//==============================================================================
+int16_t Adafruit_ADXL343::read16(uint8_t reg) {
+  uint8_t lo, hi;
+
+  _wire->beginTransmission(_i2caddr);
+  _wire->write(reg);
+  _wire->endTransmission();
+  _wire->requestFrom(_i2caddr, (size_t)2);
+  lo = _wire->read();
+  hi = _wire->read();
+  return (int16_t)(lo | (hi << 8));
+}
+
+//==============================================================================
+bool Adafruit_ADXL343::enableInterrupts(int_config cfg) {
+  writeRegister(ADXL343_REG_INT_ENABLE, cfg.value);
+  return true;
+}
+
+//==============================================================================
+bool Adafruit_ADXL343::mapInterrupts(int_config cfg) {
+  writeRegister(ADXL343_REG_INT_MAP, cfg.value);
+  return true;
+}
+
+//==============================================================================
+uint8_t Adafruit_ADXL343::checkInterrupts(void) {
+  return readRegister(ADXL343_REG_INT_SOURCE);
+}
+
+//==============================================================================
+int16_t Adafruit_ADXL343::getX(void) {
+  return read16(ADXL343_REG_DATAX0);
+}
+
+//==============================================================================
+int16_t Adafruit_ADXL343::getY(void) {
+  return read16(ADXL343_REG_DATAY0);
+}
+
+//==============================================================================
+int16_t Adafruit_ADXL343::getZ(void) {
+  return read16(ADXL343_REG_DATAZ0);
+}
+
+//==============================================================================
+bool Adafruit_ADXL343::getXYZ(int16_t &x, int16_t &y, int16_t &z) {
+  uint8_t buf[6];
+  uint8_t i;
+
+  _wire->beginTransmission(_i2caddr);
+  _wire->write((uint8_t)ADXL343_REG_DATAX0);
+  _wire->endTransmission();
+  if(_wire->requestFrom(_i2caddr, (size_t)6) != 6) return false;
+  for(i = 0; i < 6; i++) buf[i] = _wire->read();
+  x = (int16_t)(buf[0] | (buf[1] << 8));
+  y = (int16_t)(buf[2] | (buf[3] << 8));
+  z = (int16_t)(buf[4] | (buf[5] << 8));
+  return true;
+}
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_ADXL343 stand-in, I2C mode only.
+//------------------------------------------------------------------------------
+
+#ifndef ADAFRUIT_ADXL343_H
+#define ADAFRUIT_ADXL343_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define ADXL343_ADDRESS             (0x53)
+
+#define ADXL343_REG_DEVID           (0x00)
+#define ADXL343_REG_THRESH_TAP      (0x1D)
+#define ADXL343_REG_OFSX            (0x1E)
+#define ADXL343_REG_OFSY            (0x1F)
+#define ADXL343_REG_OFSZ            (0x20)
+#define ADXL343_REG_DUR             (0x21)
+#define ADXL343_REG_LATENT          (0x22)
+#define ADXL343_REG_WINDOW          (0x23)
+#define ADXL343_REG_THRESH_ACT      (0x24)
+#define ADXL343_REG_THRESH_INACT    (0x25)
+#define ADXL343_REG_TIME_INACT      (0x26)
+#define ADXL343_REG_ACT_INACT_CTL   (0x27)
+#define ADXL343_REG_THRESH_FF       (0x28)
+#define ADXL343_REG_TIME_FF         (0x29)
+#define ADXL343_REG_TAP_AXES        (0x2A)
+#define ADXL343_REG_ACT_TAP_STATUS  (0x2B)
+#define ADXL343_REG_BW_RATE         (0x2C)
+#define ADXL343_REG_POWER_CTL       (0x2D)
+#define ADXL343_REG_INT_ENABLE      (0x2E)
+#define ADXL343_REG_INT_MAP         (0x2F)
+#define ADXL343_REG_INT_SOURCE      (0x30)
+#define ADXL343_REG_DATA_FORMAT     (0x31)
+#define ADXL343_REG_DATAX0          (0x32)
+#define ADXL343_REG_DATAX1          (0x33)
+#define ADXL343_REG_DATAY0          (0x34)
+#define ADXL343_REG_DATAY1          (0x35)
+#define ADXL343_REG_DATAZ0          (0x36)
+#define ADXL343_REG_DATAZ1          (0x37)
+#define ADXL343_REG_FIFO_CTL        (0x38)
+#define ADXL343_REG_FIFO_STATUS     (0x39)
+
+typedef enum {
+  ADXL343_RANGE_16_G = 0x3,
+  ADXL343_RANGE_8_G = 0x2,
+  ADXL343_RANGE_4_G = 0x1,
+  ADXL343_RANGE_2_G = 0x0
+} adxl34x_range_t;
+
+typedef enum {
+  ADXL343_DATARATE_3200_HZ = 0xF,
+  ADXL343_DATARATE_1600_HZ = 0xE,
+  ADXL343_DATARATE_800_HZ = 0xD,
+  ADXL343_DATARATE_400_HZ = 0xC,
+  ADXL343_DATARATE_200_HZ = 0xB,
+  ADXL343_DATARATE_100_HZ = 0xA,
+  ADXL343_DATARATE_50_HZ = 0x9,
+  ADXL343_DATARATE_25_HZ = 0x8,
+  ADXL343_DATARATE_12_5_HZ = 0x7,
+  ADXL343_DATARATE_6_25HZ = 0x6,
+  ADXL343_DATARATE_3_13_HZ = 0x5,
+  ADXL343_DATARATE_1_56_HZ = 0x4,
+  ADXL343_DATARATE_0_78_HZ = 0x3,
+  ADXL343_DATARATE_0_39_HZ = 0x2,
+  ADXL343_DATARATE_0_20_HZ = 0x1,
+  ADXL343_DATARATE_0_10_HZ = 0x0
+} dataRate_t;
+
+union int_config {
+  uint8_t value;
+  struct {
+    uint8_t overrun : 1;
+    uint8_t watermark : 1;
+    uint8_t freefall : 1;
+    uint8_t inactivity : 1;
+    uint8_t activity : 1;
+    uint8_t double_tap : 1;
+    uint8_t single_tap : 1;
+    uint8_t data_ready : 1;
+  } bits;
+};
+
+//==============================================================================
+class Adafruit_ADXL343 {
+ public:
+  Adafruit_ADXL343(int32_t sensorID);
+  Adafruit_ADXL343(int32_t sensorID, TwoWire *wireBus);
+
+  bool begin(uint8_t i2caddr = ADXL343_ADDRESS);
+  void setRange(adxl34x_range_t range);
+  adxl34x_range_t getRange(void);
+  void setDataRate(dataRate_t dataRate);
+  dataRate_t getDataRate(void);
+  uint8_t getDeviceID(void);
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t readRegister(uint8_t reg);
+  int16_t read16(uint8_t reg);
+  bool enableInterrupts(int_config cfg);
+  bool mapInterrupts(int_config cfg);
+  uint8_t checkInterrupts(void);
+  int16_t getX(void);
+  int16_t getY(void);
+  int16_t getZ(void);
+  bool getXYZ(int16_t &x, int16_t &y, int16_t &z);
+
+ private:
+  TwoWire *_wire;
+  uint8_t _i2caddr;
+  int32_t _sensorID;
+};
+
+#endif // ADAFRUIT_ADXL343_H
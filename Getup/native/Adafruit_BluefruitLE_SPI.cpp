@@ -0,0 +1,216 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_BluefruitLE_SPI stand-in.
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "Adafruit_BluefruitLE_SPI.h"
+#include "sim.h"
+
+#define SDEP_PAYLOAD        (16)
+
+Adafruit_BluefruitLE_SPI *sim_ble = 0;
+
+//==============================================================================
+static void ble_event(void *ctx) {
+  ((Adafruit_BluefruitLE_SPI *)ctx)->sim_event();
+}
+
+//==============================================================================
+Adafruit_BluefruitLE_SPI::Adafruit_BluefruitLE_SPI(int8_t csPin,
+  int8_t irqPin, int8_t rstPin) :
+  cs(csPin), irq(irqPin), rst(rstPin), started(false), advertising(false),
+  connected(false), rx_count(0) {
+  memset(&stats, 0, sizeof(stats));
+  sim_ble = this;
+}
+
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::begin(bool v, bool blocking) {
+  (void)v;
+  (void)blocking;
+  started = true;
+  advertising = true;
+  schedule();
+  return true;
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::end() {
+  started = false;
+  advertising = false;
+  connected = false;
+  sim_cancel(ble_event, this);
+}
+
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::factoryReset(bool blocking) {
+  (void)blocking;
+  return sendCommandCheckOK("AT+FACTORYRESET");
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::echo(bool enable) {
+  (void)enable;
+}
+
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::setMode(uint8_t new_mode) {
+  (void)new_mode;
+  return started;
+}
+
+//==============================================================================
+// Understands the GAP commands the firmware uses; anything else just costs
+// a round trip.
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::sendCommandCheckOK(const char cmd[]) {
+  bool was_advertising = advertising;
+  bool was_connected = connected;
+
+  if(!started) return false;
+  sim_advance(SIM_BLE_AT_US);
+  stats.at_commands++;
+
+  if(!strcmp(cmd, "AT+GAPSTARTADV")) {
+    advertising = true;
+  }
+  else if(!strcmp(cmd, "AT+GAPSTOPADV")) {
+    advertising = false;
+  }
+  else if(!strcmp(cmd, "AT+GAPDISCONNECT")) {
+    connected = false;
+  }
+  if(advertising != was_advertising || connected != was_connected) schedule();
+  return true;
+}
+
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::isConnected() {
+  if(!started) return false;
+  sim_advance(SIM_BLE_AT_US);
+  stats.at_commands++;
+  return connected;
+}
+
+//==============================================================================
+// The IRQ line is low with nothing queued, so an empty poll costs nothing;
+// otherwise each SDEP message brings up to 16 bytes.
+//==============================================================================
+int Adafruit_BluefruitLE_SPI::available() {
+  return module_rx.size();
+}
+
+//==============================================================================
+int Adafruit_BluefruitLE_SPI::read() {
+  int c;
+
+  if(module_rx.empty()) return -1;
+  if(rx_count++ % SDEP_PAYLOAD == 0) sim_advance(SIM_BLE_SDEP_US);
+  c = module_rx.front();
+  module_rx.pop_front();
+  return c;
+}
+
+//==============================================================================
+size_t Adafruit_BluefruitLE_SPI::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+//==============================================================================
+size_t Adafruit_BluefruitLE_SPI::write(const uint8_t *buf, size_t len) {
+  if(!started) return 0;
+  sim_advance((len + SDEP_PAYLOAD - 1) / SDEP_PAYLOAD * SIM_BLE_SDEP_US);
+  module_tx.insert(module_tx.end(), buf, buf + len);
+  return len;
+}
+
+//==============================================================================
+bool Adafruit_BluefruitLE_SPI::sim_connect() {
+  if(!advertising || connected) return false;
+  connected = true;
+  schedule();
+  return true;
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::sim_disconnect() {
+  connected = false;
+  phone_tx.clear();
+  module_tx.clear();
+  schedule();
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::sim_phone_write(const uint8_t *buf,
+  size_t len) {
+  phone_tx.insert(phone_tx.end(), buf, buf + len);
+}
+
+//==============================================================================
+size_t Adafruit_BluefruitLE_SPI::sim_phone_read(uint8_t *buf, size_t len) {
+  size_t n = 0;
+
+  while(n < len && !phone_rx.empty()) {
+    buf[n++] = phone_rx.front();
+    phone_rx.pop_front();
+  }
+  return n;
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::sim_reset() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+//==============================================================================
+// One advertising or connection event.
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::sim_event() {
+  if(connected) {
+    stats.conn_events++;
+    stats.radio_us += SIM_BLE_CONN_EVENT_US;
+    move(phone_tx, module_rx);
+    move(module_tx, phone_rx);
+  }
+  else if(advertising) {
+    stats.adv_events++;
+    stats.radio_us += SIM_BLE_ADV_EVENT_US;
+  }
+  schedule();
+}
+
+//==============================================================================
+void Adafruit_BluefruitLE_SPI::schedule() {
+  if(connected) {
+    sim_at(sim_micros() + SIM_BLE_CONN_US, ble_event, this);
+  }
+  else if(advertising && started) {
+    sim_at(sim_micros() + SIM_BLE_ADV_US, ble_event, this);
+  }
+  else {
+    sim_cancel(ble_event, this);
+  }
+}
+
+//==============================================================================
+// Sends up to one event's worth of packets in one direction.
+//==============================================================================
+uint32_t Adafruit_BluefruitLE_SPI::move(std::deque<uint8_t> &from,
+  std::deque<uint8_t> &to) {
+  uint32_t packets = 0;
+  size_t n;
+
+  while(!from.empty() && packets < SIM_BLE_PACKETS_PER_EVENT) {
+    n = from.size() < SIM_BLE_ATT_PAYLOAD ? from.size() : SIM_BLE_ATT_PAYLOAD;
+    to.insert(to.end(), from.begin(), from.begin() + n);
+    from.erase(from.begin(), from.begin() + n);
+    packets++;
+    stats.packets++;
+    stats.payload_bytes += n;
+    stats.air_bytes += n + SIM_BLE_PDU_OVERHEAD;
+    stats.radio_us += (n + SIM_BLE_PDU_OVERHEAD) * SIM_BLE_US_PER_BYTE +
+      SIM_BLE_IFS_US;
+  }
+  return packets;
+}
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_BluefruitLE_SPI stand-in. Models the nRF51 module behind the SDEP
+// SPI link: advertising while started with AT+GAPSTARTADV, one phone that
+// the harness connects, and the BLE UART service between them. The radio is
+// costed on the virtual clock. Advertising events and connection events
+// each turn it on for a fixed time, and every packet adds its air time on
+// top. Bytes only move between the phone and the module on connection
+// events, up to SIM_BLE_PACKETS_PER_EVENT packets each way.
+//------------------------------------------------------------------------------
+
+#ifndef ADAFRUIT_BLUEFRUITLE_SPI_H
+#define ADAFRUIT_BLUEFRUITLE_SPI_H
+
+#include <deque>
+#include "Arduino.h"
+
+#define BLUEFRUIT_MODE_COMMAND  (1)
+#define BLUEFRUIT_MODE_DATA     (0)
+
+// Link parameters
+#define SIM_BLE_ADV_US          (100000)  // Advertising interval
+#define SIM_BLE_CONN_US         (30000)   // Connection interval
+#define SIM_BLE_ATT_PAYLOAD     (20)      // UART bytes per packet (MTU 23)
+#define SIM_BLE_PACKETS_PER_EVENT (4)
+
+// Radio cost model, 1 Mbit/s PHY
+#define SIM_BLE_US_PER_BYTE     (8)
+#define SIM_BLE_PDU_OVERHEAD    (17)      // LL 10, L2CAP 4, ATT 3 bytes
+#define SIM_BLE_ADV_EVENT_US    (1800)    // Three channels, PDU and listen
+#define SIM_BLE_CONN_EVENT_US   (600)     // Wake, empty PDU pair, T_IFS
+#define SIM_BLE_IFS_US          (150)
+
+// SDEP over SPI, per 16-byte message, and an AT command round trip
+#define SIM_BLE_SDEP_US         (60)
+#define SIM_BLE_AT_US           (5000)
+
+//==============================================================================
+// Radio counters. sim_reset() clears them.
+//==============================================================================
+typedef struct {
+  uint32_t adv_events;
+  uint32_t conn_events;
+  uint32_t packets;         // Data packets, both directions
+  uint32_t payload_bytes;   // UART bytes, both directions
+  uint32_t air_bytes;       // Including PDU overhead
+  uint64_t radio_us;        // Radio on
+  uint32_t at_commands;
+} sim_ble_stats_t;
+
+//==============================================================================
+class Adafruit_BluefruitLE_SPI : public Print {
+ public:
+  Adafruit_BluefruitLE_SPI(int8_t csPin, int8_t irqPin, int8_t rstPin = -1);
+
+  bool begin(bool v = false, bool blocking = true);
+  void end();
+  bool factoryReset(bool blocking = true);
+  void echo(bool enable);
+  bool setMode(uint8_t new_mode);
+  bool sendCommandCheckOK(const char cmd[]);
+  bool isConnected();
+
+  int available();
+  int read();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  using Print::write;
+
+  // Harness side. The phone can only connect while the module advertises.
+  bool sim_connect();
+  void sim_disconnect();
+  bool sim_advertising() { return advertising; }
+  bool sim_connected() { return connected; }
+  void sim_phone_write(const uint8_t *buf, size_t len);
+  size_t sim_phone_read(uint8_t *buf, size_t len);
+  const sim_ble_stats_t *sim_stats() { return &stats; }
+  void sim_reset();
+  void sim_event();
+
+ private:
+  void schedule();
+  uint32_t move(std::deque<uint8_t> &from, std::deque<uint8_t> &to);
+
+  int8_t cs;
+  int8_t irq;
+  int8_t rst;
+  bool started;
+  bool advertising;
+  bool connected;
+  uint32_t rx_count;
+  std::deque<uint8_t> phone_tx;   // Phone to module, not yet sent
+  std::deque<uint8_t> module_rx;  // Arrived, waiting for read()
+  std::deque<uint8_t> module_tx;  // Written, not yet sent
+  std::deque<uint8_t> phone_rx;   // Arrived at the phone
+  sim_ble_stats_t stats;
+};
+
+// The instance the firmware constructed, for the harness.
+extern Adafruit_BluefruitLE_SPI *sim_ble;
+
+#endif // ADAFRUIT_BLUEFRUITLE_SPI_H
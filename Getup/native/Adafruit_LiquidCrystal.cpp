@@ -0,0 +1,200 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_LiquidCrystal stand-in.
+//------------------------------------------------------------------------------
+
+#include "Adafruit_LiquidCrystal.h"
+
+//==============================================================================
+Adafruit_LiquidCrystal::Adafruit_LiquidCrystal(uint8_t i2cAddr) :
+  _rs_pin(1), _enable_pin(2), _displayfunction(0), _displaycontrol(0),
+  _displaymode(0), _numlines(1), _i2cAddr(i2cAddr) {
+  _data_pins[0] = 3;
+  _data_pins[1] = 4;
+  _data_pins[2] = 5;
+  _data_pins[3] = 6;
+  _displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+}
+
+//==============================================================================
+bool Adafruit_LiquidCrystal::begin(uint8_t cols, uint8_t lines,
+  uint8_t dotsize) {
+  uint8_t i;
+
+  (void)cols;
+  _i2c.begin(_i2cAddr);
+  _i2c.pinMode(7, OUTPUT);
+  _i2c.digitalWrite(7, HIGH);
+  for(i = 0; i < 4; i++) _pinMode(_data_pins[i], OUTPUT);
+  _i2c.pinMode(_rs_pin, OUTPUT);
+  _i2c.pinMode(_enable_pin, OUTPUT);
+
+  if(lines > 1) _displayfunction |= LCD_2LINE;
+  _numlines = lines;
+  if((dotsize != 0) && (lines == 1)) _displayfunction |= LCD_5x10DOTS;
+
+  delayMicroseconds(50000);
+  _digitalWrite(_rs_pin, LOW);
+  _digitalWrite(_enable_pin, LOW);
+
+  write4bits(0x03);
+  delayMicroseconds(4500);
+  write4bits(0x03);
+  delayMicroseconds(4500);
+  write4bits(0x03);
+  delayMicroseconds(150);
+  write4bits(0x02);
+
+  command(LCD_FUNCTIONSET | _displayfunction);
+  _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+  display();
+  clear();
+  _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+  command(LCD_ENTRYMODESET | _displaymode);
+  return true;
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::clear() {
+  command(LCD_CLEARDISPLAY);
+  delayMicroseconds(2000);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::home() {
+  command(LCD_RETURNHOME);
+  delayMicroseconds(2000);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::setCursor(uint8_t col, uint8_t row) {
+  static const int row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+  if(row > _numlines) row = _numlines - 1;
+  command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::noDisplay() {
+  _displaycontrol &= ~LCD_DISPLAYON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void Adafruit_LiquidCrystal::display() {
+  _displaycontrol |= LCD_DISPLAYON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void Adafruit_LiquidCrystal::noCursor() {
+  _displaycontrol &= ~LCD_CURSORON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void Adafruit_LiquidCrystal::cursor() {
+  _displaycontrol |= LCD_CURSORON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void Adafruit_LiquidCrystal::noBlink() {
+  _displaycontrol &= ~LCD_BLINKON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void Adafruit_LiquidCrystal::blink() {
+  _displaycontrol |= LCD_BLINKON;
+  command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::scrollDisplayLeft() {
+  command(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
+}
+void Adafruit_LiquidCrystal::scrollDisplayRight() {
+  command(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::leftToRight() {
+  _displaymode |= LCD_ENTRYLEFT;
+  command(LCD_ENTRYMODESET | _displaymode);
+}
+void Adafruit_LiquidCrystal::rightToLeft() {
+  _displaymode &= ~LCD_ENTRYLEFT;
+  command(LCD_ENTRYMODESET | _displaymode);
+}
+void Adafruit_LiquidCrystal::autoscroll() {
+  _displaymode |= LCD_ENTRYSHIFTINCREMENT;
+  command(LCD_ENTRYMODESET | _displaymode);
+}
+void Adafruit_LiquidCrystal::noAutoscroll() {
+  _displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
+  command(LCD_ENTRYMODESET | _displaymode);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::createChar(uint8_t location, uint8_t charmap[]) {
+  uint8_t i;
+
+  location &= 0x7;
+  command(LCD_SETCGRAMADDR | (location << 3));
+  for(i = 0; i < 8; i++) write(charmap[i]);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::setBacklight(uint8_t status) {
+  _i2c.digitalWrite(7, status);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::command(uint8_t value) {
+  send(value, LOW);
+}
+
+//==============================================================================
+size_t Adafruit_LiquidCrystal::write(uint8_t value) {
+  send(value, HIGH);
+  return 1;
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::send(uint8_t value, boolean mode) {
+  _digitalWrite(_rs_pin, mode);
+  write4bits(value >> 4);
+  write4bits(value);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::write4bits(uint8_t value) {
+  uint8_t out = _i2c.readGPIO();
+  uint8_t i;
+
+  for(i = 0; i < 4; i++) {
+    out &= ~(1 << _data_pins[i]);
+    out |= ((value >> i) & 0x1) << _data_pins[i];
+  }
+
+  out &= ~(1 << _enable_pin);
+  _i2c.writeGPIO(out);
+
+  delayMicroseconds(1);
+  out |= (1 << _enable_pin);
+  _i2c.writeGPIO(out);
+  delayMicroseconds(1);
+  out &= ~(1 << _enable_pin);
+  _i2c.writeGPIO(out);
+  delayMicroseconds(100);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::pulseEnable() {
+  _digitalWrite(_enable_pin, LOW);
+  delayMicroseconds(1);
+  _digitalWrite(_enable_pin, HIGH);
+  delayMicroseconds(1);
+  _digitalWrite(_enable_pin, LOW);
+  delayMicroseconds(100);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::_digitalWrite(uint8_t p, uint8_t d) {
+  _i2c.digitalWrite(p, d);
+}
+
+//==============================================================================
+void Adafruit_LiquidCrystal::_pinMode(uint8_t p, uint8_t d) {
+  _i2c.pinMode(p, d);
+}
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_LiquidCrystal stand-in, I2C backpack mode only. Drives the
+// HD44780 through Adafruit_MCP23008 exactly as the library does, so the bus
+// cost of each print() is the real one.
+//------------------------------------------------------------------------------
+
+#ifndef ADAFRUIT_LIQUIDCRYSTAL_H
+#define ADAFRUIT_LIQUIDCRYSTAL_H
+
+#include "Arduino.h"
+#include "utility/Adafruit_MCP23008.h"
+
+#define LCD_CLEARDISPLAY    (0x01)
+#define LCD_RETURNHOME      (0x02)
+#define LCD_ENTRYMODESET    (0x04)
+#define LCD_DISPLAYCONTROL  (0x08)
+#define LCD_CURSORSHIFT     (0x10)
+#define LCD_FUNCTIONSET     (0x20)
+#define LCD_SETCGRAMADDR    (0x40)
+#define LCD_SETDDRAMADDR    (0x80)
+
+#define LCD_ENTRYRIGHT      (0x00)
+#define LCD_ENTRYLEFT       (0x02)
+#define LCD_ENTRYSHIFTINCREMENT (0x01)
+#define LCD_ENTRYSHIFTDECREMENT (0x00)
+
+#define LCD_DISPLAYON       (0x04)
+#define LCD_DISPLAYOFF      (0x00)
+#define LCD_CURSORON        (0x02)
+#define LCD_CURSOROFF       (0x00)
+#define LCD_BLINKON         (0x01)
+#define LCD_BLINKOFF        (0x00)
+
+#define LCD_DISPLAYMOVE     (0x08)
+#define LCD_CURSORMOVE      (0x00)
+#define LCD_MOVERIGHT       (0x04)
+#define LCD_MOVELEFT        (0x00)
+
+#define LCD_8BITMODE        (0x10)
+#define LCD_4BITMODE        (0x00)
+#define LCD_2LINE           (0x08)
+#define LCD_1LINE           (0x00)
+#define LCD_5x10DOTS        (0x04)
+#define LCD_5x8DOTS         (0x00)
+
+//==============================================================================
+class Adafruit_LiquidCrystal : public Print {
+ public:
+  Adafruit_LiquidCrystal(uint8_t i2cAddr);
+
+  bool begin(uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
+  void clear();
+  void home();
+  void noDisplay();
+  void display();
+  void noBlink();
+  void blink();
+  void noCursor();
+  void cursor();
+  void scrollDisplayLeft();
+  void scrollDisplayRight();
+  void leftToRight();
+  void rightToLeft();
+  void autoscroll();
+  void noAutoscroll();
+  void setBacklight(uint8_t status);
+  void createChar(uint8_t location, uint8_t charmap[]);
+  void setCursor(uint8_t col, uint8_t row);
+  virtual size_t write(uint8_t value);
+  using Print::write;
+  void command(uint8_t value);
+
+ private:
+  void send(uint8_t value, boolean mode);
+  void write4bits(uint8_t value);
+  void pulseEnable();
+  void _digitalWrite(uint8_t p, uint8_t d);
+  void _pinMode(uint8_t p, uint8_t d);
+
+  uint8_t _rs_pin;
+  uint8_t _enable_pin;
+  uint8_t _data_pins[4];
+  uint8_t _displayfunction;
+  uint8_t _displaycontrol;
+  uint8_t _displaymode;
+  uint8_t _numlines;
+  uint8_t _i2cAddr;
+  Adafruit_MCP23008 _i2c;
+};
+
+#endif // ADAFRUIT_LIQUIDCRYSTAL_H
@@ -0,0 +1,30 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit SleepyDog stand-in. The watchdog never bites on the host.
+//------------------------------------------------------------------------------
+
+#ifndef ADAFRUIT_SLEEPYDOG_H
+#define ADAFRUIT_SLEEPYDOG_H
+
+#include "Arduino.h"
+#include "sim.h"
+
+//==============================================================================
+class WatchdogSAMD {
+ public:
+  int enable(int maxPeriodMS = 0, bool isForSleep = false) {
+    (void)isForSleep;
+    return maxPeriodMS;
+  }
+  void reset() {}
+  void disable() {}
+  int sleep(int maxPeriodMS = 0) {
+    sim_advance((uint64_t)maxPeriodMS * 1000);
+    return maxPeriodMS;
+  }
+};
+
+typedef WatchdogSAMD WatchdogType;
+extern WatchdogType Watchdog;
+
+#endif // ADAFRUIT_SLEEPYDOG_H
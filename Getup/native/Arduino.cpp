@@ -0,0 +1,308 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Arduino core stand-in.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "Arduino.h"
+#include "sim.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SERIAL_BUF_SIZE     (4096)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+SimSerial Serial;
+
+static uint16_t analog[SIM_NUM_PINS];
+static int analog_bits = 10;
+static uint32_t tone_count = 0;
+static unsigned int tone_freq = 0;
+
+static uint8_t serial_in[SERIAL_BUF_SIZE];
+static uint8_t serial_out[SERIAL_BUF_SIZE];
+static size_t serial_in_head = 0;
+static size_t serial_in_tail = 0;
+static size_t serial_out_len = 0;
+static bool serial_echo = false;
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+unsigned long millis() {
+  return (unsigned long)(sim_systick_us() / 1000);
+}
+
+//==============================================================================
+unsigned long micros() {
+  return (unsigned long)sim_systick_us();
+}
+
+//==============================================================================
+void delay(unsigned long ms) {
+  sim_advance((uint64_t)ms * 1000);
+}
+
+//==============================================================================
+void delayMicroseconds(unsigned int us) {
+  sim_advance(us);
+}
+
+//==============================================================================
+void pinMode(uint32_t pin, uint32_t mode) {
+  if(mode == INPUT_PULLUP) sim_pin_set(pin, HIGH);
+}
+
+//==============================================================================
+void digitalWrite(uint32_t pin, uint32_t value) {
+  sim_pin_set(pin, value);
+}
+
+//==============================================================================
+int digitalRead(uint32_t pin) {
+  return sim_pin_get(pin);
+}
+
+//==============================================================================
+int analogRead(uint32_t pin) {
+  uint16_t value = pin < SIM_NUM_PINS ? analog[pin] : 0;
+  sim_advance(20);
+  return analog_bits >= 12 ? value << (analog_bits - 12) :
+    value >> (12 - analog_bits);
+}
+
+//==============================================================================
+void analogReadResolution(int bits) {
+  analog_bits = bits;
+}
+
+//==============================================================================
+void analogWrite(uint32_t pin, int value) {
+  sim_pin_set(pin, value ? HIGH : LOW);
+}
+
+//==============================================================================
+void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode) {
+  sim_pin_attach(pin, callback, mode);
+}
+
+//==============================================================================
+void detachInterrupt(uint32_t pin) {
+  sim_pin_attach(pin, 0, 0);
+}
+
+//==============================================================================
+void tone(uint32_t pin, unsigned int frequency, unsigned long duration) {
+  (void)pin;
+  (void)duration;
+  tone_count++;
+  tone_freq = frequency;
+}
+
+//==============================================================================
+void noTone(uint32_t pin) {
+  (void)pin;
+  tone_freq = 0;
+}
+
+//==============================================================================
+void sim_analog_set(uint8_t pin, uint16_t value) {
+  if(pin < SIM_NUM_PINS) analog[pin] = value & 0x0FFF;
+}
+
+//==============================================================================
+uint32_t sim_tone_count() {
+  return tone_count;
+}
+
+//==============================================================================
+unsigned int sim_tone_frequency() {
+  return tone_freq;
+}
+
+//------------------------------------------------------------------------------
+//      __   __         ___
+//     |__) |__) | |\ |  |
+//     |    |  \ | | \|  |
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+size_t Print::write(const uint8_t *buf, size_t len) {
+  size_t n = 0;
+  while(len--) n += write(*buf++);
+  return n;
+}
+
+//==============================================================================
+size_t Print::write(const char *str) {
+  return str ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+//==============================================================================
+size_t Print::print(const char *str) {
+  return write(str);
+}
+
+//==============================================================================
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+//==============================================================================
+size_t Print::print(long n, int base) {
+  char buf[24];
+  if(base == HEX) snprintf(buf, sizeof(buf), "%lX", n);
+  else snprintf(buf, sizeof(buf), "%ld", n);
+  return write(buf);
+}
+
+//==============================================================================
+size_t Print::print(int n, int base) {
+  return print((long)n, base);
+}
+
+//==============================================================================
+size_t Print::print(unsigned long n, int base) {
+  char buf[24];
+  if(base == HEX) snprintf(buf, sizeof(buf), "%lX", n);
+  else snprintf(buf, sizeof(buf), "%lu", n);
+  return write(buf);
+}
+
+//==============================================================================
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+//==============================================================================
+size_t Print::print(double n, int digits) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+//==============================================================================
+size_t Print::println() {
+  return write("\r\n");
+}
+
+//==============================================================================
+size_t Print::println(const char *str) {
+  return print(str) + println();
+}
+
+//==============================================================================
+size_t Print::println(long n, int base) {
+  return print(n, base) + println();
+}
+
+//==============================================================================
+size_t Print::println(int n, int base) {
+  return print(n, base) + println();
+}
+
+//==============================================================================
+size_t Print::println(unsigned long n, int base) {
+  return print(n, base) + println();
+}
+
+//==============================================================================
+size_t Print::println(unsigned int n, int base) {
+  return print(n, base) + println();
+}
+
+//==============================================================================
+size_t Print::println(double n, int digits) {
+  return print(n, digits) + println();
+}
+
+//------------------------------------------------------------------------------
+//      __   ___  __
+//     /__` |__  |__) |  /\  |
+//     .__/ |___ |  \ | /~~\ |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void SimSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+//==============================================================================
+int SimSerial::available() {
+  return (int)(serial_in_head - serial_in_tail);
+}
+
+//==============================================================================
+int SimSerial::read() {
+  if(serial_in_tail == serial_in_head) return -1;
+  return serial_in[serial_in_tail++ % SERIAL_BUF_SIZE];
+}
+
+//==============================================================================
+int SimSerial::peek() {
+  if(serial_in_tail == serial_in_head) return -1;
+  return serial_in[serial_in_tail % SERIAL_BUF_SIZE];
+}
+
+//==============================================================================
+void SimSerial::flush() {
+}
+
+//==============================================================================
+size_t SimSerial::write(uint8_t c) {
+  if(serial_echo) fputc(c, stdout);
+  if(serial_out_len < SERIAL_BUF_SIZE) serial_out[serial_out_len++] = c;
+  return 1;
+}
+
+//==============================================================================
+size_t SimSerial::write(const uint8_t *buf, size_t len) {
+  size_t n = 0;
+  while(len--) n += write(*buf++);
+  return n;
+}
+
+//==============================================================================
+void SimSerial::inject(const uint8_t *buf, size_t len) {
+  while(len-- && (serial_in_head - serial_in_tail) < SERIAL_BUF_SIZE) {
+    serial_in[serial_in_head++ % SERIAL_BUF_SIZE] = *buf++;
+  }
+}
+
+//==============================================================================
+size_t SimSerial::drain(uint8_t *buf, size_t len) {
+  size_t n = len < serial_out_len ? len : serial_out_len;
+  memcpy(buf, serial_out, n);
+  memmove(serial_out, serial_out + n, serial_out_len - n);
+  serial_out_len -= n;
+  return n;
+}
+
+//==============================================================================
+void SimSerial::echo(bool on) {
+  serial_echo = on;
+}
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Arduino core stand-in. Time, pins and interrupts are backed by sim.h.
+//------------------------------------------------------------------------------
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define LOW                 (0x0)
+#define HIGH                (0x1)
+#define CHANGE              (2)
+#define FALLING             (3)
+#define RISING              (4)
+
+#define INPUT               (0x0)
+#define OUTPUT              (0x1)
+#define INPUT_PULLUP        (0x2)
+#define INPUT_PULLDOWN      (0x3)
+
+#define DEC                 (10)
+#define HEX                 (16)
+
+// Arduino Zero analog pin numbering
+#define A0                  (14)
+#define A1                  (15)
+#define A2                  (16)
+#define A3                  (17)
+#define A4                  (18)
+#define A5                  (19)
+
+#define NOT_AN_INTERRUPT    (-1)
+#define digitalPinToInterrupt(p)  (p)
+
+#define PROGMEM
+#define PSTR(s)             (s)
+#define F(s)                (s)
+#define sprintf_P           sprintf
+#define snprintf_P          snprintf
+#define strcpy_P            strcpy
+#define memcpy_P            memcpy
+#define pgm_read_byte(a)    (*(const uint8_t *)(a))
+#define pgm_read_word(a)    (*(const uint16_t *)(a))
+#define pgm_read_dword(a)   (*(const uint32_t *)(a))
+#define pgm_read_ptr(a)     (*(void * const *)(a))
+
+#define noInterrupts()
+#define interrupts()
+#define __WFI()             sim_wfi()
+#define __disable_irq()
+#define __enable_irq()
+#define __get_PRIMASK()     (0)
+#define __set_PRIMASK(m)    ((void)(m))
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef void (*voidFuncPtr)(void);
+typedef bool boolean;
+typedef uint8_t byte;
+
+//==============================================================================
+// Minimal Print base shared by Serial and the LCD driver.
+//==============================================================================
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t len);
+  size_t write(const char *str);
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(long n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(double n, int digits = 2);
+  size_t println();
+  size_t println(const char *str);
+  size_t println(long n, int base = DEC);
+  size_t println(int n, int base = DEC);
+  size_t println(unsigned long n, int base = DEC);
+  size_t println(unsigned int n, int base = DEC);
+  size_t println(double n, int digits = 2);
+};
+
+//==============================================================================
+// USB serial. Output is buffered for the harness, input is injected by it.
+//==============================================================================
+class SimSerial : public Print {
+ public:
+  void begin(unsigned long baud);
+  int available();
+  int read();
+  int peek();
+  void flush();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  using Print::write;
+  operator bool() { return true; }
+
+  // Harness side.
+  void inject(const uint8_t *buf, size_t len);
+  size_t drain(uint8_t *buf, size_t len);
+  void echo(bool on);
+};
+
+extern SimSerial Serial;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+int analogRead(uint32_t pin);
+void analogReadResolution(int bits);
+void analogWrite(uint32_t pin, int value);
+
+void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode);
+void detachInterrupt(uint32_t pin);
+
+void tone(uint32_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint32_t pin);
+
+//==============================================================================
+// Harness side of the analog and tone stand-ins.
+//==============================================================================
+void sim_analog_set(uint8_t pin, uint16_t value);
+uint32_t sim_tone_count();
+unsigned int sim_tone_frequency();
+
+#endif // ARDUINO_H
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// FlashStorage stand-in.
+//------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+#include "FlashStorage.h"
+#include "sim.h"
+
+#define ROWS(size)          (((size) + SIM_FLASH_ROW - 1) / SIM_FLASH_ROW)
+
+//==============================================================================
+FlashClass::FlashClass(const void *flash_addr, uint32_t size) :
+  flash_address(flash_addr), flash_size(ROWS(size) * SIM_FLASH_ROW) {
+  // The upload programs the region with its zero initializer.
+  mem = (uint8_t *)calloc(flash_size ? flash_size : 1, 1);
+  erases = (uint32_t *)calloc(ROWS(flash_size) + 1, sizeof(uint32_t));
+  memset(&sim_stats, 0, sizeof(sim_stats));
+}
+
+//==============================================================================
+FlashClass::~FlashClass() {
+  free(mem);
+  free(erases);
+}
+
+//==============================================================================
+void FlashClass::write(const volatile void *flash_ptr, const void *data,
+  uint32_t size) {
+  uint8_t *dst = shadow(flash_ptr);
+  const uint8_t *src = (const uint8_t *)data;
+  uint32_t n;
+
+  // Whole words, one page write per page buffer load as the library does.
+  size = (size + 3) & ~3u;
+  for(n = 0; n < size; n++) {
+    dst[n] &= src[n];
+    if(n % SIM_FLASH_PAGE == 0) {
+      sim_stats.page_writes++;
+      sim_advance(SIM_FLASH_WRITE_US);
+    }
+  }
+}
+
+//==============================================================================
+void FlashClass::erase(const volatile void *flash_ptr, uint32_t size) {
+  uint32_t row = (shadow(flash_ptr) - mem) / SIM_FLASH_ROW;
+  uint32_t end = row + (size ? ROWS(size) : 1);
+
+  for(; row < end && row < ROWS(flash_size); row++) {
+    memset(mem + row * SIM_FLASH_ROW, 0xFF, SIM_FLASH_ROW);
+    erases[row]++;
+    sim_stats.row_erases++;
+    if(erases[row] > sim_stats.max_row_erases) {
+      sim_stats.max_row_erases = erases[row];
+    }
+    sim_advance(SIM_FLASH_ERASE_US);
+  }
+}
+
+//==============================================================================
+void FlashClass::read(const volatile void *flash_ptr, void *data,
+  uint32_t size) {
+  memcpy(data, shadow(flash_ptr), size);
+}
+
+//==============================================================================
+void FlashClass::sim_reset_stats() {
+  memset(&sim_stats, 0, sizeof(sim_stats));
+  memset(erases, 0, ROWS(flash_size) * sizeof(uint32_t));
+}
+
+//==============================================================================
+uint8_t *FlashClass::shadow(const volatile void *flash_ptr) {
+  return mem + ((const volatile uint8_t *)flash_ptr -
+    (const volatile uint8_t *)flash_address);
+}
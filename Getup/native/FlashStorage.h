@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// FlashStorage stand-in. Each FlashClass shadows its region in host memory
+// with SAMD21 NVM rules: a freshly uploaded region reads as zeros, erase
+// works on whole 256-byte rows and sets them to 0xFF, and a write can only
+// clear bits. Erases and page writes are charged to the virtual clock and
+// counted per row so wear can be checked.
+//------------------------------------------------------------------------------
+
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include <stdint.h>
+
+#define SIM_FLASH_PAGE      (64)
+#define SIM_FLASH_ROW       (256)
+// Typical SAMD21 row erase and page write times
+#define SIM_FLASH_ERASE_US  (6000)
+#define SIM_FLASH_WRITE_US  (2500)
+
+//==============================================================================
+typedef struct {
+  uint32_t page_writes;
+  uint32_t row_erases;
+  uint32_t max_row_erases;
+} sim_flash_stats_t;
+
+//==============================================================================
+class FlashClass {
+ public:
+  FlashClass(const void *flash_addr = 0, uint32_t size = 0);
+  ~FlashClass();
+
+  void write(const void *data) { write(flash_address, data, flash_size); }
+  void erase()                 { erase(flash_address, flash_size); }
+  void read(void *data)        { read(flash_address, data, flash_size); }
+
+  void write(const volatile void *flash_ptr, const void *data, uint32_t size);
+  void erase(const volatile void *flash_ptr, uint32_t size);
+  void read(const volatile void *flash_ptr, void *data, uint32_t size);
+
+  // Simulator access
+  const sim_flash_stats_t *stats() const { return &sim_stats; }
+  void sim_reset_stats();
+
+ private:
+  uint8_t *shadow(const volatile void *flash_ptr);
+
+  const volatile void *flash_address;
+  const uint32_t flash_size;
+  uint8_t *mem;
+  uint32_t *erases;
+  sim_flash_stats_t sim_stats;
+};
+
+#define Flash(name, size) \
+  __attribute__((__aligned__(256))) \
+  static const uint8_t _data##name[(size + 255) / 256 * 256] = { }; \
+  FlashClass name(_data##name, size);
+
+#endif // FLASH_STORAGE_H
@@ -0,0 +1,295 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// RTCZero stand-in.
+//------------------------------------------------------------------------------
+
+#include "RTCZero.h"
+#include "RTClib.h"
+#include "sim.h"
+
+#define SECONDS_FROM_1970_TO_2000_U   (946684800UL)
+
+RTCZero *sim_rtc_zero = 0;
+
+//==============================================================================
+static void rtc_zero_event(void *ctx) {
+  ((RTCZero *)ctx)->sim_fire();
+}
+
+//==============================================================================
+RTCZero::RTCZero() :
+  _configured(false), base_y2k(0), base_us(0), base_frac(0), drift_ppb(0),
+  freqcorr(0), match(MATCH_OFF), callback(0) {
+  memset(&alarm, 0, sizeof(alarm));
+}
+
+//==============================================================================
+void RTCZero::begin(bool resetTime) {
+  if(resetTime || !_configured) {
+    base_y2k = 0;
+    base_us = sim_micros();
+    base_frac = 0;
+  }
+  _configured = true;
+  sim_rtc_zero = this;
+}
+
+//==============================================================================
+void RTCZero::enableAlarm(Alarm_Match m) {
+  match = m;
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::disableAlarm() {
+  match = MATCH_OFF;
+  sim_cancel(rtc_zero_event, this);
+}
+
+//==============================================================================
+void RTCZero::attachInterrupt(voidFuncPtr cb) {
+  callback = cb;
+}
+
+//==============================================================================
+void RTCZero::detachInterrupt() {
+  callback = 0;
+}
+
+//==============================================================================
+void RTCZero::standbyMode() {
+  sim_sleep();
+}
+
+//==============================================================================
+uint8_t RTCZero::getSeconds() { fields_t f; get_fields(&f); return f.ss; }
+uint8_t RTCZero::getMinutes() { fields_t f; get_fields(&f); return f.mm; }
+uint8_t RTCZero::getHours() { fields_t f; get_fields(&f); return f.hh; }
+uint8_t RTCZero::getDay() { fields_t f; get_fields(&f); return f.d; }
+uint8_t RTCZero::getMonth() { fields_t f; get_fields(&f); return f.m; }
+uint8_t RTCZero::getYear() { fields_t f; get_fields(&f); return f.y; }
+uint8_t RTCZero::getAlarmSeconds() { return alarm.ss; }
+uint8_t RTCZero::getAlarmMinutes() { return alarm.mm; }
+uint8_t RTCZero::getAlarmHours() { return alarm.hh; }
+uint8_t RTCZero::getAlarmDay() { return alarm.d; }
+uint8_t RTCZero::getAlarmMonth() { return alarm.m; }
+uint8_t RTCZero::getAlarmYear() { return alarm.y; }
+
+//==============================================================================
+// The CLOCK register is a set of bit fields; out-of-range writes are
+// truncated to the field width just as on the SAMD21.
+//==============================================================================
+void RTCZero::setSeconds(uint8_t v) {
+  fields_t f; get_fields(&f); f.ss = v & 0x3F; set_fields(&f);
+}
+void RTCZero::setMinutes(uint8_t v) {
+  fields_t f; get_fields(&f); f.mm = v & 0x3F; set_fields(&f);
+}
+void RTCZero::setHours(uint8_t v) {
+  fields_t f; get_fields(&f); f.hh = v & 0x1F; set_fields(&f);
+}
+void RTCZero::setDay(uint8_t v) {
+  fields_t f; get_fields(&f); f.d = v & 0x1F; set_fields(&f);
+}
+void RTCZero::setMonth(uint8_t v) {
+  fields_t f; get_fields(&f); f.m = v & 0x0F; set_fields(&f);
+}
+void RTCZero::setYear(uint8_t v) {
+  fields_t f; get_fields(&f); f.y = v & 0x3F; set_fields(&f);
+}
+
+//==============================================================================
+void RTCZero::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+  fields_t f;
+  get_fields(&f);
+  f.hh = hours & 0x1F;
+  f.mm = minutes & 0x3F;
+  f.ss = seconds & 0x3F;
+  set_fields(&f);
+}
+
+//==============================================================================
+void RTCZero::setDate(uint8_t day, uint8_t month, uint8_t year) {
+  fields_t f;
+  get_fields(&f);
+  f.d = day & 0x1F;
+  f.m = month & 0x0F;
+  f.y = year & 0x3F;
+  set_fields(&f);
+}
+
+//==============================================================================
+void RTCZero::setAlarmSeconds(uint8_t v) { alarm.ss = v & 0x3F; schedule(); }
+void RTCZero::setAlarmMinutes(uint8_t v) { alarm.mm = v & 0x3F; schedule(); }
+void RTCZero::setAlarmHours(uint8_t v) { alarm.hh = v & 0x1F; schedule(); }
+void RTCZero::setAlarmDay(uint8_t v) { alarm.d = v & 0x1F; schedule(); }
+void RTCZero::setAlarmMonth(uint8_t v) { alarm.m = v & 0x0F; schedule(); }
+void RTCZero::setAlarmYear(uint8_t v) { alarm.y = v & 0x3F; schedule(); }
+
+//==============================================================================
+void RTCZero::setAlarmTime(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+  alarm.hh = hours & 0x1F;
+  alarm.mm = minutes & 0x3F;
+  alarm.ss = seconds & 0x3F;
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::setAlarmDate(uint8_t day, uint8_t month, uint8_t year) {
+  alarm.d = day & 0x1F;
+  alarm.m = month & 0x0F;
+  alarm.y = year & 0x3F;
+  schedule();
+}
+
+//==============================================================================
+uint32_t RTCZero::getY2kEpoch() {
+  return base_y2k + (uint32_t)(count_us(sim_micros()) / 1000000);
+}
+
+//==============================================================================
+uint32_t RTCZero::getEpoch() {
+  return getY2kEpoch() + SECONDS_FROM_1970_TO_2000_U;
+}
+
+//==============================================================================
+void RTCZero::setY2kEpoch(uint32_t ts) {
+  rebase(ts);
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::setEpoch(uint32_t ts) {
+  setY2kEpoch(ts - SECONDS_FROM_1970_TO_2000_U);
+}
+
+//==============================================================================
+void RTCZero::setAlarmEpoch(uint32_t ts) {
+  DateTime dt(ts);
+  alarm.ss = dt.second();
+  alarm.mm = dt.minute();
+  alarm.hh = dt.hour();
+  alarm.d = dt.day();
+  alarm.m = dt.month();
+  alarm.y = dt.year() - 2000;
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::sim_fire() {
+  if(callback) callback();
+  sim_irq();
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::sim_freqcorr(int8_t value) {
+  rebase(getY2kEpoch());
+  freqcorr = value < -127 ? -127 : value;
+  schedule();
+}
+
+//==============================================================================
+void RTCZero::sim_drift(int32_t ppb) {
+  rebase(getY2kEpoch());
+  drift_ppb = ppb;
+  schedule();
+}
+
+//==============================================================================
+double RTCZero::sim_seconds() {
+  return SECONDS_FROM_1970_TO_2000_U + base_y2k +
+    count_us(sim_micros()) / 1e6;
+}
+
+//==============================================================================
+void RTCZero::get_fields(fields_t *f) {
+  DateTime dt(getEpoch());
+  f->ss = dt.second();
+  f->mm = dt.minute();
+  f->hh = dt.hour();
+  f->d = dt.day();
+  f->m = dt.month();
+  f->y = dt.year() - 2000;
+}
+
+//==============================================================================
+void RTCZero::set_fields(const fields_t *f) {
+  DateTime dt(2000 + f->y, f->m, f->d, f->hh, f->mm, f->ss);
+
+  rebase(dt.secondstime());
+  schedule();
+}
+
+//==============================================================================
+// Restarts the count at now with the calendar at y2k, keeping the
+// prescaler's phase.
+//==============================================================================
+void RTCZero::rebase(uint32_t y2k) {
+  uint64_t now = sim_micros();
+
+  base_frac = count_us(now) % 1000000;
+  base_y2k = y2k;
+  base_us = now;
+}
+
+//==============================================================================
+// Microseconds the RTC has counted at virtual time t since base_y2k.
+//==============================================================================
+uint64_t RTCZero::count_us(uint64_t t) {
+  int64_t d = t - base_us;
+
+  return base_frac + d + d * rate_ppb() / 1000000000;
+}
+
+//==============================================================================
+// Virtual time at which the calendar reaches y2k.
+//==============================================================================
+uint64_t RTCZero::virtual_us(uint32_t y2k) {
+  uint64_t target = (uint64_t)(y2k - base_y2k) * 1000000;
+  uint64_t t = base_us +
+    (uint64_t)((target - base_frac) * 1e9 / (1e9 + rate_ppb()));
+
+  // The division rounds; settle on the first microsecond that counts it.
+  while(t > base_us && count_us(t - 1) >= target) t--;
+  while(count_us(t) < target) t++;
+  return t;
+}
+
+//==============================================================================
+int32_t RTCZero::rate_ppb() {
+  return drift_ppb - freqcorr * SIM_FREQCORR_PPB;
+}
+
+//==============================================================================
+// Finds the next second boundary whose fields satisfy the match mask.
+//==============================================================================
+void RTCZero::schedule() {
+  uint32_t now = getY2kEpoch();
+  uint32_t t, limit;
+  DateTime dt;
+
+  sim_cancel(rtc_zero_event, this);
+  if(match == MATCH_OFF) return;
+
+  switch(match) {
+    case MATCH_SS:     limit = 60;           break;
+    case MATCH_MMSS:   limit = 3600;         break;
+    case MATCH_HHMMSS: limit = 86400;        break;
+    default:           limit = 366 * 86400;  break;
+  }
+
+  // Step a second at a time until the seconds field lines up, then a minute
+  // at a time.
+  for(t = now + 1; t <= now + limit; t += (t % 60 == alarm.ss) ? 60 : 1) {
+    dt = DateTime(t + SECONDS_FROM_1970_TO_2000_U);
+    if(dt.second() != alarm.ss) continue;
+    if(match >= MATCH_MMSS && dt.minute() != alarm.mm) continue;
+    if(match >= MATCH_HHMMSS && dt.hour() != alarm.hh) continue;
+    if(match >= MATCH_DHHMMSS && dt.day() != alarm.d) continue;
+    if(match >= MATCH_MMDDHHMMSS && dt.month() != alarm.m) continue;
+    if(match >= MATCH_YYMMDDHHMMSS && dt.year() - 2000 != alarm.y) continue;
+    sim_at(virtual_us(t), rtc_zero_event, this);
+    return;
+  }
+}
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// RTCZero stand-in. The calendar counts virtual time at the crystal's error
+// plus the FREQCORR trim; the alarm is a simulator event that runs the
+// attached ISR and wakes standbyMode(). Writing the calendar leaves the
+// prescaler alone, so the second keeps its phase, as on the SAMD21.
+//------------------------------------------------------------------------------
+
+#ifndef RTC_ZERO_H
+#define RTC_ZERO_H
+
+#include "Arduino.h"
+
+// One FREQCORR step, ppb: a prescaler clock in 2^20
+#define SIM_FREQCORR_PPB    (954)
+
+//==============================================================================
+class RTCZero {
+ public:
+  enum Alarm_Match : uint8_t {
+    MATCH_OFF = 0,
+    MATCH_SS,
+    MATCH_MMSS,
+    MATCH_HHMMSS,
+    MATCH_DHHMMSS,
+    MATCH_MMDDHHMMSS,
+    MATCH_YYMMDDHHMMSS
+  };
+
+  RTCZero();
+  void begin(bool resetTime = false);
+
+  void enableAlarm(Alarm_Match match);
+  void disableAlarm();
+  void attachInterrupt(voidFuncPtr callback);
+  void detachInterrupt();
+  void standbyMode();
+
+  uint8_t getSeconds();
+  uint8_t getMinutes();
+  uint8_t getHours();
+  uint8_t getDay();
+  uint8_t getMonth();
+  uint8_t getYear();
+  uint8_t getAlarmSeconds();
+  uint8_t getAlarmMinutes();
+  uint8_t getAlarmHours();
+  uint8_t getAlarmDay();
+  uint8_t getAlarmMonth();
+  uint8_t getAlarmYear();
+
+  void setSeconds(uint8_t seconds);
+  void setMinutes(uint8_t minutes);
+  void setHours(uint8_t hours);
+  void setTime(uint8_t hours, uint8_t minutes, uint8_t seconds);
+  void setDay(uint8_t day);
+  void setMonth(uint8_t month);
+  void setYear(uint8_t year);
+  void setDate(uint8_t day, uint8_t month, uint8_t year);
+
+  void setAlarmSeconds(uint8_t seconds);
+  void setAlarmMinutes(uint8_t minutes);
+  void setAlarmHours(uint8_t hours);
+  void setAlarmTime(uint8_t hours, uint8_t minutes, uint8_t seconds);
+  void setAlarmDay(uint8_t day);
+  void setAlarmMonth(uint8_t month);
+  void setAlarmYear(uint8_t year);
+  void setAlarmDate(uint8_t day, uint8_t month, uint8_t year);
+
+  uint32_t getEpoch();
+  uint32_t getY2kEpoch();
+  void setEpoch(uint32_t ts);
+  void setY2kEpoch(uint32_t ts);
+  void setAlarmEpoch(uint32_t ts);
+
+  bool isConfigured() { return _configured; }
+
+  // Stands in for RTC->MODE2.FREQCORR, which the library does not wrap:
+  // steps of SIM_FREQCORR_PPB, negative for SIGN set. As on the SAMD21,
+  // SIGN clear lowers the frequency and SIGN set raises it.
+  void sim_freqcorr(int8_t value);
+
+  // Harness side. Crystal error in ppb, positive runs fast; and the
+  // calendar as Unix time with its fraction of a second.
+  void sim_fire();
+  void sim_drift(int32_t ppb);
+  double sim_seconds();
+
+ private:
+  typedef struct {
+    uint8_t ss, mm, hh, d, m, y;
+  } fields_t;
+
+  void get_fields(fields_t *f);
+  void set_fields(const fields_t *f);
+  void schedule();
+  void rebase(uint32_t y2k);
+  uint64_t count_us(uint64_t t);
+  uint64_t virtual_us(uint32_t y2k);
+  int32_t rate_ppb();
+
+  bool _configured;
+  uint32_t base_y2k;        // Calendar at base_us, less base_frac
+  uint64_t base_us;
+  uint32_t base_frac;       // Prescaler phase at base_us, us
+  int32_t drift_ppb;
+  int8_t freqcorr;
+  Alarm_Match match;
+  fields_t alarm;
+  voidFuncPtr callback;
+};
+
+// The instance last begun, for harnesses
+extern RTCZero *sim_rtc_zero;
+
+#endif // RTC_ZERO_H
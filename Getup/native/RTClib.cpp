@@ -0,0 +1,341 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// RTClib stand-in.
+//------------------------------------------------------------------------------
+
+#include "RTClib.h"
+
+static const uint8_t days_in_month[] = {
+  31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+//==============================================================================
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+  uint16_t days = d;
+  uint8_t i;
+
+  if(y >= 2000U) y -= 2000U;
+  for(i = 1; i < m; ++i) days += days_in_month[i - 1];
+  if(m > 2 && y % 4 == 0) ++days;
+  return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+//==============================================================================
+static uint32_t time2ulong(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
+  return ((days * 24UL + h) * 60 + m) * 60 + s;
+}
+
+//==============================================================================
+static uint8_t bcd2bin(uint8_t val) {
+  return val - 6 * (val >> 4);
+}
+
+//==============================================================================
+static uint8_t bin2bcd(uint8_t val) {
+  return val + 6 * (val / 10);
+}
+
+//------------------------------------------------------------------------------
+// TimeSpan
+//------------------------------------------------------------------------------
+
+//==============================================================================
+TimeSpan::TimeSpan(int32_t seconds) : _seconds(seconds) {
+}
+
+//==============================================================================
+TimeSpan::TimeSpan(int16_t days, int8_t hours, int8_t minutes,
+  int8_t seconds) :
+  _seconds((int32_t)days * 86400L + (int32_t)hours * 3600 +
+    (int32_t)minutes * 60 + seconds) {
+}
+
+//==============================================================================
+TimeSpan TimeSpan::operator+(const TimeSpan &right) const {
+  return TimeSpan(_seconds + right._seconds);
+}
+
+//==============================================================================
+TimeSpan TimeSpan::operator-(const TimeSpan &right) const {
+  return TimeSpan(_seconds - right._seconds);
+}
+
+//------------------------------------------------------------------------------
+// DateTime
+//------------------------------------------------------------------------------
+
+//==============================================================================
+DateTime::DateTime(uint32_t t) {
+  uint16_t days;
+  uint8_t leap;
+
+  t -= SECONDS_FROM_1970_TO_2000;
+  ss = t % 60;
+  t /= 60;
+  mm = t % 60;
+  t /= 60;
+  hh = t % 24;
+  days = t / 24;
+  for(yOff = 0;; ++yOff) {
+    leap = yOff % 4 == 0;
+    if(days < 365U + leap) break;
+    days -= 365 + leap;
+  }
+  for(m = 1; m < 12; ++m) {
+    uint8_t days_per_month = days_in_month[m - 1];
+    if(leap && m == 2) ++days_per_month;
+    if(days < days_per_month) break;
+    days -= days_per_month;
+  }
+  d = days + 1;
+}
+
+//==============================================================================
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
+  uint8_t min, uint8_t sec) {
+  if(year >= 2000U) year -= 2000U;
+  yOff = year;
+  m = month;
+  d = day;
+  hh = hour;
+  mm = min;
+  ss = sec;
+}
+
+//==============================================================================
+DateTime::DateTime(const DateTime &copy) :
+  yOff(copy.yOff), m(copy.m), d(copy.d), hh(copy.hh), mm(copy.mm),
+  ss(copy.ss) {
+}
+
+//==============================================================================
+bool DateTime::isValid() const {
+  if(yOff >= 100) return false;
+  DateTime other(unixtime());
+  return yOff == other.yOff && m == other.m && d == other.d &&
+    hh == other.hh && mm == other.mm && ss == other.ss;
+}
+
+//==============================================================================
+uint8_t DateTime::dayOfTheWeek() const {
+  uint16_t day = date2days(yOff, m, d);
+  return (day + 6) % 7;
+}
+
+//==============================================================================
+uint32_t DateTime::secondstime() const {
+  return time2ulong(date2days(yOff, m, d), hh, mm, ss);
+}
+
+//==============================================================================
+uint32_t DateTime::unixtime() const {
+  return secondstime() + SECONDS_FROM_1970_TO_2000;
+}
+
+//==============================================================================
+DateTime DateTime::operator+(const TimeSpan &span) {
+  return DateTime(unixtime() + span.totalseconds());
+}
+
+//==============================================================================
+DateTime DateTime::operator-(const TimeSpan &span) {
+  return DateTime(unixtime() - span.totalseconds());
+}
+
+//==============================================================================
+TimeSpan DateTime::operator-(const DateTime &right) {
+  return TimeSpan(unixtime() - right.unixtime());
+}
+
+//==============================================================================
+bool DateTime::operator<(const DateTime &right) const {
+  return unixtime() < right.unixtime();
+}
+
+//==============================================================================
+bool DateTime::operator==(const DateTime &right) const {
+  return unixtime() == right.unixtime();
+}
+
+//------------------------------------------------------------------------------
+// RTC_DS3231
+//------------------------------------------------------------------------------
+
+//==============================================================================
+boolean RTC_DS3231::begin(TwoWire *wireInstance) {
+  wire = wireInstance;
+  wire->begin();
+  wire->beginTransmission(DS3231_ADDRESS);
+  return wire->endTransmission() == 0;
+}
+
+//==============================================================================
+void RTC_DS3231::adjust(const DateTime &dt) {
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write((uint8_t)DS3231_TIME);
+  wire->write(bin2bcd(dt.second()));
+  wire->write(bin2bcd(dt.minute()));
+  wire->write(bin2bcd(dt.hour()));
+  wire->write(bin2bcd(dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek()));
+  wire->write(bin2bcd(dt.day()));
+  wire->write(bin2bcd(dt.month()));
+  wire->write(bin2bcd(dt.year() - 2000U));
+  wire->endTransmission();
+
+  write_reg(DS3231_STATUSREG, read_reg(DS3231_STATUSREG) & ~0x80);
+}
+
+//==============================================================================
+bool RTC_DS3231::lostPower(void) {
+  return read_reg(DS3231_STATUSREG) >> 7;
+}
+
+//==============================================================================
+DateTime RTC_DS3231::now() {
+  uint8_t ss, mm, hh, d, m;
+  uint16_t y;
+
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write((uint8_t)DS3231_TIME);
+  wire->endTransmission();
+
+  wire->requestFrom((uint8_t)DS3231_ADDRESS, (size_t)7);
+  ss = bcd2bin(wire->read() & 0x7F);
+  mm = bcd2bin(wire->read());
+  hh = bcd2bin(wire->read());
+  wire->read();
+  d = bcd2bin(wire->read());
+  m = bcd2bin(wire->read() & 0x7F);
+  y = bcd2bin(wire->read()) + 2000U;
+
+  return DateTime(y, m, d, hh, mm, ss);
+}
+
+//==============================================================================
+Ds3231SqwPinMode RTC_DS3231::readSqwPinMode() {
+  return (Ds3231SqwPinMode)(read_reg(DS3231_CONTROL) & 0x1C);
+}
+
+//==============================================================================
+void RTC_DS3231::writeSqwPinMode(Ds3231SqwPinMode mode) {
+  uint8_t ctrl = read_reg(DS3231_CONTROL);
+
+  ctrl &= ~0x04;
+  ctrl &= ~0x18;
+  ctrl |= mode;
+  write_reg(DS3231_CONTROL, ctrl);
+}
+
+//==============================================================================
+bool RTC_DS3231::setAlarm1(const DateTime &dt, Ds3231Alarm1Mode alarm_mode) {
+  uint8_t ctrl = read_reg(DS3231_CONTROL);
+  uint8_t a1m1, a1m2, a1m3, a1m4, day;
+
+  if(!(ctrl & 0x04)) return false;
+
+  a1m1 = (alarm_mode & 0x01) << 7;
+  a1m2 = (alarm_mode & 0x02) << 6;
+  a1m3 = (alarm_mode & 0x04) << 5;
+  a1m4 = (alarm_mode & 0x08) << 4;
+  day = (alarm_mode & 0x10) ?
+    (dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek()) : dt.day();
+
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write((uint8_t)DS3231_ALARM1);
+  wire->write(bin2bcd(dt.second()) | a1m1);
+  wire->write(bin2bcd(dt.minute()) | a1m2);
+  wire->write(bin2bcd(dt.hour()) | a1m3);
+  wire->write(bin2bcd(day) | a1m4 | ((alarm_mode & 0x10) << 2));
+  wire->endTransmission();
+
+  write_reg(DS3231_CONTROL, ctrl | 0x01);
+  return true;
+}
+
+//==============================================================================
+bool RTC_DS3231::setAlarm2(const DateTime &dt, Ds3231Alarm2Mode alarm_mode) {
+  uint8_t ctrl = read_reg(DS3231_CONTROL);
+  uint8_t a2m2, a2m3, a2m4, day;
+
+  if(!(ctrl & 0x04)) return false;
+
+  a2m2 = (alarm_mode & 0x01) << 7;
+  a2m3 = (alarm_mode & 0x02) << 6;
+  a2m4 = (alarm_mode & 0x04) << 5;
+  day = (alarm_mode & 0x08) ?
+    (dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek()) : dt.day();
+
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write((uint8_t)DS3231_ALARM2);
+  wire->write(bin2bcd(dt.minute()) | a2m2);
+  wire->write(bin2bcd(dt.hour()) | a2m3);
+  wire->write(bin2bcd(day) | a2m4 | ((alarm_mode & 0x08) << 3));
+  wire->endTransmission();
+
+  write_reg(DS3231_CONTROL, ctrl | 0x02);
+  return true;
+}
+
+//==============================================================================
+void RTC_DS3231::disableAlarm(uint8_t alarm_num) {
+  uint8_t ctrl = read_reg(DS3231_CONTROL);
+  ctrl &= ~(1 << (alarm_num - 1));
+  write_reg(DS3231_CONTROL, ctrl);
+}
+
+//==============================================================================
+void RTC_DS3231::clearAlarm(uint8_t alarm_num) {
+  uint8_t status = read_reg(DS3231_STATUSREG);
+  status &= ~(0x1 << (alarm_num - 1));
+  write_reg(DS3231_STATUSREG, status);
+}
+
+//==============================================================================
+bool RTC_DS3231::alarmFired(uint8_t alarm_num) {
+  return (read_reg(DS3231_STATUSREG) >> (alarm_num - 1)) & 0x1;
+}
+
+//==============================================================================
+void RTC_DS3231::enable32K(void) {
+  write_reg(DS3231_STATUSREG, read_reg(DS3231_STATUSREG) | 0x08);
+}
+
+//==============================================================================
+void RTC_DS3231::disable32K(void) {
+  write_reg(DS3231_STATUSREG, read_reg(DS3231_STATUSREG) & ~0x08);
+}
+
+//==============================================================================
+bool RTC_DS3231::isEnabled32K(void) {
+  return (read_reg(DS3231_STATUSREG) >> 3) & 0x01;
+}
+
+//==============================================================================
+float RTC_DS3231::getTemperature() {
+  uint8_t msb, lsb;
+
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write((uint8_t)DS3231_TEMPERATUREREG);
+  wire->endTransmission();
+  wire->requestFrom((uint8_t)DS3231_ADDRESS, (size_t)2);
+  msb = wire->read();
+  lsb = wire->read();
+  return (int8_t)msb + (lsb >> 6) * 0.25f;
+}
+
+//==============================================================================
+uint8_t RTC_DS3231::read_reg(uint8_t reg) {
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write(reg);
+  wire->endTransmission();
+  wire->requestFrom((uint8_t)DS3231_ADDRESS, (size_t)1);
+  return wire->read();
+}
+
+//==============================================================================
+void RTC_DS3231::write_reg(uint8_t reg, uint8_t val) {
+  wire->beginTransmission(DS3231_ADDRESS);
+  wire->write(reg);
+  wire->write(val);
+  wire->endTransmission();
+}
@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// RTClib stand-in: DateTime, TimeSpan and the RTC_DS3231 driver, talking to
+// the simulated DS3231 over Wire with the same register traffic as RTClib.
+//------------------------------------------------------------------------------
+
+#ifndef RTCLIB_H
+#define RTCLIB_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define SECONDS_PER_DAY             (86400L)
+#define SECONDS_FROM_1970_TO_2000   (946684800)
+
+#define DS3231_ADDRESS      (0x68)
+#define DS3231_TIME         (0x00)
+#define DS3231_ALARM1       (0x07)
+#define DS3231_ALARM2       (0x0B)
+#define DS3231_CONTROL      (0x0E)
+#define DS3231_STATUSREG    (0x0F)
+#define DS3231_AGINGREG     (0x10)
+#define DS3231_TEMPERATUREREG (0x11)
+
+//==============================================================================
+class TimeSpan {
+ public:
+  TimeSpan(int32_t seconds = 0);
+  TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds);
+  int16_t days() const { return _seconds / 86400L; }
+  int8_t hours() const { return _seconds / 3600 % 24; }
+  int8_t minutes() const { return _seconds / 60 % 60; }
+  int8_t seconds() const { return _seconds % 60; }
+  int32_t totalseconds() const { return _seconds; }
+  TimeSpan operator+(const TimeSpan &right) const;
+  TimeSpan operator-(const TimeSpan &right) const;
+
+ protected:
+  int32_t _seconds;
+};
+
+//==============================================================================
+class DateTime {
+ public:
+  DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0,
+    uint8_t min = 0, uint8_t sec = 0);
+  DateTime(const DateTime &copy);
+  DateTime &operator=(const DateTime &copy) = default;
+  bool isValid() const;
+  uint16_t year() const { return 2000U + yOff; }
+  uint8_t month() const { return m; }
+  uint8_t day() const { return d; }
+  uint8_t hour() const { return hh; }
+  uint8_t minute() const { return mm; }
+  uint8_t second() const { return ss; }
+  uint8_t dayOfTheWeek() const;
+  uint32_t secondstime() const;
+  uint32_t unixtime() const;
+  DateTime operator+(const TimeSpan &span);
+  DateTime operator-(const TimeSpan &span);
+  TimeSpan operator-(const DateTime &right);
+  bool operator<(const DateTime &right) const;
+  bool operator>(const DateTime &right) const { return right < *this; }
+  bool operator<=(const DateTime &right) const { return !(*this > right); }
+  bool operator>=(const DateTime &right) const { return !(*this < right); }
+  bool operator==(const DateTime &right) const;
+  bool operator!=(const DateTime &right) const { return !(*this == right); }
+
+ protected:
+  uint8_t yOff, m, d, hh, mm, ss;
+};
+
+typedef enum {
+  DS3231_OFF = 0x1C,
+  DS3231_SquareWave1Hz = 0x00,
+  DS3231_SquareWave1kHz = 0x08,
+  DS3231_SquareWave4kHz = 0x10,
+  DS3231_SquareWave8kHz = 0x18
+} Ds3231SqwPinMode;
+
+typedef enum {
+  DS3231_A1_PerSecond = 0x0F,
+  DS3231_A1_Second = 0x0E,
+  DS3231_A1_Minute = 0x0C,
+  DS3231_A1_Hour = 0x08,
+  DS3231_A1_Date = 0x00,
+  DS3231_A1_Day = 0x10
+} Ds3231Alarm1Mode;
+
+typedef enum {
+  DS3231_A2_PerMinute = 0x7,
+  DS3231_A2_Minute = 0x6,
+  DS3231_A2_Hour = 0x4,
+  DS3231_A2_Date = 0x0,
+  DS3231_A2_Day = 0x8
+} Ds3231Alarm2Mode;
+
+//==============================================================================
+class RTC_DS3231 {
+ public:
+  boolean begin(TwoWire *wireInstance = &Wire);
+  void adjust(const DateTime &dt);
+  bool lostPower(void);
+  DateTime now();
+  Ds3231SqwPinMode readSqwPinMode();
+  void writeSqwPinMode(Ds3231SqwPinMode mode);
+  bool setAlarm1(const DateTime &dt, Ds3231Alarm1Mode alarm_mode);
+  bool setAlarm2(const DateTime &dt, Ds3231Alarm2Mode alarm_mode);
+  void disableAlarm(uint8_t alarm_num);
+  void clearAlarm(uint8_t alarm_num);
+  bool alarmFired(uint8_t alarm_num);
+  void enable32K(void);
+  void disable32K(void);
+  bool isEnabled32K(void);
+  float getTemperature();
+
+ private:
+  uint8_t read_reg(uint8_t reg);
+  void write_reg(uint8_t reg, uint8_t val);
+  TwoWire *wire;
+};
+
+#endif // RTCLIB_H
@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// TwoWire stand-in. Feeds the stats I2C hooks that the SERCOM wrappers
+// feed on the board.
+//------------------------------------------------------------------------------
+
+#include "Wire.h"
+#include "sim.h"
+#include "stats.h"
+
+TwoWire Wire;
+
+//==============================================================================
+TwoWire::TwoWire() : tx_addr(0), tx_len(0), rx_len(0), rx_pos(0) {
+}
+
+//==============================================================================
+void TwoWire::begin() {
+}
+
+//==============================================================================
+void TwoWire::end() {
+}
+
+//==============================================================================
+void TwoWire::setClock(uint32_t hz) {
+  sim_i2c_clock(hz);
+}
+
+//==============================================================================
+void TwoWire::beginTransmission(uint8_t addr) {
+  tx_addr = addr;
+  tx_len = 0;
+}
+
+//==============================================================================
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void)stop;
+  stats_i2c_txn();
+  stats_i2c_bytes(tx_len);
+  return sim_i2c_write(tx_addr, tx_buf, tx_len);
+}
+
+//==============================================================================
+uint8_t TwoWire::requestFrom(uint8_t addr, size_t quantity, bool stop) {
+  (void)stop;
+  if(quantity > WIRE_BUFFER_SIZE) quantity = WIRE_BUFFER_SIZE;
+  rx_len = sim_i2c_read(addr, rx_buf, quantity);
+  rx_pos = 0;
+  stats_i2c_txn();
+  stats_i2c_bytes(rx_len);
+  return (uint8_t)rx_len;
+}
+
+//==============================================================================
+size_t TwoWire::write(uint8_t data) {
+  if(tx_len >= WIRE_BUFFER_SIZE) return 0;
+  tx_buf[tx_len++] = data;
+  return 1;
+}
+
+//==============================================================================
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  size_t n = 0;
+  while(quantity-- && write(*data++)) n++;
+  return n;
+}
+
+//==============================================================================
+int TwoWire::available() {
+  return (int)(rx_len - rx_pos);
+}
+
+//==============================================================================
+int TwoWire::read() {
+  return rx_pos < rx_len ? rx_buf[rx_pos++] : -1;
+}
+
+//==============================================================================
+int TwoWire::peek() {
+  return rx_pos < rx_len ? rx_buf[rx_pos] : -1;
+}
@@ -0,0 +1,41 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// TwoWire stand-in. Every endTransmission()/requestFrom() is one transaction
+// on the simulated bus and is counted there.
+//------------------------------------------------------------------------------
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+
+#define WIRE_BUFFER_SIZE    (256)
+
+//==============================================================================
+class TwoWire {
+ public:
+  TwoWire();
+  void begin();
+  void end();
+  void setClock(uint32_t hz);
+  void beginTransmission(uint8_t addr);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t addr, size_t quantity, bool stop = true);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t quantity);
+  int available();
+  int read();
+  int peek();
+
+ private:
+  uint8_t tx_addr;
+  uint8_t tx_buf[WIRE_BUFFER_SIZE];
+  size_t tx_len;
+  uint8_t rx_buf[WIRE_BUFFER_SIZE];
+  size_t rx_len;
+  size_t rx_pos;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
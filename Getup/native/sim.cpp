@@ -0,0 +1,363 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <time.h>
+#include "Arduino.h"
+#include "sim.h"
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef struct {
+  uint8_t used;
+  uint64_t when;
+  sim_event_fn fn;
+  void *ctx;
+} sim_event_t;
+
+typedef struct {
+  uint8_t level;
+  int mode;
+  voidFuncPtr isr;
+} sim_pin_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint64_t now_us = 0;
+static uint8_t in_event = 0;
+static volatile uint8_t irq_taken = 0;
+static uint32_t i2c_hz = 100000;
+static uint64_t idle_us = 0;
+static uint64_t standby_us = 0;
+static uint64_t standby_start = 0;
+static uint8_t in_standby = 0;
+static sim_tickless_fn tickless = 0;
+static int cur_tag = SIM_TAG_NONE;
+static uint64_t tag_start_ns = 0;
+static sim_event_t events[SIM_NUM_EVENTS];
+static sim_pin_t pins[SIM_NUM_PINS];
+static SimI2CDevice *devices[SIM_NUM_ADDRS];
+static sim_bus_stats_t bus_total;
+static sim_bus_stats_t bus_addr[SIM_NUM_ADDRS];
+static sim_tag_stats_t tags[SIM_NUM_TAGS + 1];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static sim_event_t *next_event();
+static uint32_t charge_bus(uint8_t addr, size_t len);
+static sim_tag_stats_t *tag_slot(int tag);
+static uint64_t host_ns();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+uint64_t sim_micros() {
+  return now_us;
+}
+
+//==============================================================================
+uint64_t sim_systick_us() {
+  // Stopped from the moment standby began, including in the ISRs that end it
+  return (in_standby ? standby_start : now_us) - standby_us;
+}
+
+//==============================================================================
+void sim_advance(uint64_t us) {
+  uint64_t target = now_us + us;
+  sim_event_t *ev;
+
+  // Events may themselves spend time (an ISR touching a pin, a device model
+  // rescheduling itself); only the outermost call walks the queue.
+  if(in_event) {
+    now_us = target;
+    return;
+  }
+
+  while((ev = next_event()) && (ev->when <= target)) {
+    now_us = ev->when > now_us ? ev->when : now_us;
+    ev->used = 0;
+    in_event = 1;
+    ev->fn(ev->ctx);
+    in_event = 0;
+  }
+  now_us = target > now_us ? target : now_us;
+}
+
+//==============================================================================
+bool sim_sleep() {
+  uint64_t start = now_us;
+  sim_event_t *ev;
+
+  irq_taken = 0;
+  standby_start = start;
+  in_standby = 1;
+  while(!irq_taken) {
+    ev = next_event();
+    if(!ev) break;
+    sim_advance(ev->when > now_us ? ev->when - now_us : 0);
+  }
+  in_standby = 0;
+  idle_us += now_us - start;
+  standby_us += now_us - start;
+  return irq_taken;
+}
+
+//==============================================================================
+void sim_wfi() {
+  uint64_t start = now_us;
+  uint64_t ticks = tickless ? tickless() : 1;
+  uint64_t tick;
+  sim_event_t *ev;
+
+  tick = (now_us / 1000 + (ticks ? ticks : 1)) * 1000;
+  irq_taken = 0;
+  while(!irq_taken && (ev = next_event()) && ev->when < tick) {
+    sim_advance(ev->when > now_us ? ev->when - now_us : 0);
+  }
+  if(!irq_taken) sim_advance(tick - now_us);
+  idle_us += now_us - start;
+}
+
+//==============================================================================
+void sim_tickless(sim_tickless_fn fn) {
+  tickless = fn;
+}
+
+//==============================================================================
+uint64_t sim_idle_us() {
+  return idle_us;
+}
+
+//==============================================================================
+void sim_at(uint64_t when, sim_event_fn fn, void *ctx) {
+  uint32_t i;
+  sim_event_t *slot = 0;
+
+  for(i = 0; i < SIM_NUM_EVENTS; i++) {
+    if(events[i].used && events[i].fn == fn && events[i].ctx == ctx) {
+      slot = &events[i];
+      break;
+    }
+    if(!events[i].used && !slot) slot = &events[i];
+  }
+  if(!slot) return;
+
+  slot->used = 1;
+  slot->when = when;
+  slot->fn = fn;
+  slot->ctx = ctx;
+}
+
+//==============================================================================
+void sim_cancel(sim_event_fn fn, void *ctx) {
+  uint32_t i;
+
+  for(i = 0; i < SIM_NUM_EVENTS; i++) {
+    if(events[i].used && events[i].fn == fn && events[i].ctx == ctx) {
+      events[i].used = 0;
+    }
+  }
+}
+
+//==============================================================================
+void sim_pin_set(uint8_t pin, uint8_t level) {
+  sim_pin_t *p;
+  uint8_t fire;
+
+  if(pin >= SIM_NUM_PINS) return;
+  p = &pins[pin];
+  level = level ? HIGH : LOW;
+
+  switch(p->mode) {
+    case RISING:  fire = !p->level && level;  break;
+    case FALLING: fire = p->level && !level;  break;
+    case CHANGE:  fire = p->level != level;   break;
+    case HIGH:    fire = level;               break;
+    case LOW:     fire = !level;              break;
+    default:      fire = 0;                   break;
+  }
+  p->level = level;
+
+  if(fire && p->isr) {
+    p->isr();
+    sim_irq();
+  }
+}
+
+//==============================================================================
+uint8_t sim_pin_get(uint8_t pin) {
+  return pin < SIM_NUM_PINS ? pins[pin].level : LOW;
+}
+
+//==============================================================================
+void sim_pin_attach(uint8_t pin, voidFuncPtr isr, int mode) {
+  if(pin >= SIM_NUM_PINS) return;
+  pins[pin].isr = isr;
+  pins[pin].mode = isr ? mode : -1;
+}
+
+//==============================================================================
+void sim_irq() {
+  irq_taken = 1;
+}
+
+//==============================================================================
+void sim_i2c_attach(uint8_t addr, SimI2CDevice *dev) {
+  if(addr < SIM_NUM_ADDRS) devices[addr] = dev;
+}
+
+//==============================================================================
+uint8_t sim_i2c_write(uint8_t addr, const uint8_t *buf, size_t len) {
+  sim_advance(charge_bus(addr, len));
+  return sim_i2c_deliver(addr, buf, len);
+}
+
+//==============================================================================
+size_t sim_i2c_read(uint8_t addr, uint8_t *buf, size_t len) {
+  sim_advance(charge_bus(addr, len));
+  return sim_i2c_fetch(addr, buf, len);
+}
+
+//==============================================================================
+uint32_t sim_i2c_cost(uint8_t addr, size_t len) {
+  return charge_bus(addr, len);
+}
+
+//==============================================================================
+uint8_t sim_i2c_deliver(uint8_t addr, const uint8_t *buf, size_t len) {
+  if(addr >= SIM_NUM_ADDRS || !devices[addr]) return SIM_I2C_NACK_ADDR;
+  devices[addr]->i2c_write(buf, len);
+  return SIM_I2C_OK;
+}
+
+//==============================================================================
+size_t sim_i2c_fetch(uint8_t addr, uint8_t *buf, size_t len) {
+  if(addr >= SIM_NUM_ADDRS || !devices[addr]) return 0;
+  devices[addr]->i2c_read(buf, len);
+  return len;
+}
+
+//==============================================================================
+void sim_i2c_clock(uint32_t hz) {
+  if(hz) i2c_hz = hz;
+}
+
+//==============================================================================
+void sim_tag_enter(int tag) {
+  if(cur_tag != SIM_TAG_NONE) sim_tag_exit();
+  cur_tag = tag;
+  tag_slot(tag)->calls++;
+  tag_start_ns = host_ns();
+}
+
+//==============================================================================
+void sim_tag_exit() {
+  tag_slot(cur_tag)->host_ns += host_ns() - tag_start_ns;
+  cur_tag = SIM_TAG_NONE;
+}
+
+//==============================================================================
+const sim_bus_stats_t *sim_bus_total() {
+  return &bus_total;
+}
+
+//==============================================================================
+const sim_bus_stats_t *sim_bus_addr(uint8_t addr) {
+  return &bus_addr[addr & (SIM_NUM_ADDRS - 1)];
+}
+
+//==============================================================================
+const sim_tag_stats_t *sim_tag_stats(int tag) {
+  return tag_slot(tag);
+}
+
+//==============================================================================
+void sim_reset_stats() {
+  memset(&bus_total, 0, sizeof(bus_total));
+  memset(bus_addr, 0, sizeof(bus_addr));
+  memset(tags, 0, sizeof(tags));
+  idle_us = 0;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static sim_event_t *next_event() {
+  uint32_t i;
+  sim_event_t *ev = 0;
+
+  for(i = 0; i < SIM_NUM_EVENTS; i++) {
+    if(events[i].used && (!ev || events[i].when < ev->when)) {
+      ev = &events[i];
+    }
+  }
+  return ev;
+}
+
+//==============================================================================
+// Start, address byte, payload bytes with ACK, stop. Counts the transaction
+// and returns its bus time.
+//==============================================================================
+static uint32_t charge_bus(uint8_t addr, size_t len) {
+  uint64_t bits = 2 + 9 * (len + 1);
+  uint64_t us = (bits * 1000000 + i2c_hz - 1) / i2c_hz;
+  sim_bus_stats_t *tag = &tag_slot(cur_tag)->bus;
+
+  bus_total.transactions++;
+  bus_total.bytes += len;
+  bus_total.bus_us += us;
+  bus_addr[addr & (SIM_NUM_ADDRS - 1)].transactions++;
+  bus_addr[addr & (SIM_NUM_ADDRS - 1)].bytes += len;
+  bus_addr[addr & (SIM_NUM_ADDRS - 1)].bus_us += us;
+  tag->transactions++;
+  tag->bytes += len;
+  tag->bus_us += us;
+
+  return (uint32_t)us;
+}
+
+//==============================================================================
+static sim_tag_stats_t *tag_slot(int tag) {
+  if(tag < 0 || tag >= SIM_NUM_TAGS) return &tags[SIM_NUM_TAGS];
+  return &tags[tag];
+}
+
+//==============================================================================
+static uint64_t host_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
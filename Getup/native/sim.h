@@ -0,0 +1,218 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Virtual clock, pin, interrupt and I2C bus model shared by the native
+// stand-ins for the Arduino core and device libraries.
+//------------------------------------------------------------------------------
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SIM_NUM_PINS        (32)
+#define SIM_NUM_TAGS        (32)
+#define SIM_NUM_EVENTS      (32)
+#define SIM_NUM_ADDRS       (128)
+
+#define SIM_TAG_NONE        (-1)
+
+#define SIM_I2C_OK          (0)
+#define SIM_I2C_NACK_ADDR   (2)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef void (*sim_event_fn)(void *ctx);
+
+// Returns how many ms until the firmware next has work; see sim_tickless().
+typedef uint32_t (*sim_tickless_fn)();
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint64_t bus_us;
+} sim_bus_stats_t;
+
+typedef struct {
+  uint32_t calls;
+  uint64_t host_ns;
+  sim_bus_stats_t bus;
+} sim_tag_stats_t;
+
+//==============================================================================
+// Device model attached to the simulated I2C bus. Each call is one complete
+// bus transaction with the address byte already stripped.
+//==============================================================================
+class SimI2CDevice {
+ public:
+  virtual ~SimI2CDevice() {}
+  virtual void i2c_write(const uint8_t *buf, size_t len) = 0;
+  virtual void i2c_read(uint8_t *buf, size_t len) = 0;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Attaches the default device models (DS3231, LCD backpack, ADXL343) and sets
+// the wall clock they report.
+//
+// param epoch  Unix time the DS3231 starts at.
+//==============================================================================
+void sim_begin(uint32_t epoch);
+
+//==============================================================================
+// Returns virtual time in microseconds since sim_begin().
+//==============================================================================
+uint64_t sim_micros();
+
+//==============================================================================
+// Returns virtual time the SysTick has counted: sim_micros() less the time
+// spent in sim_sleep(). Backs millis() and micros(), which stop in standby
+// on the SAMD21.
+//==============================================================================
+uint64_t sim_systick_us();
+
+//==============================================================================
+// Moves virtual time forward, running any events that fall due on the way.
+//
+// param us  Microseconds to advance.
+//==============================================================================
+void sim_advance(uint64_t us);
+
+//==============================================================================
+// Advances virtual time until an interrupt fires. Models SAMD21 standby.
+//
+// return  False if nothing could ever wake the core.
+//==============================================================================
+bool sim_sleep();
+
+//==============================================================================
+// Halts until the next 1 ms SysTick or an earlier interrupt. Backs __WFI().
+//==============================================================================
+void sim_wfi();
+
+//==============================================================================
+// Lets sim_wfi() sleep through SysTicks that would find nothing to do, for
+// harnesses that run days of device time. fn is asked on each sim_wfi()
+// how many ms remain until anything is due, and the halt lasts until that
+// tick or an earlier interrupt. 0 or 1 halts to the next tick as usual;
+// null turns it off.
+//==============================================================================
+void sim_tickless(sim_tickless_fn fn);
+
+//==============================================================================
+// Virtual microseconds spent halted in sim_wfi() or sim_sleep() since the
+// last sim_reset_stats().
+//==============================================================================
+uint64_t sim_idle_us();
+
+//==============================================================================
+// Schedules a callback at an absolute virtual time. Scheduling the same
+// fn/ctx pair again moves the existing event.
+//
+// param when  Virtual time in microseconds.
+// param fn    Callback run from sim_advance().
+// param ctx   Opaque pointer handed back to fn.
+//==============================================================================
+void sim_at(uint64_t when, sim_event_fn fn, void *ctx);
+
+//==============================================================================
+// Removes a callback scheduled with sim_at().
+//==============================================================================
+void sim_cancel(sim_event_fn fn, void *ctx);
+
+//==============================================================================
+// Drives an input pin from outside the firmware, running any attached ISR.
+//
+// param pin    Arduino pin number.
+// param level  HIGH or LOW.
+//==============================================================================
+void sim_pin_set(uint8_t pin, uint8_t level);
+
+//==============================================================================
+// Returns the level of a pin as last written by either side.
+//==============================================================================
+uint8_t sim_pin_get(uint8_t pin);
+
+//==============================================================================
+// Registers the ISR run by sim_pin_set(). Backs attachInterrupt().
+//
+// param pin   Arduino pin number.
+// param isr   Handler, or null to detach.
+// param mode  LOW, HIGH, CHANGE, FALLING or RISING.
+//==============================================================================
+void sim_pin_attach(uint8_t pin, void (*isr)(void), int mode);
+
+//==============================================================================
+// Marks an interrupt as taken so a pending sim_sleep() returns. Called by the
+// stand-ins whenever they run a firmware ISR.
+//==============================================================================
+void sim_irq();
+
+//==============================================================================
+// Attaches a device model at a 7-bit I2C address.
+//==============================================================================
+void sim_i2c_attach(uint8_t addr, SimI2CDevice *dev);
+
+//==============================================================================
+// Runs one write transaction and charges its bus time to the virtual clock.
+//
+// return  SIM_I2C_OK, or SIM_I2C_NACK_ADDR if nothing answers.
+//==============================================================================
+uint8_t sim_i2c_write(uint8_t addr, const uint8_t *buf, size_t len);
+
+//==============================================================================
+// Runs one read transaction and charges its bus time to the virtual clock.
+//
+// return  Number of bytes read, 0 if nothing answers.
+//==============================================================================
+size_t sim_i2c_read(uint8_t addr, uint8_t *buf, size_t len);
+
+//==============================================================================
+// Split form of the two calls above for the asynchronous I2C driver, which
+// must not block: sim_i2c_cost() counts a transaction and returns its bus
+// time in us without advancing the clock, and sim_i2c_deliver() or
+// sim_i2c_fetch() moves the bytes once the caller's transfer completes.
+//==============================================================================
+uint32_t sim_i2c_cost(uint8_t addr, size_t len);
+uint8_t sim_i2c_deliver(uint8_t addr, const uint8_t *buf, size_t len);
+size_t sim_i2c_fetch(uint8_t addr, uint8_t *buf, size_t len);
+
+//==============================================================================
+// Sets the SCL frequency used to cost transactions.
+//==============================================================================
+void sim_i2c_clock(uint32_t hz);
+
+//==============================================================================
+// Attributes subsequent bus traffic and host CPU time to a tag until
+// sim_tag_exit(). Tags are the firmware's TIMER_* block ids.
+//==============================================================================
+void sim_tag_enter(int tag);
+void sim_tag_exit();
+
+//==============================================================================
+// Counter accessors. sim_reset_stats() clears all of them.
+//==============================================================================
+const sim_bus_stats_t *sim_bus_total();
+const sim_bus_stats_t *sim_bus_addr(uint8_t addr);
+const sim_tag_stats_t *sim_tag_stats(int tag);
+void sim_reset_stats();
+
+#endif // SIM_H
@@ -0,0 +1,607 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// I2C peripheral models.
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "Adafruit_ADXL343.h"
+#include "Adafruit_SleepyDog.h"
+#include "RTClib.h"
+#include "sim_devices.h"
+#include "utility/Adafruit_MCP23008.h"
+
+#define DS3231_NUM_REGS     (0x13)
+#define DS3231_INTCN        (0x04)
+#define DS3231_RS           (0x18)
+#define DS3231_AGING_PPB    (100)   // Per aging LSB; positive slows it
+#define DS3231_HALF_US      (500000)
+#define DS3231_ALARM_SCAN   (32 * 86400)
+#define NO_PIN              (0xFF)
+#define MCP_IOCON_SEQOP     (0x20)
+#define LCD_PIN_RS          (1)
+#define LCD_PIN_E           (2)
+#define LCD_PIN_DB4         (3)
+
+SimDS3231 sim_rtc;
+SimLCD sim_lcd;
+SimADXL343 sim_accel;
+WatchdogType Watchdog;
+
+//==============================================================================
+static uint8_t bin2bcd(uint8_t val) {
+  return val + 6 * (val / 10);
+}
+
+//==============================================================================
+static uint8_t bcd2bin(uint8_t val) {
+  return val - 6 * (val >> 4);
+}
+
+//==============================================================================
+void sim_begin(uint32_t epoch) {
+  sim_i2c_attach(SIM_RTC_ADDR, &sim_rtc);
+  sim_i2c_attach(SIM_LCD_ADDR, &sim_lcd);
+  sim_i2c_attach(SIM_ACCEL_ADDR, &sim_accel);
+  sim_rtc.set_epoch(epoch);
+  sim_rtc.set_int_pin(SIM_RTC_INT_PIN);
+  sim_accel.set_int_pins(SIM_ACCEL_INT1_PIN, SIM_ACCEL_INT2_PIN);
+  sim_reset_stats();
+}
+
+//------------------------------------------------------------------------------
+// DS3231
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static void ds3231_event(void *ctx) {
+  ((SimDS3231 *)ctx)->sim_alarm();
+}
+
+//==============================================================================
+static void ds3231_square_event(void *ctx) {
+  ((SimDS3231 *)ctx)->sim_square();
+}
+
+//==============================================================================
+SimDS3231::SimDS3231() : int_pin(NO_PIN), ptr(0),
+  base_epoch(SECONDS_FROM_1970_TO_2000), base_us(0), base_frac(0),
+  drift_ppb(0) {
+  memset(regs, 0, sizeof(regs));
+  regs[DS3231_CONTROL] = 0x1C;
+  regs[DS3231_STATUSREG] = 0x88;
+  regs[DS3231_TEMPERATUREREG] = 25;
+}
+
+//==============================================================================
+void SimDS3231::i2c_write(const uint8_t *buf, size_t len) {
+  uint8_t time_written = 0;
+  size_t n;
+
+  if(!len) return;
+  ptr = buf[0] % DS3231_NUM_REGS;
+  latch_time();
+
+  // The aging trim takes effect at once rather than at the next
+  // temperature conversion.
+  rebase(epoch(), count_us(sim_micros()) % 1000000);
+
+  for(n = 1; n < len; n++) {
+    if(ptr == DS3231_STATUSREG) {
+      // OSF, A2F and A1F can only be cleared from the bus.
+      regs[ptr] = (buf[n] & 0x08) | (regs[ptr] & buf[n] & 0x83) |
+        (regs[ptr] & 0x04);
+    }
+    else {
+      regs[ptr] = buf[n];
+    }
+    if(ptr <= 0x06) time_written = 1;
+    ptr = (ptr + 1) % DS3231_NUM_REGS;
+  }
+
+  if(time_written) load_time();
+  schedule();
+  drive_int();
+}
+
+//==============================================================================
+void SimDS3231::i2c_read(uint8_t *buf, size_t len) {
+  latch_time();
+  while(len--) {
+    *buf++ = regs[ptr];
+    ptr = (ptr + 1) % DS3231_NUM_REGS;
+  }
+}
+
+//==============================================================================
+void SimDS3231::set_epoch(uint32_t e) {
+  rebase(e, 0);
+  schedule();
+  drive_int();
+}
+
+//==============================================================================
+uint32_t SimDS3231::epoch() {
+  return base_epoch + (uint32_t)(count_us(sim_micros()) / 1000000);
+}
+
+//==============================================================================
+void SimDS3231::set_drift(int32_t ppb) {
+  rebase(epoch(), count_us(sim_micros()) % 1000000);
+  drift_ppb = ppb;
+  schedule();
+}
+
+//==============================================================================
+double SimDS3231::seconds() {
+  return base_epoch + count_us(sim_micros()) / 1e6;
+}
+
+//==============================================================================
+void SimDS3231::set_int_pin(uint8_t pin) {
+  int_pin = pin;
+  drive_int();
+}
+
+//==============================================================================
+// Runs at a second boundary where at least one enabled alarm matches.
+//==============================================================================
+void SimDS3231::sim_alarm() {
+  uint32_t t = epoch();
+
+  if(alarm_match(1, t)) regs[DS3231_STATUSREG] |= 0x01;
+  if(alarm_match(2, t)) regs[DS3231_STATUSREG] |= 0x02;
+  drive_int();
+  schedule();
+}
+
+//==============================================================================
+// Runs at each half second while the 1 Hz square wave is on.
+//==============================================================================
+void SimDS3231::sim_square() {
+  drive_int();
+  schedule();
+}
+
+//==============================================================================
+void SimDS3231::latch_time() {
+  DateTime dt(epoch());
+
+  regs[0] = bin2bcd(dt.second());
+  regs[1] = bin2bcd(dt.minute());
+  regs[2] = bin2bcd(dt.hour());
+  regs[3] = dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek();
+  regs[4] = bin2bcd(dt.day());
+  regs[5] = bin2bcd(dt.month());
+  regs[6] = bin2bcd(dt.year() - 2000);
+}
+
+//==============================================================================
+// Writing the seconds register restarts the countdown chain.
+//==============================================================================
+void SimDS3231::load_time() {
+  DateTime dt(2000 + bcd2bin(regs[6]), bcd2bin(regs[5] & 0x1F),
+    bcd2bin(regs[4] & 0x3F), bcd2bin(regs[2] & 0x3F),
+    bcd2bin(regs[1] & 0x7F), bcd2bin(regs[0] & 0x7F));
+  set_epoch(dt.unixtime());
+}
+
+//==============================================================================
+// Compares alarm registers against a time. Bit 7 of each register masks that
+// field; bit 6 of the day register picks day of week over date. Alarm 2 has
+// no seconds register and matches at seconds == 0.
+//==============================================================================
+uint8_t SimDS3231::alarm_match(uint8_t num, uint32_t t) {
+  DateTime dt(t);
+  const uint8_t *a = &regs[num == 1 ? DS3231_ALARM1 : DS3231_ALARM2];
+  uint8_t dow = dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek();
+
+  if(!(regs[DS3231_CONTROL] & (1 << (num - 1)))) return 0;
+  if(num == 1) {
+    if(a[0] & 0x80) return 1;
+    if(bcd2bin(a[0] & 0x7F) != dt.second()) return 0;
+    a++;
+  }
+  else if(dt.second() != 0) {
+    return 0;
+  }
+  if(a[0] & 0x80) return 1;
+  if(bcd2bin(a[0] & 0x7F) != dt.minute()) return 0;
+  if(a[1] & 0x80) return 1;
+  if(bcd2bin(a[1] & 0x3F) != dt.hour()) return 0;
+  if(a[2] & 0x80) return 1;
+  if(a[2] & 0x40) return (a[2] & 0x0F) == dow;
+  return bcd2bin(a[2] & 0x3F) == dt.day();
+}
+
+//==============================================================================
+// Finds the next second at which an enabled alarm matches. Outside the
+// once-a-second mode both alarms can only match at a fixed second of the
+// minute, so the scan walks minutes.
+//==============================================================================
+void SimDS3231::schedule() {
+  uint32_t now = epoch();
+  uint32_t m, t;
+  uint8_t ctrl = regs[DS3231_CONTROL];
+
+  sim_cancel(ds3231_square_event, this);
+  if(!(ctrl & (DS3231_INTCN | DS3231_RS))) {
+    sim_at(virtual_us((count_us(sim_micros()) / DS3231_HALF_US + 1) *
+      DS3231_HALF_US), ds3231_square_event, this);
+  }
+
+  sim_cancel(ds3231_event, this);
+  if(!(ctrl & 0x03)) return;
+
+  for(m = now - now % 60; m <= now + DS3231_ALARM_SCAN; m += 60) {
+    if((ctrl & 0x01) && (regs[DS3231_ALARM1] & 0x80)) {
+      t = now + 1;
+    }
+    else if(m > now && alarm_match(2, m)) {
+      t = m;
+    }
+    else {
+      t = m + bcd2bin(regs[DS3231_ALARM1] & 0x7F);
+      if(t <= now || !alarm_match(1, t)) continue;
+    }
+    sim_at(virtual_us((uint64_t)(t - base_epoch) * 1000000), ds3231_event,
+      this);
+    return;
+  }
+}
+
+//==============================================================================
+// INT is asserted low by any flagged, enabled alarm while INTCN is set, and
+// otherwise carries the 1 Hz square wave if RS selects it.
+//==============================================================================
+void SimDS3231::drive_int() {
+  uint8_t ctrl = regs[DS3231_CONTROL];
+  uint8_t low;
+
+  if(int_pin == NO_PIN) return;
+  if(ctrl & DS3231_INTCN) {
+    low = (regs[DS3231_STATUSREG] & ctrl & 0x03) != 0;
+  }
+  else {
+    low = !(ctrl & DS3231_RS) &&
+      count_us(sim_micros()) % 1000000 < DS3231_HALF_US;
+  }
+  if(low && sim_pin_get(int_pin)) sim_pin_set(int_pin, LOW);
+  else if(!low && !sim_pin_get(int_pin)) sim_pin_set(int_pin, HIGH);
+}
+
+//==============================================================================
+// Restarts the count at now with the time at e and the countdown chain at
+// frac us into the second.
+//==============================================================================
+void SimDS3231::rebase(uint32_t e, uint32_t frac) {
+  base_epoch = e;
+  base_us = sim_micros();
+  base_frac = frac;
+}
+
+//==============================================================================
+// Microseconds counted at virtual time t since base_epoch.
+//==============================================================================
+uint64_t SimDS3231::count_us(uint64_t t) {
+  int64_t d = t - base_us;
+
+  return base_frac + d + d * rate_ppb() / 1000000000;
+}
+
+//==============================================================================
+// Virtual time at which the count reaches count.
+//==============================================================================
+uint64_t SimDS3231::virtual_us(uint64_t count) {
+  uint64_t t = base_us +
+    (uint64_t)((count - base_frac) * 1e9 / (1e9 + rate_ppb()));
+
+  // The division rounds; settle on the first microsecond that counts it.
+  while(t > base_us && count_us(t - 1) >= count) t--;
+  while(count_us(t) < count) t++;
+  return t;
+}
+
+//==============================================================================
+int32_t SimDS3231::rate_ppb() {
+  return drift_ppb - (int8_t)regs[DS3231_AGINGREG] * DS3231_AGING_PPB;
+}
+
+//------------------------------------------------------------------------------
+// MCP23008 + HD44780
+//------------------------------------------------------------------------------
+
+//==============================================================================
+SimLCD::SimLCD() : ptr(0), four_bit(0), have_high(0), high(0), addr(0),
+  control(0), increment(1), writes(0) {
+  memset(regs, 0, sizeof(regs));
+  regs[MCP23008_IODIR] = 0xFF;
+  memset(ddram, ' ', sizeof(ddram));
+}
+
+//==============================================================================
+void SimLCD::i2c_write(const uint8_t *buf, size_t len) {
+  size_t n;
+
+  if(!len) return;
+  ptr = buf[0] % sizeof(regs);
+
+  for(n = 1; n < len; n++) {
+    if(ptr == MCP23008_GPIO || ptr == MCP23008_OLAT) {
+      gpio(buf[n]);
+    }
+    else {
+      regs[ptr] = buf[n];
+    }
+    if(!(regs[MCP23008_IOCON] & MCP_IOCON_SEQOP)) {
+      ptr = (ptr + 1) % sizeof(regs);
+    }
+  }
+}
+
+//==============================================================================
+void SimLCD::i2c_read(uint8_t *buf, size_t len) {
+  while(len--) {
+    if(ptr == MCP23008_GPIO) {
+      *buf++ = regs[MCP23008_OLAT] & ~regs[MCP23008_IODIR];
+    }
+    else {
+      *buf++ = regs[ptr];
+    }
+    if(!(regs[MCP23008_IOCON] & MCP_IOCON_SEQOP)) {
+      ptr = (ptr + 1) % sizeof(regs);
+    }
+  }
+}
+
+//==============================================================================
+const char *SimLCD::row(uint8_t r) const {
+  return &ddram[r ? 0x40 : 0x00];
+}
+
+//==============================================================================
+// The HD44780 latches DB4..7 on the falling edge of E.
+//==============================================================================
+void SimLCD::gpio(uint8_t value) {
+  uint8_t prev = regs[MCP23008_OLAT];
+
+  regs[MCP23008_OLAT] = value;
+  regs[MCP23008_GPIO] = value;
+  if((prev & (1 << LCD_PIN_E)) && !(value & (1 << LCD_PIN_E))) {
+    nibble((value >> LCD_PIN_RS) & 1, (value >> LCD_PIN_DB4) & 0x0F);
+  }
+}
+
+//==============================================================================
+void SimLCD::nibble(uint8_t rs, uint8_t value) {
+  if(!four_bit) {
+    instruction(rs, value << 4);
+  }
+  else if(!have_high) {
+    high = value;
+    have_high = 1;
+  }
+  else {
+    have_high = 0;
+    instruction(rs, (high << 4) | value);
+  }
+}
+
+//==============================================================================
+void SimLCD::instruction(uint8_t rs, uint8_t value) {
+  if(rs) {
+    if(addr & SIM_LCD_DDRAM) return;
+    ddram[addr] = (char)value;
+    writes++;
+    if(increment) addr = (addr == 0x27) ? 0x40 : (addr == 0x67) ? 0 : addr + 1;
+    else addr = (addr == 0x40) ? 0x27 : (addr == 0) ? 0x67 : addr - 1;
+  }
+  else if(value & 0x80) {
+    addr = value & 0x7F;
+  }
+  else if(value & 0x40) {
+    // CGRAM writes do not touch the visible text.
+    addr = SIM_LCD_DDRAM;
+  }
+  else if(value & 0x20) {
+    if(!(value & 0x10) && !four_bit) {
+      four_bit = 1;
+      have_high = 0;
+    }
+  }
+  else if(value & 0x10) {
+  }
+  else if(value & 0x08) {
+    control = value & 0x07;
+  }
+  else if(value & 0x04) {
+    increment = (value >> 1) & 1;
+  }
+  else if(value & 0x02) {
+    addr = 0;
+  }
+  else if(value & 0x01) {
+    memset(ddram, ' ', sizeof(ddram));
+    addr = 0;
+    increment = 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+// ADXL343
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static void adxl343_event(void *ctx) {
+  ((SimADXL343 *)ctx)->sim_sample();
+}
+
+//==============================================================================
+SimADXL343::SimADXL343() : ptr(0), fifo_len(0) {
+  memset(regs, 0, sizeof(regs));
+  memset(ref, 0, sizeof(ref));
+  regs[ADXL343_REG_DEVID] = 0xE5;
+  regs[ADXL343_REG_BW_RATE] = 0x0A;
+  regs[ADXL343_REG_INT_SOURCE] = 0x02;
+  sample[0] = 0;
+  sample[1] = 0;
+  sample[2] = 256;
+  int_pin[0] = NO_PIN;
+  int_pin[1] = NO_PIN;
+}
+
+//==============================================================================
+void SimADXL343::i2c_write(const uint8_t *buf, size_t len) {
+  size_t n;
+
+  if(!len) return;
+  ptr = buf[0] & 0x3F;
+  for(n = 1; n < len; n++) {
+    if(ptr == ADXL343_REG_FIFO_CTL && (buf[n] & 0xC0) == 0) fifo_len = 0;
+    if(ptr == ADXL343_REG_INT_ENABLE || ptr == ADXL343_REG_ACT_INACT_CTL) {
+      memcpy(ref, sample, sizeof(ref));
+    }
+    if(ptr != ADXL343_REG_INT_SOURCE && ptr != ADXL343_REG_FIFO_STATUS) {
+      regs[ptr] = buf[n];
+    }
+    ptr = (ptr + 1) & 0x3F;
+  }
+  schedule();
+  update_status();
+}
+
+//==============================================================================
+// Reading INT_SOURCE clears the latched sources. Reading past DATAZ1 pops
+// the FIFO.
+//==============================================================================
+void SimADXL343::i2c_read(uint8_t *buf, size_t len) {
+  const int16_t *out = (fifo_len && (regs[ADXL343_REG_FIFO_CTL] & 0xC0)) ?
+    fifo[0] : sample;
+  uint8_t i, popped = 0, cleared = 0;
+
+  for(i = 0; i < 3; i++) {
+    regs[0x32 + 2 * i] = (uint8_t)(out[i] & 0xFF);
+    regs[0x33 + 2 * i] = (uint8_t)((uint16_t)out[i] >> 8);
+  }
+  while(len--) {
+    *buf++ = regs[ptr];
+    if(ptr == ADXL343_REG_DATAZ1) popped = 1;
+    if(ptr == ADXL343_REG_INT_SOURCE) cleared = 1;
+    ptr = (ptr + 1) & 0x3F;
+  }
+
+  if(popped && out != sample) {
+    fifo_len--;
+    memmove(fifo[0], fifo[1], fifo_len * sizeof(fifo[0]));
+  }
+  if(cleared) {
+    regs[ADXL343_REG_INT_SOURCE] &= ~0x7C;
+    memcpy(ref, sample, sizeof(ref));
+  }
+  update_status();
+}
+
+//==============================================================================
+void SimADXL343::set_sample(int16_t x, int16_t y, int16_t z) {
+  sample[0] = x;
+  sample[1] = y;
+  sample[2] = z;
+  check_activity();
+  update_status();
+}
+
+//==============================================================================
+void SimADXL343::set_int_pins(uint8_t int1, uint8_t int2) {
+  int_pin[0] = int1;
+  int_pin[1] = int2;
+  drive_int();
+}
+
+//==============================================================================
+// One output data rate period. The FIFO keeps the newest 32 entries in
+// stream mode and stops filling when full otherwise.
+//==============================================================================
+void SimADXL343::sim_sample() {
+  uint8_t mode = regs[ADXL343_REG_FIFO_CTL] & 0xC0;
+
+  if(mode) {
+    if(fifo_len == 32 && mode == 0x80) {
+      memmove(fifo[0], fifo[1], 31 * sizeof(fifo[0]));
+      fifo_len--;
+      regs[ADXL343_REG_INT_SOURCE] |= 0x01;
+    }
+    if(fifo_len < 32) memcpy(fifo[fifo_len++], sample, sizeof(fifo[0]));
+  }
+  check_activity();
+  update_status();
+  schedule();
+}
+
+//==============================================================================
+// THRESH_ACT is 62.5 mg/LSB, samples 3.9 mg/LSB. AC-coupled activity
+// compares against the reference taken when it was enabled or last cleared.
+//==============================================================================
+void SimADXL343::check_activity() {
+  uint8_t ctl = regs[ADXL343_REG_ACT_INACT_CTL];
+  int32_t thresh = regs[ADXL343_REG_THRESH_ACT] * 16;
+  int32_t d;
+  uint8_t i;
+
+  if(!(regs[ADXL343_REG_POWER_CTL] & 0x08)) return;
+  for(i = 0; i < 3; i++) {
+    if(!(ctl & (0x40 >> i))) continue;
+    d = sample[i] - ((ctl & 0x80) ? ref[i] : 0);
+    if(d > thresh || d < -thresh) {
+      regs[ADXL343_REG_INT_SOURCE] |= 0x10;
+      break;
+    }
+  }
+}
+
+//==============================================================================
+// Level-driven sources follow the FIFO; then both pins are recomputed.
+//==============================================================================
+void SimADXL343::update_status() {
+  uint8_t *src = &regs[ADXL343_REG_INT_SOURCE];
+  uint8_t mode = regs[ADXL343_REG_FIFO_CTL] & 0xC0;
+  uint8_t watermark = regs[ADXL343_REG_FIFO_CTL] & 0x1F;
+
+  if(mode) {
+    *src = (*src & ~0x82) | (fifo_len ? 0x80 : 0) |
+      (fifo_len >= watermark ? 0x02 : 0);
+    if(fifo_len < 32) *src &= ~0x01;
+  }
+  regs[ADXL343_REG_FIFO_STATUS] = fifo_len;
+  drive_int();
+}
+
+//==============================================================================
+void SimADXL343::drive_int() {
+  uint8_t active = regs[ADXL343_REG_INT_SOURCE] & regs[ADXL343_REG_INT_ENABLE];
+  uint8_t map = regs[ADXL343_REG_INT_MAP];
+  uint8_t level[2];
+  uint8_t i;
+
+  level[0] = (active & ~map) ? HIGH : LOW;
+  level[1] = (active & map) ? HIGH : LOW;
+  for(i = 0; i < 2; i++) {
+    if(int_pin[i] != NO_PIN && sim_pin_get(int_pin[i]) != level[i]) {
+      sim_pin_set(int_pin[i], level[i]);
+    }
+  }
+}
+
+//==============================================================================
+// Samples are only clocked into the FIFO while measuring in a FIFO mode;
+// activity on its own is evaluated when the harness changes the sample.
+//==============================================================================
+void SimADXL343::schedule() {
+  uint8_t rate = regs[ADXL343_REG_BW_RATE] & 0x0F;
+  uint64_t period = (uint64_t)1000000 * (1 << (15 - rate)) / 3200;
+
+  if(!(regs[ADXL343_REG_POWER_CTL] & 0x08) ||
+    !(regs[ADXL343_REG_FIFO_CTL] & 0xC0)) {
+    sim_cancel(adxl343_event, this);
+    return;
+  }
+  sim_at(sim_micros() + period, adxl343_event, this);
+}
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Register-level models of the I2C peripherals on the alarm shield.
+//------------------------------------------------------------------------------
+
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+#include "sim.h"
+
+#define SIM_RTC_ADDR        (0x68)
+#define SIM_LCD_ADDR        (0x20)
+#define SIM_ACCEL_ADDR      (0x53)
+
+// Shield wiring of device interrupt lines
+#define SIM_RTC_INT_PIN     (5)
+#define SIM_ACCEL_INT1_PIN  (10)
+#define SIM_ACCEL_INT2_PIN  (9)
+
+#define SIM_LCD_COLS        (16)
+#define SIM_LCD_ROWS        (2)
+#define SIM_LCD_DDRAM       (0x80)
+
+//==============================================================================
+// DS3231 at 0x68. Time registers follow virtual time at the oscillator's
+// error less the aging trim; both alarms raise their status flags on a
+// match and pull the INT pin low while INTCN is set and the flag is enabled.
+// With INTCN clear and RS at 1 Hz the pin carries the square wave instead,
+// falling as each second starts. Everything else is plain register storage.
+//==============================================================================
+class SimDS3231 : public SimI2CDevice {
+ public:
+  SimDS3231();
+  void i2c_write(const uint8_t *buf, size_t len);
+  void i2c_read(uint8_t *buf, size_t len);
+
+  void set_epoch(uint32_t epoch);
+  uint32_t epoch();
+  uint8_t reg(uint8_t r) const { return regs[r % sizeof(regs)]; }
+
+  // Wires INT/SQW to an Arduino pin. Open drain, so idle high.
+  void set_int_pin(uint8_t pin);
+
+  // Harness side. Oscillator error in ppb before the aging trim, positive
+  // runs fast; and the time as Unix time with its fraction of a second.
+  void sim_alarm();
+  void sim_square();
+  void set_drift(int32_t ppb);
+  double seconds();
+
+ private:
+  void latch_time();
+  void load_time();
+  uint8_t alarm_match(uint8_t num, uint32_t t);
+  void schedule();
+  void drive_int();
+  void rebase(uint32_t e, uint32_t frac);
+  uint64_t count_us(uint64_t t);
+  uint64_t virtual_us(uint64_t count);
+  int32_t rate_ppb();
+
+  uint8_t int_pin;
+
+  uint8_t regs[0x13];
+  uint8_t ptr;
+  uint32_t base_epoch;
+  uint64_t base_us;
+  uint32_t base_frac;       // Countdown chain at base_us, us
+  int32_t drift_ppb;
+};
+
+//==============================================================================
+// MCP23008 at 0x20 with the Adafruit backpack wiring to an HD44780:
+// GP1 = RS, GP2 = E, GP3..6 = DB4..7, GP7 = backlight.
+//==============================================================================
+class SimLCD : public SimI2CDevice {
+ public:
+  SimLCD();
+  void i2c_write(const uint8_t *buf, size_t len);
+  void i2c_read(uint8_t *buf, size_t len);
+
+  // Visible text of one row, not null terminated.
+  const char *row(uint8_t r) const;
+  uint8_t backlight() const { return (regs[0x0A] >> 7) & 1; }
+  uint8_t cursor_visible() const { return (control >> 1) & 1; }
+  uint8_t cursor_addr() const { return addr; }
+  uint32_t cells_written() const { return writes; }
+
+ private:
+  void gpio(uint8_t value);
+  void nibble(uint8_t rs, uint8_t value);
+  void instruction(uint8_t rs, uint8_t value);
+
+  uint8_t regs[0x0B];
+  uint8_t ptr;
+  uint8_t four_bit;
+  uint8_t have_high;
+  uint8_t high;
+  uint8_t addr;
+  uint8_t control;
+  uint8_t increment;
+  uint32_t writes;
+  char ddram[SIM_LCD_DDRAM];
+};
+
+//==============================================================================
+// ADXL343 at 0x53. Data registers report the current sample, or the oldest
+// FIFO entry outside bypass mode. While measuring, the FIFO fills at the
+// BW_RATE output data rate, activity is checked against THRESH_ACT, and
+// INT_SOURCE drives INT1/INT2 through INT_ENABLE and INT_MAP.
+//==============================================================================
+class SimADXL343 : public SimI2CDevice {
+ public:
+  SimADXL343();
+  void i2c_write(const uint8_t *buf, size_t len);
+  void i2c_read(uint8_t *buf, size_t len);
+
+  void set_sample(int16_t x, int16_t y, int16_t z);
+  uint8_t reg(uint8_t r) const { return regs[r & 0x3F]; }
+  uint8_t fifo_entries() const { return fifo_len; }
+
+  // Wires INT1 and INT2 to Arduino pins.
+  void set_int_pins(uint8_t int1, uint8_t int2);
+
+  // Harness side.
+  void sim_sample();
+
+ private:
+  void check_activity();
+  void update_status();
+  void drive_int();
+  void schedule();
+
+  uint8_t regs[0x40];
+  uint8_t ptr;
+  int16_t sample[3];
+  int16_t ref[3];
+  int16_t fifo[32][3];
+  uint8_t fifo_len;
+  uint8_t int_pin[2];
+};
+
+extern SimDS3231 sim_rtc;
+extern SimLCD sim_lcd;
+extern SimADXL343 sim_accel;
+
+#endif // SIM_DEVICES_H
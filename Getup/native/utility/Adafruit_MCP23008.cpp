@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// Getup! Host Simulator
+// Adafruit_MCP23008 stand-in.
+//------------------------------------------------------------------------------
+
+#include "Adafruit_MCP23008.h"
+
+//==============================================================================
+void Adafruit_MCP23008::begin(uint8_t addr) {
+  uint8_t i;
+
+  i2caddr = addr & 0x07;
+  Wire.begin();
+
+  Wire.beginTransmission(MCP23008_ADDRESS | i2caddr);
+  Wire.write((uint8_t)MCP23008_IODIR);
+  Wire.write((uint8_t)0xFF);
+  for(i = 0; i < 9; i++) Wire.write((uint8_t)0x00);
+  Wire.endTransmission();
+}
+
+//==============================================================================
+void Adafruit_MCP23008::begin(void) {
+  begin(0);
+}
+
+//==============================================================================
+void Adafruit_MCP23008::pinMode(uint8_t p, uint8_t d) {
+  uint8_t iodir;
+
+  if(p > 7) return;
+  iodir = read8(MCP23008_IODIR);
+  if(d == INPUT) iodir |= 1 << p;
+  else iodir &= ~(1 << p);
+  write8(MCP23008_IODIR, iodir);
+}
+
+//==============================================================================
+void Adafruit_MCP23008::digitalWrite(uint8_t p, uint8_t d) {
+  uint8_t gpio;
+
+  if(p > 7) return;
+  gpio = readGPIO();
+  if(d == HIGH) gpio |= 1 << p;
+  else gpio &= ~(1 << p);
+  writeGPIO(gpio);
+}
+
+//==============================================================================
+void Adafruit_MCP23008::pullUp(uint8_t p, uint8_t d) {
+  uint8_t gppu;
+
+  if(p > 7) return;
+  gppu = read8(MCP23008_GPPU);
+  if(d == HIGH) gppu |= 1 << p;
+  else gppu &= ~(1 << p);
+  write8(MCP23008_GPPU, gppu);
+}
+
+//==============================================================================
+uint8_t Adafruit_MCP23008::digitalRead(uint8_t p) {
+  if(p > 7) return 0;
+  return (readGPIO() >> p) & 0x1;
+}
+
+//==============================================================================
+uint8_t Adafruit_MCP23008::readGPIO(void) {
+  return read8(MCP23008_GPIO);
+}
+
+//==============================================================================
+void Adafruit_MCP23008::writeGPIO(uint8_t gpio) {
+  write8(MCP23008_GPIO, gpio);
+}
+
+//==============================================================================
+uint8_t Adafruit_MCP23008::read8(uint8_t addr) {
+  Wire.beginTransmission(MCP23008_ADDRESS | i2caddr);
+  Wire.write(addr);
+  Wire.endTransmission();
+  Wire.requestFrom((uint8_t)(MCP23008_ADDRESS | i2caddr), (size_t)1);
+  return Wire.read();
+}
+
+//==============================================================================
+void Adafruit_MCP23008::write8(uint8_t addr, uint8_t data) {
+  Wire.beginTransmission(MCP23008_ADDRESS | i2caddr);
+  Wire.write(addr);
+  Wire.write(data);
+  Wire.endTransmission();
+}
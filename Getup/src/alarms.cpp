@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+// Getup! Alarm Store
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "alarms.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DAY_SECS            (86400UL)
+#define WEEK_SECS           (7 * DAY_SECS)
+#define EPOCH_WEEKDAY       (4)
+#define MAX_SLOTS           (7 * ALARM_MAX)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// One weekday of one alarm. Minute of the week, Sunday 00:00 = 0.
+typedef struct {
+  uint16_t minute;
+  uint8_t id;
+} slot_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static alarm_t alarms[ALARM_MAX];
+static slot_t slots[MAX_SLOTS];
+static uint8_t num_slots = 0;
+static uint8_t cursor = 0;
+static uint32_t week_start = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t upper_bound(uint16_t minute);
+static void remove_slots(uint8_t id);
+static void insert_slots(uint8_t id);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void alarms_begin(alarm_t a) {
+  uint8_t id;
+
+  for(id = 0; id < ALARM_MAX; id++) alarms[id] = a;
+  num_slots = 0;
+  cursor = 0;
+  for(id = 0; id < ALARM_MAX; id++) insert_slots(id);
+}
+
+//==============================================================================
+alarm_t alarms_get(uint8_t id) {
+  return alarms[id % ALARM_MAX];
+}
+
+//==============================================================================
+void alarms_set(uint8_t id, alarm_t a, uint32_t now) {
+  if(id >= ALARM_MAX) return;
+
+  remove_slots(id);
+  alarms[id] = a;
+  insert_slots(id);
+  alarms_seek(now);
+}
+
+//==============================================================================
+void alarms_seek(uint32_t now) {
+  uint32_t days = now / DAY_SECS;
+
+  week_start = (days - (days + EPOCH_WEEKDAY) % 7) * DAY_SECS;
+  cursor = upper_bound((now - week_start) / 60);
+  if(cursor == num_slots) {
+    cursor = 0;
+    week_start += WEEK_SECS;
+  }
+}
+
+//==============================================================================
+void alarms_advance() {
+  uint16_t minute;
+
+  if(!num_slots) return;
+
+  minute = slots[cursor].minute;
+  while(cursor < num_slots && slots[cursor].minute == minute) cursor++;
+  if(cursor == num_slots) {
+    cursor = 0;
+    week_start += WEEK_SECS;
+  }
+}
+
+//==============================================================================
+uint32_t alarms_next(uint8_t *id) {
+  if(!num_slots) {
+    if(id) *id = ALARM_NONE;
+    return 0;
+  }
+  if(id) *id = slots[cursor].id;
+  return week_start + slots[cursor].minute * 60UL;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Index of the first slot later than a minute of the week.
+//==============================================================================
+static uint8_t upper_bound(uint16_t minute) {
+  uint8_t lo = 0;
+  uint8_t hi = num_slots;
+  uint8_t mid;
+
+  while(lo < hi) {
+    mid = (lo + hi) / 2;
+    if(slots[mid].minute <= minute) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+//==============================================================================
+static void remove_slots(uint8_t id) {
+  uint8_t i, n = 0;
+
+  for(i = 0; i < num_slots; i++) {
+    if(slots[i].id != id) slots[n++] = slots[i];
+  }
+  num_slots = n;
+}
+
+//==============================================================================
+static void insert_slots(uint8_t id) {
+  uint8_t day, pos;
+  uint16_t minute;
+
+  if(!alarms[id].enabled) return;
+
+  for(day = 0; day < 7; day++) {
+    if(!(alarms[id].days & (1 << day))) continue;
+    minute = day * ALARM_MINUTES + alarms[id].minute;
+    pos = upper_bound(minute);
+    memmove(&slots[pos + 1], &slots[pos],
+      (num_slots - pos) * sizeof(slot_t));
+    slots[pos].minute = minute;
+    slots[pos].id = id;
+    num_slots++;
+  }
+}
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------
+// Getup! Battery Gauge
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "battery.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define ADC_BITS            (12)
+#define FULL_SCALE          ((1ul << BATTERY_BITS) - 1)
+
+static_assert(BATTERY_SAMPLES == 16, "measure() assumes 16 reads");
+
+// Smoothing: each measurement moves the estimate 1/2^SMOOTH_SHIFT of the way.
+// The estimate keeps MV_FRAC fractional bits so that small steps still add
+// up and it settles on the measured voltage from either side.
+#define SMOOTH_SHIFT        (2)
+#define MV_FRAC             (4)
+
+// Resting voltage in mV at 0, 10, ... 100 percent
+#define SOC_STEP            (10)
+#define SOC_POINTS          (11)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static constexpr uint16_t soc_mv[SOC_POINTS] = {
+  3300, 3600, 3690, 3730, 3770, 3790, 3820, 3870, 3920, 4000, 4200
+};
+
+static uint8_t pin = 0;
+static uint16_t scale = 0;
+static uint32_t mv_q = 0;          // Smoothed voltage, mV << MV_FRAC
+static uint8_t percent = 0;
+static uint8_t low = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint16_t measure();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void battery_begin(uint8_t battery_pin, uint16_t full_scale) {
+  pin = battery_pin;
+  scale = full_scale;
+  analogReadResolution(ADC_BITS);
+
+  mv_q = (uint32_t)measure() << MV_FRAC;
+  percent = battery_soc(battery_mv());
+  low = percent <= BATTERY_LOW_PCT;
+}
+
+//==============================================================================
+uint8_t battery_update() {
+  uint8_t old_percent = percent;
+  uint8_t old_low = low;
+  int32_t delta = ((int32_t)measure() << MV_FRAC) - (int32_t)mv_q;
+
+  mv_q += delta / (1 << SMOOTH_SHIFT);
+  percent = battery_soc(battery_mv());
+  if(percent <= BATTERY_LOW_PCT) low = 1;
+  else if(percent >= BATTERY_OK_PCT) low = 0;
+
+  return percent != old_percent || low != old_low;
+}
+
+//==============================================================================
+uint16_t battery_mv() {
+  return (mv_q + (1 << (MV_FRAC - 1))) >> MV_FRAC;
+}
+
+//==============================================================================
+uint8_t battery_percent() {
+  return percent;
+}
+
+//==============================================================================
+uint8_t battery_low() {
+  return low;
+}
+
+//==============================================================================
+uint8_t battery_soc(uint16_t v) {
+  uint8_t n;
+
+  if(v <= soc_mv[0]) return 0;
+  if(v >= soc_mv[SOC_POINTS - 1]) return 100;
+
+  for(n = 1; v > soc_mv[n]; n++);
+  return (n - 1) * SOC_STEP +
+    (uint32_t)(v - soc_mv[n - 1]) * SOC_STEP / (soc_mv[n] - soc_mv[n - 1]);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// One burst of reads summed and scaled to mV. Summing 4^k reads and dropping
+// k bits adds k bits of resolution, given the noise dithers the input.
+//==============================================================================
+static uint16_t measure() {
+  uint32_t sum = 0;
+  uint8_t n;
+
+  for(n = 0; n < BATTERY_SAMPLES; n++) {
+    sum += analogRead(pin);
+  }
+  // 16 reads add 4 bits, two of which are noise.
+  sum >>= ADC_BITS + 4 - BATTERY_BITS;
+
+  return sum * scale / FULL_SCALE;
+}
@@ -0,0 +1,254 @@
+//------------------------------------------------------------------------------
+// Getup! Button Input
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "buttons.h"
+#include "stats.h"
+#include "systime.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Keeps the compiler from moving queue accesses across the index updates.
+// One core, so no hardware barrier is needed.
+#define BARRIER()           __asm__ __volatile__("" ::: "memory")
+
+#define QUEUE_MASK          (BUTTONS_QUEUE - 1)
+
+static_assert((BUTTONS_QUEUE & QUEUE_MASK) == 0,
+  "BUTTONS_QUEUE must be a power of two");
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t pins[BUTTONS_MAX];
+static uint8_t num_pins = 0;
+
+// Producer side: written by the ISR, or with interrupts off
+static uint8_t level = 0;
+static uint32_t edge_ms[BUTTONS_MAX];
+static buttons_event_t queue[BUTTONS_QUEUE];
+static volatile uint8_t head = 0;
+static volatile uint32_t dropped = 0;
+
+// Consumer side
+static volatile uint8_t tail = 0;
+static uint8_t held = 0;
+static uint8_t long_sent = 0;
+static uint64_t hold_due[BUTTONS_MAX];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void scan(uint32_t ms);
+static void push(uint32_t ms, uint8_t button, uint8_t type);
+static void track(const buttons_event_t *e, uint64_t now);
+static uint8_t resync();
+void buttons_isr();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void buttons_begin(const uint8_t *p, uint8_t num) {
+  uint32_t ms = (uint32_t)systime_ms();
+  uint8_t b;
+
+  if(num > BUTTONS_MAX) num = BUTTONS_MAX;
+  num_pins = num;
+  for(b = 0; b < num; b++) {
+    pins[b] = p[b];
+    edge_ms[b] = ms - BUTTONS_DEBOUNCE_MS;
+    pinMode(pins[b], INPUT);
+  }
+
+  // Take the pins as they are now, so a button held through reset is
+  // pressed from here.
+  noInterrupts();
+  scan(ms);
+  interrupts();
+
+  for(b = 0; b < num; b++) {
+    attachInterrupt(digitalPinToInterrupt(pins[b]), buttons_isr, CHANGE);
+  }
+}
+
+//==============================================================================
+uint8_t buttons_pending() {
+  return head != tail;
+}
+
+//==============================================================================
+uint8_t buttons_read(buttons_event_t *e, uint64_t now) {
+  uint8_t t = tail;
+  uint8_t b;
+
+  if(t != head) {
+    BARRIER();
+    *e = queue[t & QUEUE_MASK];
+    BARRIER();
+    tail = t + 1;
+    track(e, now);
+    return 1;
+  }
+
+  for(b = 0; b < num_pins; b++) {
+    if(!(held & (1 << b)) || now < hold_due[b]) continue;
+
+    // A release lost to bounce or a full queue would leave the button held
+    // for good; check the pin before reporting the hold.
+    if(resync()) return buttons_read(e, now);
+
+    e->ms = (uint32_t)hold_due[b];
+    e->button = b;
+    if(long_sent & (1 << b)) {
+      e->type = BUTTONS_REPEAT;
+    }
+    else {
+      e->type = BUTTONS_LONG;
+      long_sent |= 1 << b;
+    }
+    hold_due[b] += BUTTONS_REPEAT_MS;
+    return 1;
+  }
+  return 0;
+}
+
+//==============================================================================
+uint32_t buttons_due(uint64_t now) {
+  uint32_t due = BUTTONS_IDLE;
+  uint8_t b;
+
+  if(buttons_pending()) return 0;
+  for(b = 0; b < num_pins; b++) {
+    if(!(held & (1 << b))) continue;
+    if(hold_due[b] <= now) return 0;
+    if(hold_due[b] - now < due) due = hold_due[b] - now;
+  }
+  return due;
+}
+
+//==============================================================================
+uint32_t buttons_dropped() {
+  return dropped;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Queues an event for every pin whose level differs from the debounced one,
+// unless its last accepted edge is too recent. Producer side only.
+//==============================================================================
+static void scan(uint32_t ms) {
+  uint8_t b, down;
+
+  for(b = 0; b < num_pins; b++) {
+    down = digitalRead(pins[b]) == HIGH;
+    if(down == ((level >> b) & 1)) continue;
+    if(ms - edge_ms[b] < BUTTONS_DEBOUNCE_MS) continue;
+    edge_ms[b] = ms;
+    level ^= 1 << b;
+    push(ms, b, down ? BUTTONS_PRESS : BUTTONS_RELEASE);
+  }
+}
+
+//==============================================================================
+static void push(uint32_t ms, uint8_t button, uint8_t type) {
+  uint8_t h = head;
+  buttons_event_t *e;
+
+  if((uint8_t)(h - tail) == BUTTONS_QUEUE) {
+    dropped++;
+    return;
+  }
+  e = &queue[h & QUEUE_MASK];
+  e->ms = ms;
+  e->button = button;
+  e->type = type;
+  BARRIER();
+  head = h + 1;
+  trace_log(TRACE_BUTTON, button << 8 | type);
+}
+
+//==============================================================================
+// Follows presses and releases to know which buttons are down.
+//==============================================================================
+static void track(const buttons_event_t *e, uint64_t now) {
+  uint8_t bit = 1 << e->button;
+
+  if(e->type == BUTTONS_PRESS) {
+    held |= bit;
+    long_sent &= ~bit;
+    // The edge happened (uint32_t)now - e->ms ms ago.
+    hold_due[e->button] = now - (uint32_t)((uint32_t)now - e->ms) +
+      BUTTONS_LONG_MS;
+  }
+  else if(e->type == BUTTONS_RELEASE) {
+    held &= ~bit;
+  }
+}
+
+//==============================================================================
+// Rescans the pins as the ISR would and drops any held button the debounced
+// state no longer has down.
+//
+// return  Nonzero if anything changed.
+//==============================================================================
+static uint8_t resync() {
+  uint8_t lost;
+
+  noInterrupts();
+  scan((uint32_t)systime_ms());
+  lost = held & ~level;
+  interrupts();
+
+  if(buttons_pending()) return 1;
+  if(!lost) return 0;
+  held &= ~lost;
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Any button pin, either edge.
+//==============================================================================
+void buttons_isr() {
+  stats_irq(STATS_WAKE_BUTTON);
+  scan((uint32_t)systime_ms());
+}
@@ -0,0 +1,196 @@
+//------------------------------------------------------------------------------
+// Getup! Calendar
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "calendar.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Four-year blocks start on a leap year
+#define QUAD_DAYS           (4 * 365 + 1)
+
+// 2000-01-01 was a Saturday
+#define DAY0_WEEKDAY        (6)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static constexpr uint8_t month_days[12] = {
+  31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+// Days before each month, and the year's length at [12]; leap years first
+static constexpr uint16_t year_days[2][13] = {
+  {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366},
+  {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365},
+};
+
+// Days before each year of a four-year block
+static constexpr uint16_t quad_days[4] = {0, 366, 731, 1096};
+
+// Step range of each CAL_* field; the day's upper end is the month's
+static constexpr uint16_t field_min[6] = {CAL_YEAR_MIN, 1, 1, 0, 0, 0};
+static constexpr uint16_t field_max[6] = {CAL_YEAR_MAX, 12, 31, 23, 59, 59};
+
+//==============================================================================
+// Sum of month_days[0..n), plus a day past February in a leap year.
+//==============================================================================
+static constexpr uint16_t sum_days(uint8_t n, uint8_t leap) {
+  return n == 0 ? 0 : month_days[n - 1] + (n == 2 && leap) +
+    sum_days(n - 1, leap);
+}
+
+//==============================================================================
+static constexpr bool year_days_ok(uint8_t n) {
+  return n > 12 || (year_days[0][n] == sum_days(n, 1) &&
+    year_days[1][n] == sum_days(n, 0) && year_days_ok(n + 1));
+}
+
+static_assert(year_days_ok(0), "year_days must add up month_days");
+static_assert(quad_days[3] + year_days[1][12] == QUAD_DAYS &&
+  quad_days[2] + year_days[1][12] == quad_days[3] &&
+  quad_days[1] + year_days[1][12] == quad_days[2] &&
+  year_days[0][12] == quad_days[1], "quad_days must add up the years");
+static_assert(CAL_EPOCH_MIN % CAL_DAY_SECS == 0 &&
+  (CAL_EPOCH_MAX + 1 - CAL_EPOCH_MIN) / CAL_DAY_SECS == 25 * QUAD_DAYS,
+  "the range is 25 four-year blocks");
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint16_t day_number(uint16_t year, uint8_t month, uint8_t day);
+static uint16_t wrap(uint16_t v, int16_t n, uint16_t min, uint16_t max);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+uint8_t cal_days_in_month(uint16_t year, uint8_t month) {
+  return month_days[month - 1] + (month == 2 && cal_leap(year));
+}
+
+//==============================================================================
+uint8_t cal_weekday(uint16_t year, uint8_t month, uint8_t day) {
+  return (day_number(year, month, day) + DAY0_WEEKDAY) % 7;
+}
+
+//==============================================================================
+void cal_split(uint32_t epoch, cal_time_t *t) {
+  uint32_t secs;
+  uint16_t days, r, yday;
+  uint8_t quad, y, m;
+  const uint16_t *before;
+
+  secs = epoch < CAL_EPOCH_MIN ? 0 : epoch - CAL_EPOCH_MIN;
+  days = secs / CAL_DAY_SECS;
+  secs -= (uint32_t)days * CAL_DAY_SECS;
+  t->hour = secs / 3600;
+  secs -= t->hour * 3600U;
+  t->minute = secs / 60;
+  t->second = secs - t->minute * 60U;
+  t->wday = (days + DAY0_WEEKDAY) % 7;
+
+  quad = days / QUAD_DAYS;
+  r = days - quad * QUAD_DAYS;
+  y = r < quad_days[1] ? 0 : (r - 1) / 365;
+  yday = r - quad_days[y];
+  before = year_days[y != 0];
+
+  // yday / 32 never passes the month, and is at most one short of it.
+  for(m = yday >> 5; yday >= before[m + 1]; m++);
+  t->year = CAL_YEAR_MIN + quad * 4 + y;
+  t->month = m + 1;
+  t->day = yday - before[m] + 1;
+}
+
+//==============================================================================
+uint32_t cal_join(const cal_time_t *t) {
+  return CAL_EPOCH_MIN +
+    (uint32_t)day_number(t->year, t->month, t->day) * CAL_DAY_SECS +
+    t->hour * 3600UL + t->minute * 60U + t->second;
+}
+
+//==============================================================================
+void cal_step(cal_time_t *t, uint8_t field, int16_t n) {
+  uint8_t days;
+
+  switch(field) {
+    case CAL_YEAR:
+      t->year = wrap(t->year, n, field_min[field], field_max[field]);
+      break;
+    case CAL_MONTH:
+      t->month = wrap(t->month, n, field_min[field], field_max[field]);
+      break;
+    case CAL_DAY:
+      t->day = wrap(t->day, n, field_min[field],
+        cal_days_in_month(t->year, t->month));
+      break;
+    case CAL_HOUR:
+      t->hour = wrap(t->hour, n, field_min[field], field_max[field]);
+      return;
+    case CAL_MINUTE:
+      t->minute = wrap(t->minute, n, field_min[field], field_max[field]);
+      return;
+    case CAL_SECOND:
+      t->second = wrap(t->second, n, field_min[field], field_max[field]);
+      return;
+    default:
+      return;
+  }
+
+  days = cal_days_in_month(t->year, t->month);
+  if(t->day > days) t->day = days;
+  t->wday = cal_weekday(t->year, t->month, t->day);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Days since 2000-01-01.
+//==============================================================================
+static uint16_t day_number(uint16_t year, uint8_t month, uint8_t day) {
+  uint8_t y = year - CAL_YEAR_MIN;
+
+  return (y >> 2) * QUAD_DAYS + quad_days[y & 3] +
+    year_days[(y & 3) != 0][month - 1] + day - 1;
+}
+
+//==============================================================================
+// Adds n to v, wrapping within min..max.
+//==============================================================================
+static uint16_t wrap(uint16_t v, int16_t n, uint16_t min, uint16_t max) {
+  int16_t span = max - min + 1;
+  int16_t r = (int16_t)(v - min + n % span) % span;
+
+  if(r < 0) r += span;
+  return min + r;
+}
@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Calibration
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "calib.h"
+#include "systime.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define PPB                 (1000000000LL)
+#define PPB_PER_MS          (1000000LL)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static calib_coef_t coef;
+
+// Last RTC measurement, less the seconds it stepped the RTC by
+static uint8_t have_base = 0;
+static uint32_t base_epoch;
+static int32_t base_offset;
+static uint32_t interval = CALIB_INTERVAL_MIN;
+
+// FREQCORR steps on top of coef.freqcorr pulling the RTC's phase in
+static int8_t steer = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static int32_t div_round(int64_t n, int64_t d);
+static int8_t clamp(int32_t v, int32_t max);
+static int32_t mag(int32_t v);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void calib_begin(const calib_coef_t *saved) {
+  memset(&coef, 0, sizeof(coef));
+  if(saved) coef = *saved;
+  coef.freqcorr = clamp(coef.freqcorr, CALIB_FREQCORR_MAX);
+  coef.aging = clamp(coef.aging, CALIB_AGING_MAX);
+  coef.reserved = 0;
+  have_base = 0;
+  steer = 0;
+  interval = CALIB_INTERVAL_MIN;
+}
+
+//==============================================================================
+const calib_coef_t *calib_coef() {
+  return &coef;
+}
+
+//==============================================================================
+int8_t calib_freqcorr() {
+  return coef.freqcorr + steer;
+}
+
+//==============================================================================
+// The steering is taken back out of the measured drift, so FREQCORR learns
+// the crystal alone, and set again from the phase each measurement leaves.
+//==============================================================================
+int16_t calib_measure(uint32_t epoch, int32_t offset) {
+  int16_t step = div_round(offset, SYSTIME_HZ);
+  int64_t ticks, drift, noise;
+
+  if(have_base && epoch > base_epoch) {
+    // Drift the learned FREQCORR leaves, and how much of it the two time
+    // stamps at each end could account for
+    ticks = (int64_t)(epoch - base_epoch) * SYSTIME_HZ;
+    drift = (int64_t)(offset - base_offset) * PPB / ticks +
+      steer * CALIB_FREQCORR_PPB;
+    noise = CALIB_JITTER * PPB / ticks;
+
+    // Far more than any crystal drifts means a clock was set in between,
+    // so only the phase is taken.
+    if(drift > CALIB_DRIFT_MAX || drift < -CALIB_DRIFT_MAX) {
+      interval = CALIB_INTERVAL_MIN;
+    }
+    else if(drift <= noise + CALIB_SETTLED_PPB &&
+      drift >= -noise - CALIB_SETTLED_PPB) {
+      interval = interval >= CALIB_INTERVAL_MAX / 2 ? CALIB_INTERVAL_MAX :
+        interval * 2;
+    }
+    else {
+      interval = interval / 2 <= CALIB_INTERVAL_MIN ? CALIB_INTERVAL_MIN :
+        interval / 2;
+    }
+
+    // Behind means slow, and a positive correction speeds up.
+    if(drift <= CALIB_DRIFT_MAX && drift >= -CALIB_DRIFT_MAX &&
+      (drift > noise + CALIB_FREQCORR_PPB / 2 ||
+      drift < -noise - CALIB_FREQCORR_PPB / 2)) {
+      coef.freqcorr = clamp(coef.freqcorr +
+        div_round(drift, CALIB_FREQCORR_PPB), CALIB_FREQCORR_MAX);
+    }
+  }
+
+  have_base = 1;
+  base_epoch = epoch;
+  base_offset = offset - step * SYSTIME_HZ;
+
+  // Enough to take what is left of the offset out by the next measurement
+  ticks = (int64_t)interval * SYSTIME_HZ;
+  steer = clamp(coef.freqcorr + clamp(div_round((int64_t)base_offset * PPB /
+    ticks, CALIB_FREQCORR_PPB), CALIB_STEER_MAX), CALIB_FREQCORR_MAX) -
+    coef.freqcorr;
+  return step;
+}
+
+//==============================================================================
+uint32_t calib_interval() {
+  return have_base ? interval : CALIB_INTERVAL_FIRST;
+}
+
+//==============================================================================
+void calib_restart() {
+  have_base = 0;
+  steer = 0;
+}
+
+//==============================================================================
+// The error runs from the first reference: ref_err starts at minus the
+// DS3231's error then, and takes in every error a set takes off it, so
+// ref_err plus its error now is what it has gained since.
+//==============================================================================
+uint8_t calib_reference(int32_t err, int16_t after, uint32_t ref) {
+  int32_t total;
+  uint32_t span;
+
+  if(mag(err) > CALIB_REF_LOST) {
+    coef.ref_epoch = ref;
+    coef.ref_err = -after;
+    return 1;
+  }
+  if(!coef.ref_epoch) {
+    coef.ref_epoch = ref;
+    coef.ref_err = -err;
+  }
+
+  total = coef.ref_err + err;
+  span = ref - coef.ref_epoch;
+  if(ref > coef.ref_epoch && span >= CALIB_AGING_SPAN &&
+    mag(total) >= CALIB_AGING_ERR) {
+    // Fast means ahead, and positive aging slows it down.
+    coef.aging = clamp(coef.aging + clamp(div_round((int64_t)total *
+      PPB_PER_MS / span, CALIB_AGING_PPB), CALIB_AGING_STEP),
+      CALIB_AGING_MAX);
+    coef.ref_epoch = ref;
+    coef.ref_err = -err;
+  }
+
+  if(mag(err) > mag(after) + CALIB_REF_SLACK) {
+    coef.ref_err += err - after;
+    return 1;
+  }
+  return 0;
+}
+
+//==============================================================================
+void calib_unreferenced() {
+  coef.ref_epoch = 0;
+  coef.ref_err = 0;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// n / d to the nearest, halves away from zero. d must be positive.
+//==============================================================================
+static int32_t div_round(int64_t n, int64_t d) {
+  return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+//==============================================================================
+static int8_t clamp(int32_t v, int32_t max) {
+  return v > max ? max : v < -max ? -max : v;
+}
+
+//==============================================================================
+static int32_t mag(int32_t v) {
+  return v < 0 ? -v : v;
+}
@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+// Getup! Qi Charger Status
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "charger.h"
+#include "stats.h"
+#include "systime.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define EDGE_CHANGED        (0x01)  // Accepted an edge that changed the level
+#define EDGE_BOUNCED        (0x02)  // Ignored an edge inside the window
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t pin;
+
+// Producer side: written by the ISR, or with interrupts off
+static uint8_t level = 0;
+static uint32_t edge_ms = 0;
+static volatile uint8_t edges = 0;
+
+// Consumer side
+static uint8_t reported = 0;
+static uint8_t bounced = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void sample(uint32_t ms);
+void charger_isr();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void charger_begin(uint8_t p) {
+  pin = p;
+  pinMode(pin, INPUT);
+
+  noInterrupts();
+  level = digitalRead(pin) == LOW;
+  edge_ms = (uint32_t)systime_ms() - CHARGER_DEBOUNCE_MS;
+  edges = 0;
+  interrupts();
+  reported = level;
+
+  attachInterrupt(digitalPinToInterrupt(pin), charger_isr, CHANGE);
+}
+
+//==============================================================================
+uint8_t charger_pending() {
+  return edges != 0;
+}
+
+//==============================================================================
+uint8_t charger_update(uint64_t now) {
+  uint8_t on;
+
+  noInterrupts();
+  if(edges & EDGE_BOUNCED) bounced = 1;
+  edges = 0;
+  if(bounced && (uint32_t)now - edge_ms >= CHARGER_DEBOUNCE_MS) {
+    bounced = 0;
+    sample((uint32_t)now);
+    edges = 0;
+  }
+  on = level;
+  interrupts();
+
+  if(on == reported) return 0;
+  reported = on;
+  return 1;
+}
+
+//==============================================================================
+uint8_t charger_on() {
+  return reported;
+}
+
+//==============================================================================
+uint32_t charger_due(uint64_t now) {
+  uint32_t since;
+
+  if(charger_pending()) return 0;
+  if(!bounced) return CHARGER_IDLE;
+  since = (uint32_t)now - edge_ms;
+  return since >= CHARGER_DEBOUNCE_MS ? 0 : CHARGER_DEBOUNCE_MS - since;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Takes the pin level as the new state if it differs. Producer side only.
+//==============================================================================
+static void sample(uint32_t ms) {
+  uint8_t on = digitalRead(pin) == LOW;
+
+  if(on == level) return;
+  level = on;
+  edge_ms = ms;
+  edges |= EDGE_CHANGED;
+  trace_log(TRACE_QI, on);
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// CHG pin, either edge.
+//==============================================================================
+void charger_isr() {
+  uint32_t ms = (uint32_t)systime_ms();
+
+  stats_irq(STATS_WAKE_QI);
+  if(ms - edge_ms < CHARGER_DEBOUNCE_MS) {
+    edges |= EDGE_BOUNCED;
+    return;
+  }
+  sample(ms);
+}
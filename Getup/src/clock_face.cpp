@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+// Getup! Clock Face
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "clock_face.h"
+#include "rtc_time.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// "00" to "99", two characters each
+static constexpr char digits[] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// cal_time_t wday order, three characters each
+static constexpr char weekdays[] = "SunMonTueWedThuFriSat";
+
+static constexpr char blank_time[] = "    00:00:00    ";
+static constexpr char blank_date[] = " Sun 2000-01-01 ";
+
+static_assert(sizeof(digits) == 201, "two characters per value");
+static_assert(sizeof(blank_time) == 17 && sizeof(blank_date) == 17,
+  "lines are 16 characters");
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static inline void put2(char *p, uint8_t v);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void clock_face_draw(char *line0, char *line1, const cal_time_t &t,
+  uint8_t changed) {
+  const char *wday;
+
+  if((changed & RTC_TIME_CHG_ALL) == RTC_TIME_CHG_ALL) {
+    memcpy(line0, blank_time, sizeof(blank_time));
+    memcpy(line1, blank_date, sizeof(blank_date));
+  }
+
+  // A change of one field implies a change of every finer one.
+  if(changed & RTC_TIME_CHG_DAY) {
+    wday = weekdays + t.wday * 3;
+    line1[CLOCK_WDAY_X] = wday[0];
+    line1[CLOCK_WDAY_X + 1] = wday[1];
+    line1[CLOCK_WDAY_X + 2] = wday[2];
+    put2(line1 + CLOCK_YR_X, t.year / 100);
+    put2(line1 + CLOCK_YR_X + 2, t.year % 100);
+    put2(line1 + CLOCK_MO_X, t.month);
+    put2(line1 + CLOCK_DY_X, t.day);
+  }
+  if(changed & RTC_TIME_CHG_HOUR) put2(line0 + CLOCK_HR_X, t.hour);
+  if(changed & RTC_TIME_CHG_MIN) put2(line0 + CLOCK_MIN_X, t.minute);
+  if(changed & RTC_TIME_CHG_SEC) put2(line0 + CLOCK_SEC_X, t.second);
+}
+
+//==============================================================================
+void clock_face_battery(char *line0, uint8_t percent, uint8_t low) {
+  if(percent > 99) percent = 99;
+  put2(line0 + CLOCK_BATT_X, percent);
+  if(percent < 10) line0[CLOCK_BATT_X] = ' ';
+  line0[CLOCK_BATT_X + 2] = '%';
+  line0[CLOCK_LOW_X] = low ? '!' : ' ';
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static inline void put2(char *p, uint8_t v) {
+  p[0] = digits[v * 2];
+  p[1] = digits[v * 2 + 1];
+}
@@ -0,0 +1,33 @@
+//------------------------------------------------------------------------------
+// Getup! CRC-16
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "crc16.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+uint16_t crc16(const void *data, size_t len, uint16_t crc) {
+  const uint8_t *p = (const uint8_t *)data;
+  uint8_t b;
+
+  while(len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for(b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+// Getup! DMA Controller
+//------------------------------------------------------------------------------
+
+#ifndef GETUP_NATIVE
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "dma.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+__attribute__((__aligned__(16))) static DmacDescriptor
+  descriptors[DMA_CHANNELS];
+__attribute__((__aligned__(16))) static DmacDescriptor
+  writeback[DMA_CHANNELS];
+static uint8_t started = 0;
+static dma_done_t done_fn[DMA_CHANNELS];
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void dma_begin() {
+  if(started) return;
+
+  PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+  PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+  DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+  DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+  while(DMAC->CTRL.reg & DMAC_CTRL_SWRST);
+
+  DMAC->BASEADDR.reg = (uint32_t)descriptors;
+  DMAC->WRBADDR.reg = (uint32_t)writeback;
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+  NVIC_EnableIRQ(DMAC_IRQn);
+  started = 1;
+}
+
+//==============================================================================
+DmacDescriptor *dma_descriptor(uint8_t ch) {
+  return &descriptors[ch];
+}
+
+//==============================================================================
+void dma_channel(uint8_t ch, uint8_t trigsrc, uint32_t trigact, uint8_t level) {
+  noInterrupts();
+  DMAC->CHID.reg = DMAC_CHID_ID(ch);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while(DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(level) |
+    DMAC_CHCTRLB_TRIGSRC(trigsrc) | trigact;
+  interrupts();
+}
+
+//==============================================================================
+void dma_enable(uint8_t ch) {
+  noInterrupts();
+  DMAC->CHID.reg = DMAC_CHID_ID(ch);
+  DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+  interrupts();
+}
+
+//==============================================================================
+void dma_disable(uint8_t ch) {
+  noInterrupts();
+  DMAC->CHID.reg = DMAC_CHID_ID(ch);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  while(DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE);
+  interrupts();
+}
+
+//==============================================================================
+void dma_on_done(uint8_t ch, dma_done_t fn) {
+  noInterrupts();
+  done_fn[ch] = fn;
+  DMAC->CHID.reg = DMAC_CHID_ID(ch);
+  if(fn) {
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+  }
+  else {
+    DMAC->CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL;
+  }
+  interrupts();
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Every channel's interrupt. Serves the lowest pending channel until none
+// is left; CHID is put back for whatever the interrupt cut into.
+//==============================================================================
+void DMAC_Handler() {
+  uint8_t saved = DMAC->CHID.reg;
+  uint8_t ch, flags;
+
+  while(DMAC->INTSTATUS.reg) {
+    ch = DMAC->INTPEND.bit.ID;
+    DMAC->CHID.reg = DMAC_CHID_ID(ch);
+    flags = DMAC->CHINTFLAG.reg;
+    DMAC->CHINTFLAG.reg = flags;
+    if((flags & DMAC_CHINTFLAG_TCMPL) && done_fn[ch]) done_fn[ch](ch);
+  }
+  DMAC->CHID.reg = saved;
+}
+#endif
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Getup! Power Governor
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "governor.h"
+#include "scheduler.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const uint16_t *periods = 0;
+static uint8_t tasks = 0;
+static uint8_t profile = GOV_INTERACTIVE;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void apply(uint8_t p);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void gov_begin(const uint16_t *table, uint8_t num_tasks, uint8_t first) {
+  periods = table;
+  tasks = num_tasks;
+  apply(first);
+}
+
+//==============================================================================
+uint8_t gov_choose(const gov_state_t *s) {
+  if(s->ringing) return GOV_RINGING;
+  if(s->display_on) return GOV_INTERACTIVE;
+  if(s->battery_low && !s->charging) return GOV_LOW_BATT;
+  if(s->alarm_in < GOV_NIGHT_LEAD) return GOV_IDLE;
+  return GOV_NIGHT;
+}
+
+//==============================================================================
+uint8_t gov_update(const gov_state_t *s) {
+  uint8_t p = gov_choose(s);
+
+  if(p == profile) return 0;
+  apply(p);
+  return 1;
+}
+
+//==============================================================================
+uint8_t gov_profile() {
+  return profile;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static void apply(uint8_t p) {
+  const uint16_t *row = periods + p * tasks;
+  uint8_t id;
+
+  profile = p;
+  for(id = 0; id < tasks; id++) {
+    if(row[id] != GOV_KEEP) sched_set_period(id, row[id]);
+  }
+}
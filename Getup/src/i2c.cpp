@@ -0,0 +1,473 @@
+//------------------------------------------------------------------------------
+// Getup! I2C Transaction Queue
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <string.h>
+#include "dma.h"
+#include "i2c.h"
+#include "stats.h"
+
+#ifdef GETUP_NATIVE
+#include "sim.h"
+#endif
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define NONE                (0xFF)
+
+// Slot states
+#define SLOT_FREE           (0)
+#define SLOT_QUEUED         (1)
+#define SLOT_ACTIVE         (2)
+
+#ifndef GETUP_NATIVE
+#define I2CM                (SERCOM3->I2CM)
+
+// Transaction phases on the bus
+#define PHASE_WRITE         (0)
+#define PHASE_READ          (1)
+
+#define BUSSTATE_OWNER      (2)
+#define CMD_STOP            (3)
+#endif
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef struct {
+  uint8_t state;
+  uint8_t addr;
+  uint8_t prio;
+  uint8_t len;              // Bytes to write, register pointer first
+  uint8_t rlen;             // Bytes to read after, 0 for a plain write
+  uint8_t *rbuf;
+  uint16_t seq;             // Queue order
+  i2c_done_t cb;
+  void *ctx;
+  uint8_t data[I2C_DATA_MAX];
+} slot_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static slot_t slots[I2C_QUEUE];
+static uint8_t active = NONE;
+static uint8_t queued = 0;
+static uint16_t next_seq = 0;
+
+// Set when the transaction on the bus has finished, with its result
+static volatile uint8_t bus_done = 0;
+static volatile uint8_t bus_err = I2C_OK;
+
+#ifndef GETUP_NATIVE
+static uint8_t phase = PHASE_WRITE;
+static volatile uint8_t tx_done = 0;   // TX channel has written every byte
+#endif
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static slot_t *take(uint8_t addr, uint8_t prio, i2c_done_t cb, void *ctx);
+static uint8_t merge(uint8_t addr, const uint8_t *data, uint8_t len,
+  uint8_t prio, i2c_done_t cb, void *ctx);
+static void start_next();
+static void hw_begin();
+static void hw_start(slot_t *s);
+static uint8_t hw_poll(slot_t *s);
+#ifndef GETUP_NATIVE
+void i2c_tx_isr(uint8_t ch);
+void i2c_rx_isr(uint8_t ch);
+#endif
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void i2c_begin() {
+  memset(slots, 0, sizeof(slots));
+  active = NONE;
+  queued = 0;
+  hw_begin();
+}
+
+//==============================================================================
+uint8_t i2c_write(uint8_t addr, const uint8_t *data, uint8_t len,
+  uint8_t prio, uint8_t flags, i2c_done_t cb, void *ctx) {
+  slot_t *s;
+
+  if(!len || len > I2C_DATA_MAX) return 0;
+  if((flags & I2C_MERGE) && merge(addr, data, len, prio, cb, ctx)) return 1;
+
+  s = take(addr, prio, cb, ctx);
+  if(!s) return 0;
+  memcpy(s->data, data, len);
+  s->len = len;
+  if(active == NONE) start_next();
+  return 1;
+}
+
+//==============================================================================
+uint8_t i2c_read(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len,
+  uint8_t prio, i2c_done_t cb, void *ctx) {
+  slot_t *s;
+
+  if(!len) return 0;
+  s = take(addr, prio, cb, ctx);
+  if(!s) return 0;
+  s->data[0] = reg;
+  s->len = 1;
+  s->rlen = len;
+  s->rbuf = buf;
+  if(active == NONE) start_next();
+  return 1;
+}
+
+//==============================================================================
+// The next transaction goes on the bus before the callback runs, so the bus
+// is not left idle for the callback's CPU time.
+//==============================================================================
+void i2c_poll() {
+  slot_t *s;
+  i2c_done_t cb;
+  void *ctx;
+  uint8_t err;
+
+  if(active == NONE || !hw_poll(&slots[active])) return;
+
+  s = &slots[active];
+  cb = s->cb;
+  ctx = s->ctx;
+  err = bus_err;
+  s->state = SLOT_FREE;
+  active = NONE;
+  start_next();
+  if(cb) cb(ctx, err);
+}
+
+//==============================================================================
+uint8_t i2c_idle() {
+  return active == NONE && !queued;
+}
+
+//==============================================================================
+uint8_t i2c_free() {
+  return I2C_QUEUE - queued - (active != NONE);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Claims a free slot and puts it at the back of the queue.
+//==============================================================================
+static slot_t *take(uint8_t addr, uint8_t prio, i2c_done_t cb, void *ctx) {
+  slot_t *s;
+  uint8_t k;
+
+  for(k = 0; k < I2C_QUEUE; k++) {
+    s = &slots[k];
+    if(s->state != SLOT_FREE) continue;
+    s->state = SLOT_QUEUED;
+    s->addr = addr;
+    s->prio = prio;
+    s->rlen = 0;
+    s->rbuf = 0;
+    s->seq = next_seq++;
+    s->cb = cb;
+    s->ctx = ctx;
+    queued++;
+    return s;
+  }
+  return 0;
+}
+
+//==============================================================================
+// Appends a write to the last transaction queued for the same address if
+// that one is a write to the same register that has not started. At most
+// one of the two may have a callback, and it moves to the merged write.
+//
+// return  Nonzero if merged.
+//==============================================================================
+static uint8_t merge(uint8_t addr, const uint8_t *data, uint8_t len,
+  uint8_t prio, i2c_done_t cb, void *ctx) {
+  slot_t *s, *last = 0;
+  uint8_t k;
+
+  for(k = 0; k < I2C_QUEUE; k++) {
+    s = &slots[k];
+    if(s->state == SLOT_FREE || s->addr != addr) continue;
+    if(!last || (int16_t)(s->seq - last->seq) > 0) last = s;
+  }
+
+  if(!last || last->state != SLOT_QUEUED || last->rlen) return 0;
+  if(last->prio != prio || last->data[0] != data[0]) return 0;
+  if(last->len + len - 1 > I2C_DATA_MAX || (cb && last->cb)) return 0;
+
+  memcpy(last->data + last->len, data + 1, len - 1);
+  last->len += len - 1;
+  if(cb) {
+    last->cb = cb;
+    last->ctx = ctx;
+  }
+  return 1;
+}
+
+//==============================================================================
+// Puts the oldest of the highest-priority queued transactions on the bus.
+//==============================================================================
+static void start_next() {
+  slot_t *s, *best = 0;
+  uint8_t k, pick = NONE;
+
+  for(k = 0; k < I2C_QUEUE; k++) {
+    s = &slots[k];
+    if(s->state != SLOT_QUEUED) continue;
+    if(best && (s->prio < best->prio ||
+      (s->prio == best->prio && (int16_t)(s->seq - best->seq) > 0))) {
+      continue;
+    }
+    best = s;
+    pick = k;
+  }
+  if(!best) return;
+
+  best->state = SLOT_ACTIVE;
+  queued--;
+  active = pick;
+  bus_done = 0;
+  bus_err = I2C_OK;
+  hw_start(best);
+}
+
+#ifndef GETUP_NATIVE
+
+//==============================================================================
+// Wire has already set SERCOM3 up as a master in smart mode, where reading
+// DATA acknowledges the byte, which is what lets the DMAC drive reads.
+//==============================================================================
+static void hw_begin() {
+  dma_begin();
+  dma_channel(DMA_CH_I2C_TX, SERCOM3_DMAC_ID_TX, DMAC_CHCTRLB_TRIGACT_BEAT,
+    1);
+  dma_channel(DMA_CH_I2C_RX, SERCOM3_DMAC_ID_RX, DMAC_CHCTRLB_TRIGACT_BEAT,
+    1);
+  dma_on_done(DMA_CH_I2C_TX, i2c_tx_isr);
+  dma_on_done(DMA_CH_I2C_RX, i2c_rx_isr);
+}
+
+//==============================================================================
+// Starts the write phase: one descriptor moves the bytes into DATA and
+// ADDR.LEN tells the SERCOM how many to expect.
+//==============================================================================
+static void hw_start(slot_t *s) {
+  DmacDescriptor *d = dma_descriptor(DMA_CH_I2C_TX);
+
+  d->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+    DMAC_BTCTRL_SRCINC;
+  d->BTCNT.reg = s->len;
+  d->SRCADDR.reg = (uint32_t)s->data + s->len;
+  d->DSTADDR.reg = (uint32_t)&I2CM.DATA.reg;
+  d->DESCADDR.reg = 0;
+  tx_done = 0;
+  dma_enable(DMA_CH_I2C_TX);
+
+  phase = PHASE_WRITE;
+  I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR(s->addr << 1) |
+    SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(s->len);
+  while(I2CM.SYNCBUSY.bit.SYSOP);
+  stats_i2c_txn();
+  stats_i2c_bytes(s->len);
+}
+
+//==============================================================================
+// Releases the bus if the transfer left it held, and stops both channels.
+//==============================================================================
+static void hw_stop() {
+  if(I2CM.STATUS.bit.BUSSTATE == BUSSTATE_OWNER) {
+    I2CM.CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT |
+      SERCOM_I2CM_CTRLB_CMD(CMD_STOP);
+    while(I2CM.SYNCBUSY.bit.SYSOP);
+  }
+  dma_disable(DMA_CH_I2C_TX);
+  dma_disable(DMA_CH_I2C_RX);
+}
+
+//==============================================================================
+// Checks the transaction on the bus and moves a register read on to its
+// read phase. Never waits: the TX channel's interrupt followed by MB marks
+// the end of the write phase, the RX channel's interrupt the end of the
+// read phase.
+//
+// return  Nonzero once the transaction has finished.
+//==============================================================================
+static uint8_t hw_poll(slot_t *s) {
+  uint16_t status = I2CM.STATUS.reg;
+  uint8_t written;
+  DmacDescriptor *d;
+
+  if(status & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST)) {
+    bus_err = I2C_ERR_BUS;
+    hw_stop();
+    return 1;
+  }
+
+  if(phase == PHASE_READ) {
+    if(bus_done) {
+      hw_stop();
+      return 1;
+    }
+    // Address not acknowledged
+    if(I2CM.INTFLAG.bit.MB && (status & SERCOM_I2CM_STATUS_RXNACK)) {
+      bus_err = I2C_ERR_NACK;
+      hw_stop();
+      return 1;
+    }
+    return 0;
+  }
+
+  // MB is set after the address and after every byte, until the TX channel
+  // writes DATA again. Only once that channel has written the last byte
+  // does MB mean the write is over, so tx_done is sampled first. A NACK
+  // ends the write at any byte.
+  written = tx_done;
+  if(!I2CM.INTFLAG.bit.MB) return 0;
+  if(I2CM.STATUS.bit.RXNACK) {
+    bus_err = I2C_ERR_NACK;
+    hw_stop();
+    return 1;
+  }
+  if(!written) return 0;
+  if(!s->rlen) {
+    hw_stop();
+    return 1;
+  }
+
+  // Start the read. With LENEN the SERCOM sent a STOP after the last byte
+  // written, so this is a fresh START rather than a repeated one. ACKACT
+  // must be clear or smart mode would NACK the first byte; LEN makes the
+  // SERCOM NACK the last one.
+  d = dma_descriptor(DMA_CH_I2C_RX);
+  d->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+    DMAC_BTCTRL_DSTINC;
+  d->BTCNT.reg = s->rlen;
+  d->SRCADDR.reg = (uint32_t)&I2CM.DATA.reg;
+  d->DSTADDR.reg = (uint32_t)s->rbuf + s->rlen;
+  d->DESCADDR.reg = 0;
+  dma_enable(DMA_CH_I2C_RX);
+
+  phase = PHASE_READ;
+  I2CM.CTRLB.reg &= ~SERCOM_I2CM_CTRLB_ACKACT;
+  I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((s->addr << 1) | 1) |
+    SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(s->rlen);
+  while(I2CM.SYNCBUSY.bit.SYSOP);
+  stats_i2c_txn();
+  stats_i2c_bytes(s->rlen);
+  return 0;
+}
+
+#else
+
+//==============================================================================
+// Host stand-in for the SERCOM and DMAC: the whole transaction is costed on
+// the simulated bus when it starts, and a virtual-clock event at the end of
+// its bus time moves the bytes and raises the completion interrupt.
+//==============================================================================
+static void bus_event(void *ctx) {
+  slot_t *s = (slot_t *)ctx;
+
+  if(sim_i2c_deliver(s->addr, s->data, s->len) != SIM_I2C_OK) {
+    bus_err = I2C_ERR_NACK;
+  }
+  else if(s->rlen && sim_i2c_fetch(s->addr, s->rbuf, s->rlen) != s->rlen) {
+    bus_err = I2C_ERR_NACK;
+  }
+  bus_done = 1;
+  sim_irq();
+}
+
+//==============================================================================
+static void hw_begin() {
+}
+
+//==============================================================================
+static void hw_start(slot_t *s) {
+  uint64_t us = sim_i2c_cost(s->addr, s->len);
+
+  stats_i2c_txn();
+  stats_i2c_bytes(s->len);
+  if(s->rlen) {
+    us += sim_i2c_cost(s->addr, s->rlen);
+    stats_i2c_txn();
+    stats_i2c_bytes(s->rlen);
+  }
+  sim_at(sim_micros() + us, bus_event, s);
+}
+
+//==============================================================================
+static uint8_t hw_poll(slot_t *s) {
+  (void)s;
+  return bus_done;
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+#ifndef GETUP_NATIVE
+
+//==============================================================================
+// TX channel transfer complete: the last byte of a write is in DATA, so the
+// next MB is the end of the write phase.
+//==============================================================================
+void i2c_tx_isr(uint8_t ch) {
+  (void)ch;
+  tx_done = 1;
+}
+
+//==============================================================================
+// RX channel transfer complete: the last byte of a read is in.
+//==============================================================================
+void i2c_rx_isr(uint8_t ch) {
+  (void)ch;
+  bus_done = 1;
+}
+
+#endif
@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+// Getup! LCD Framebuffer
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <Wire.h>
+#include "i2c.h"
+#include "lcd_fb.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// MCP23008 registers
+#define MCP_IOCON           (0x05)
+#define MCP_GPIO            (0x09)
+#define MCP_IOCON_SEQOP     (0x20)
+
+// Backpack wiring
+#define BIT_RS              (0x02)
+#define BIT_E               (0x04)
+#define DATA_SHIFT          (3)
+#define BIT_BACKLIGHT       (0x80)
+
+// HD44780 instructions
+#define CMD_DISPLAY         (0x0C)
+#define CMD_CURSOR_ON       (0x02)
+#define CMD_DDRAM           (0x80)
+#define ROW_OFFSET          (0x40)
+
+// Payload bytes per I2C transaction, register pointer included.
+#define BURST_MAX           (64)
+
+// Most bytes one flush can send: every cell and a DDRAM address per row, at
+// four GPIO bytes each, and the cursor. A flush waits until the queue has
+// room for all of it.
+#define FLUSH_BYTES         (4 * (LCD_FB_ROWS * (LCD_FB_COLS + 1) + 2))
+#define FLUSH_SLOTS         ((FLUSH_BYTES + BURST_MAX - 2) / (BURST_MAX - 1))
+
+static_assert(BURST_MAX <= I2C_DATA_MAX, "bursts must fit an I2C write");
+
+// An unchanged cell costs the same four bytes as a new DDRAM address, so
+// runs separated by a single clean cell are sent as one.
+#define MERGE_GAP           (1)
+
+#define CURSOR_OFF          (0xFF)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t mcp_addr;
+static char want[LCD_FB_ROWS][LCD_FB_COLS];
+static char shown[LCD_FB_ROWS][LCD_FB_COLS];
+static uint8_t cursor_want = CURSOR_OFF;
+static uint8_t cursor_shown = CURSOR_OFF;
+static uint8_t backlight_want = BIT_BACKLIGHT;
+static uint8_t backlight_shown = BIT_BACKLIGHT;
+static uint8_t burst[BURST_MAX];
+static uint8_t burst_len;
+static uint8_t deferred = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void emit(uint8_t value);
+static void send(uint8_t value, uint8_t rs);
+static void burst_flush();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void lcd_fb_begin(uint8_t addr) {
+  mcp_addr = addr;
+  memset(want, ' ', sizeof(want));
+  memset(shown, ' ', sizeof(shown));
+  cursor_want = cursor_shown = CURSOR_OFF;
+  backlight_want = backlight_shown = BIT_BACKLIGHT;
+
+  Wire.beginTransmission(mcp_addr);
+  Wire.write((uint8_t)MCP_IOCON);
+  Wire.write((uint8_t)MCP_IOCON_SEQOP);
+  Wire.endTransmission();
+}
+
+//==============================================================================
+void lcd_fb_write(uint8_t row, const char *text) {
+  uint8_t col;
+
+  if(row >= LCD_FB_ROWS) return;
+  for(col = 0; col < LCD_FB_COLS && text[col]; col++) {
+    want[row][col] = text[col];
+  }
+}
+
+//==============================================================================
+void lcd_fb_cursor(uint8_t col, uint8_t row) {
+  if(col >= LCD_FB_COLS || row >= LCD_FB_ROWS) return;
+  cursor_want = row * ROW_OFFSET + col;
+}
+
+//==============================================================================
+void lcd_fb_no_cursor() {
+  cursor_want = CURSOR_OFF;
+}
+
+//==============================================================================
+void lcd_fb_backlight(uint8_t on) {
+  backlight_want = on ? BIT_BACKLIGHT : 0;
+}
+
+//==============================================================================
+uint8_t lcd_fb_flush() {
+  uint8_t row, col, end, gap;
+  uint8_t cells = 0;
+  uint8_t moved = 0;
+  uint8_t backlight_changed = backlight_want != backlight_shown;
+
+  // The shadow only moves once the bursts are queued; try again next time.
+  deferred = i2c_free() < FLUSH_SLOTS;
+  if(deferred) return 0;
+
+  burst_len = 0;
+  backlight_shown = backlight_want;
+
+  for(row = 0; row < LCD_FB_ROWS; row++) {
+    col = 0;
+    while(col < LCD_FB_COLS) {
+      if(want[row][col] == shown[row][col]) {
+        col++;
+        continue;
+      }
+
+      // Extend the run across small clean gaps.
+      end = col;
+      gap = 0;
+      while(end + 1 + gap < LCD_FB_COLS && gap <= MERGE_GAP) {
+        if(want[row][end + 1 + gap] != shown[row][end + 1 + gap]) {
+          end += 1 + gap;
+          gap = 0;
+        }
+        else {
+          gap++;
+        }
+      }
+
+      send(CMD_DDRAM | (row * ROW_OFFSET + col), 0);
+      for(; col <= end; col++) {
+        send(want[row][col], BIT_RS);
+        shown[row][col] = want[row][col];
+        cells++;
+      }
+      moved = 1;
+    }
+  }
+
+  // Writing moves the address counter, so a visible cursor is put back.
+  if(cursor_want != cursor_shown) {
+    send(CMD_DISPLAY | (cursor_want != CURSOR_OFF ? CMD_CURSOR_ON : 0), 0);
+  }
+  if(cursor_want != CURSOR_OFF && (moved || cursor_want != cursor_shown)) {
+    send(CMD_DDRAM | cursor_want, 0);
+  }
+  cursor_shown = cursor_want;
+
+  // Every byte carries the backlight bit; with nothing else to send a
+  // change is a single GPIO write.
+  if(!burst_len && backlight_changed) emit(backlight_shown);
+
+  burst_flush();
+  return cells;
+}
+
+//==============================================================================
+uint8_t lcd_fb_pending() {
+  return deferred && i2c_free() >= FLUSH_SLOTS;
+}
+
+//==============================================================================
+uint8_t lcd_fb_deferred() {
+  return deferred;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static void emit(uint8_t value) {
+  if(!burst_len) burst[burst_len++] = MCP_GPIO;
+  burst[burst_len++] = value;
+  if(burst_len == BURST_MAX) burst_flush();
+}
+
+//==============================================================================
+// One byte as two nibbles, each presented with E high and latched on the
+// falling edge. At 100 kHz every GPIO byte holds for ~90 us, which covers
+// the HD44780 enable pulse width and the 37 us instruction time.
+//==============================================================================
+static void send(uint8_t value, uint8_t rs) {
+  uint8_t out = backlight_shown | rs;
+  uint8_t hi = out | ((value >> 4) << DATA_SHIFT);
+  uint8_t lo = out | ((value & 0x0F) << DATA_SHIFT);
+
+  emit(hi | BIT_E);
+  emit(hi);
+  emit(lo | BIT_E);
+  emit(lo);
+}
+
+//==============================================================================
+// Queued below the clock and accelerometer. Consecutive bursts all start at
+// GPIO, which byte mode holds the pointer on, so the queue may join them.
+//==============================================================================
+static void burst_flush() {
+  if(!burst_len) return;
+  i2c_write(mcp_addr, burst, burst_len, I2C_PRIO_LOW, I2C_MERGE, 0, 0);
+  burst_len = 0;
+}
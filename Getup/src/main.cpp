@@ -13,7 +13,7 @@
 // - Alarm rings when time reaches alarm time:                     x
 // - Alarm disabled when unit is placed on Qi pad                  x
 // - Alarm temporarily disabled on accelerometer shake:            x
-// - System wakes and sleeps at proper time:
+// - System wakes and sleeps at proper time:                       x
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
@@ -30,6 +30,28 @@
 #include "RTCZero.h"
 #include "Adafruit_SleepyDog.h"
 #include "Adafruit_BluefruitLE_SPI.h"
+#include "alarms.h"
+#include "battery.h"
+#include "buttons.h"
+#include "calendar.h"
+#include "calib.h"
+#include "charger.h"
+#include "clock_face.h"
+#include "lcd_fb.h"
+#include "menu.h"
+#include "motion.h"
+#include "power.h"
+#include "rtc_time.h"
+#include "crc16.h"
+#include "governor.h"
+#include "i2c.h"
+#include "scheduler.h"
+#include "sound.h"
+#include "stats.h"
+#include "store.h"
+#include "sync.h"
+#include "systime.h"
+#include "trace.h"
 
 //------------------------------------------------------------------------------
 //      __   ___  ___         ___  __
@@ -53,6 +75,7 @@
 #define PIN_BT_CS           (8)
 #define PIN_BT_IRQ          (7)
 
+#define PIN_RTC_INT         (5)
 #define PIN_LED_WAIT        (6)
 #define PIN_BUZZER          (3)
 
@@ -68,19 +91,20 @@
 #define LCD_WIDTH           (16)
 #define LCD_HEIGHT          (2)
 
-// Program values
-#define BUTTON_UPDATE_TIME  (20)
+// Task periods in ms with the backlight on; see the power profiles for the
+// rest. The buttons and the charger are interrupt driven and their tasks set
+// their own periods.
 #define RTC_UPDATE_TIME     (100)
 #define ACCEL_UPDATE_TIME   (100)
-#define QI_UPDATE_TIME      (100)
-#define BATT_UPDATE_TIME    (100)
-#define SPKR_UPDATE_TIME    (100)
+#define BATT_UPDATE_TIME    (30000)
+#define SPKR_UPDATE_TIME    (1000)
 #define LED_UPDATE_TIME     (100)
 #define LCD_UPDATE_TIME     (250)
 #define FSM_UPDATE_TIME     (20)
 #define ALM_UPDATE_TIME     (20)
+#define STATS_UPDATE_TIME   (100)
+#define BLE_UPDATE_TIME     (50)
 
-#define NUM_ALARMS          (5)
 #define NUM_BUTTONS         (4)
 
 #define BTN_PLUS            (0)
@@ -88,28 +112,55 @@
 #define BTN_SEL             (2)
 #define BTN_SET             (3)
 
-#define TIME_LCD_POS_Y      (0)
-#define HR_LCD_POS_X        (4)
-#define MIN_LCD_POS_X       (7)
-#define SEC_LCD_POS_X       (10)
+#define ALM_LCD_POS_Y       (1)
+#define ALM_HR_LCD_POS_X    (0)
+#define ALM_MIN_LCD_POS_X   (3)
+#define ALM_DAY_LCD_POS_X   (6)
+#define ALM_SND_LCD_POS_X   (15)
 
-#define DATE_LCD_POS_Y      (1)
-#define WORD_LCD_POS_X      (1)
-#define YR_LCD_POS_X        (5)
-#define MO_LCD_POS_X        (10)
-#define DY_LCD_POS_X        (13)
+#define PREFS_LCD_POS_X     (12)
 
-#define ALM_LCD_POS_Y       (1)
-#define ALM_HR_LCD_POS_X    (7)
-#define ALM_MIN_LCD_POS_X   (10)
+// Settings store keys
+#define KEY_ALARM           (0)
+#define KEY_PREFS           (KEY_ALARM + ALARM_MAX)
+#define KEY_CALIB           (KEY_PREFS + 1)   // CALIB_WORDS keys
+
+#define MINUTE_MS           (60000ul)
+
+// Cell voltage at ADC full scale: 1:2 divider into the 3.3 V reference
+#define BATT_FULL_SCALE_MV  (6600)
+
+// Menu change bit for the battery field, above the RTC_TIME_* bits
+#define CHG_BATT            (0x40)
+
+#define SERIAL_BAUD         (115200)
+
+// Serial commands handled by task_stats()
+#define CMD_SNAPSHOT        ('s')   // Binary stats_t frame
+#define CMD_ESTIMATE        ('e')   // Average current and mAh/day as text
+#define CMD_RESET           ('r')   // Clear the counters and the trace
+#define CMD_TRACE           ('t')   // Binary trace_t frame
+
+// Binary frames: "G", type, uint16 length, payload, CRC-16 of the payload
+#define FRAME_SYNC_0        ('G')
+#define FRAME_STATS         ('S')
+#define FRAME_TRACE         ('T')
+
+// The radio stays up this long after the display goes off or the last sync
+// frame, whichever is later
+#define BLE_LINGER_MS       (10000)
+
+// Sync handler table entry for requests of any payload length
+#define SYNC_ANY_LEN        (0xFF)
 
-#define HOUR                (3600)
-#define MINUTE              (60)
-#define SECOND              (1)
+// Backlight on-time after the last activity, seconds
+#define BACKLIGHT_DEFAULT   (10)
+#define BACKLIGHT_STEP      (5)
+#define BACKLIGHT_MAX       (60)
 
-#define UPDATE_DELAY        (500)
-#define ALARM_REARM_DELAY   (60000)
-#define LCD_TIMEOUT         (10000)
+// Snooze length after a shake, minutes
+#define SNOOZE_DEFAULT      (1)
+#define SNOOZE_MAX          (30)
 
 //------------------------------------------------------------------------------
 //     ___      __   ___  __   ___  ___  __
@@ -129,28 +180,67 @@ typedef enum {
   TIMER_LCD,
   TIMER_FSM,
   TIMER_ALM,
+  TIMER_STATS,
+  TIMER_BLE,
   NUM_TIMERS
 } timers_t;
 
 typedef enum {
   MENU_DATE,
-  MENU_SET_DATE_HR,
-  MENU_SET_DATE_MIN,
-  MENU_SET_DATE_SEC,
-  MENU_SET_DATE_YR,
-  MENU_SET_DATE_MO,
-  MENU_SET_DATE_DY,
+  MENU_SET_DATE,
   MENU_ALM,
-  MENU_SET_ALM_HR,
-  MENU_SET_ALM_MIN,
+  MENU_SET_ALM,
+  MENU_PREFS,
   NUM_STATES,
 } fsm_t;
 
+// Value slots of the editing screens
+typedef enum {
+  DATE_HR,
+  DATE_MIN,
+  DATE_SEC,
+  DATE_YR,
+  DATE_MO,
+  DATE_DY,
+  NUM_DATE_FIELDS
+} date_fields_t;
+
+typedef enum {
+  ALM_HR,
+  ALM_MIN,
+  ALM_DAY,
+  ALM_SND = ALM_DAY + 7,
+  NUM_ALM_FIELDS
+} alarm_fields_t;
+
+typedef enum {
+  PREF_BACKLIGHT,
+  PREF_SNOOZE,
+  NUM_PREF_FIELDS
+} pref_fields_t;
+
 typedef enum {
   SET_ALARM,
   NUM_ITEMS
 } menu_items_t;
 
+// Display preferences, stored as one 32-bit value.
+typedef struct {
+  uint32_t backlight : 8;   // Backlight on-time, seconds
+  uint32_t snooze : 8;      // Snooze length, minutes
+  uint32_t : 16;
+} prefs_t;
+
+// Sync request handler. Fills in the reply payload and its length, and
+// returns 0 or a SYNC_ERR_* code.
+typedef uint8_t (*sync_fn_t)(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+
+typedef struct {
+  uint8_t len;              // Request payload length, SYNC_ANY_LEN to skip
+  sync_fn_t fn;
+} sync_handler_t;
+
 
 
 //------------------------------------------------------------------------------
@@ -159,16 +249,42 @@ typedef enum {
 //      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
 //
 //------------------------------------------------------------------------------
-static volatile uint8_t change_sleep_mode = 0;
-static uint32_t i;
 static RTC_DS3231 rtc_ext;
 static RTCZero rtc_int;
 static WatchdogSAMD wdt;
 static Adafruit_LiquidCrystal lcd(LCD_ADDR);
 static Adafruit_ADXL343 accel(ACCEL_ID);
 static Adafruit_BluefruitLE_SPI ble(PIN_BT_CS, PIN_BT_IRQ);
-static DateTime rtc_ext_time;
-static DateTime alarms[NUM_ALARMS];
+static cal_time_t cur_time;
+static uint8_t charging = 0;
+static uint8_t shaking = 0;
+static uint8_t time_changed = 0;
+static uint8_t menu_changed = 0;
+static uint8_t cur_alarm = 0;
+static uint8_t alarm_ringing = 0;
+static uint8_t alarm_armed = 0;
+static uint8_t alarm_rearmed = 0;
+static uint8_t alarm_dirty = 1;
+static uint8_t alarm_id = ALARM_NONE;
+static uint8_t alarm_sound = SOUND_BEEP;
+static const uint8_t button_pins[NUM_BUTTONS] = {
+  PIN_BTN_PLUS, PIN_BTN_MINUS, PIN_BTN_SEL, PIN_BTN_SET
+};
+static uint8_t btn_pressed = 0;
+static uint8_t btn_repeated = 0;
+static uint8_t btn_flush = 0;
+static uint64_t sys_time = 0;
+static uint64_t alarm_rearm_time;
+static uint32_t alarm_next_time = 0;
+static uint64_t lcd_timeout;
+static uint64_t ble_timeout = 0;
+static uint8_t ble_ready = 0;
+static uint8_t ble_on = 0;
+static sync_parser_t sync_rx;
+static char lcd_line_0[LCD_WIDTH + 1];
+static char lcd_line_1[LCD_WIDTH + 1];
+static prefs_t prefs;
+static uint32_t backlight_ms;
 
 //------------------------------------------------------------------------------
 //      __   __   __  ___  __  ___      __   ___  __
@@ -177,9 +293,169 @@ static DateTime alarms[NUM_ALARMS];
 //
 //------------------------------------------------------------------------------
 
-static char* to_weekday(uint8_t day_of_week);
-void button_isr();
-void rtc_isr();
+static void task_buttons(uint64_t now);
+static void task_rtc(uint64_t now);
+static void task_accel(uint64_t now);
+static void task_qi(uint64_t now);
+static void task_batt(uint64_t now);
+static void task_spkr(uint64_t now);
+static void task_led(uint64_t now);
+static void task_lcd(uint64_t now);
+static void task_fsm(uint64_t now);
+static void task_alm(uint64_t now);
+static void task_stats(uint64_t now);
+static void task_ble(uint64_t now);
+static void serial_frame(uint8_t type, const void *data, uint16_t len);
+static void sync_reply(uint64_t now);
+static uint8_t sync_hello(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_time_set(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_time_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_alarms_put(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_alarms_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_prefs_put(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_prefs_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static uint8_t sync_telemetry(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now);
+static void clock_draw(const int16_t *v, uint8_t changed);
+static void date_enter(int16_t *v);
+static void date_draw(const int16_t *v, uint8_t changed);
+static void date_commit(const int16_t *v, uint64_t now);
+static void date_step(int16_t *v, uint8_t field, int16_t n);
+static void alarm_view_draw(const int16_t *v, uint8_t changed);
+static void alarm_view_adjust(int8_t dir);
+static void alarm_enter(int16_t *v);
+static void alarm_draw(const int16_t *v, uint8_t changed);
+static void alarm_commit(const int16_t *v, uint64_t now);
+static void prefs_enter(int16_t *v);
+static void prefs_draw(const int16_t *v, uint8_t changed);
+static void prefs_commit(const int16_t *v, uint64_t now);
+static void alarm_program(uint8_t fired);
+static void alarm_cancel();
+static void alarm_save(uint8_t id, alarm_t a);
+static void prefs_save();
+static void calib_save();
+static void power_update(uint64_t now);
+static void display_on();
+static void display_off();
+static void settings_load(uint32_t now);
+static void alarm_lines(uint8_t id, alarm_t a);
+static alarm_t alarm_from(const int16_t *v);
+static void date_time(const int16_t *v, cal_time_t *t);
+
+//------------------------------------------------------------------------------
+//          ___          __
+//     |\/| |__  |\ | |  | /__`
+//     |  | |___ | \| \__/ .__/
+//
+//------------------------------------------------------------------------------
+
+#define FIELD_TIME          (MENU_WRAP | MENU_REPEAT)
+
+static const menu_field_t date_fields[NUM_DATE_FIELDS] = {
+  {CLOCK_HR_X, CLOCK_TIME_Y, 0, 23, 1, FIELD_TIME},
+  {CLOCK_MIN_X, CLOCK_TIME_Y, 0, 59, 1, FIELD_TIME},
+  {CLOCK_SEC_X, CLOCK_TIME_Y, 0, 59, 1, FIELD_TIME},
+  {CLOCK_YR_X, CLOCK_DATE_Y, 2000, 2099, 1, FIELD_TIME},
+  {CLOCK_MO_X, CLOCK_DATE_Y, 1, 12, 1, FIELD_TIME},
+  {CLOCK_DY_X, CLOCK_DATE_Y, 1, 31, 1, FIELD_TIME},
+};
+
+static const menu_field_t alarm_fields[NUM_ALM_FIELDS] = {
+  {ALM_HR_LCD_POS_X, ALM_LCD_POS_Y, 0, 23, 1, FIELD_TIME},
+  {ALM_MIN_LCD_POS_X, ALM_LCD_POS_Y, 0, 59, 1, FIELD_TIME},
+  {ALM_DAY_LCD_POS_X + 0, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 1, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 2, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 3, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 4, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 5, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_DAY_LCD_POS_X + 6, ALM_LCD_POS_Y, 0, 1, 1, MENU_WRAP},
+  {ALM_SND_LCD_POS_X, ALM_LCD_POS_Y, 0, NUM_SOUNDS - 1, 1, MENU_WRAP},
+};
+
+static const menu_field_t pref_fields[NUM_PREF_FIELDS] = {
+  {PREFS_LCD_POS_X, 0, BACKLIGHT_STEP, BACKLIGHT_MAX, BACKLIGHT_STEP,
+    MENU_REPEAT},
+  {PREFS_LCD_POS_X, 1, 1, SNOOZE_MAX, 1, MENU_REPEAT},
+};
+
+// Indexed by fsm_t. SEL walks MENU_DATE -> MENU_ALM -> MENU_PREFS; SET on a
+// view opens its editor and SET in an editor saves.
+static const menu_screen_t screens[NUM_STATES] = {
+  // MENU_DATE
+  {0, 0, MENU_ALM, MENU_SET_DATE, RTC_TIME_CHG_ALL | CHG_BATT,
+    0, clock_draw, 0, 0, 0},
+  // MENU_SET_DATE
+  {date_fields, NUM_DATE_FIELDS, MENU_STAY, MENU_DATE, 0,
+    date_enter, date_draw, date_commit, 0, date_step},
+  // MENU_ALM
+  {0, 0, MENU_PREFS, MENU_SET_ALM, 0,
+    0, alarm_view_draw, 0, alarm_view_adjust, 0},
+  // MENU_SET_ALM
+  {alarm_fields, NUM_ALM_FIELDS, MENU_STAY, MENU_ALM, 0,
+    alarm_enter, alarm_draw, alarm_commit, 0, 0},
+  // MENU_PREFS
+  {pref_fields, NUM_PREF_FIELDS, MENU_DATE, MENU_DATE, 0,
+    prefs_enter, prefs_draw, prefs_commit, 0, 0},
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __   ___         ___  __
+//     |__) |__) /  \ |__  | |    |__  /__`
+//     |    |  \ \__/ |    | |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Task periods in ms for each governor profile, in timers_t order. With the
+// display off nothing needs more than one update a second. The buttons and
+// the charger interrupt and run their own tasks, so they are GOV_KEEP
+// throughout. The radio only runs while the display is on or a sync is
+// under way, both of which are interactive.
+static const uint16_t profiles[GOV_NUM_PROFILES][NUM_TIMERS] = {
+  // GOV_INTERACTIVE
+  {GOV_KEEP, RTC_UPDATE_TIME, ACCEL_UPDATE_TIME, GOV_KEEP,
+    BATT_UPDATE_TIME, SPKR_UPDATE_TIME, LED_UPDATE_TIME, LCD_UPDATE_TIME,
+    FSM_UPDATE_TIME, ALM_UPDATE_TIME, STATS_UPDATE_TIME, BLE_UPDATE_TIME},
+  // GOV_IDLE: alarm close, keep its latency down
+  {GOV_KEEP, 250, 250, GOV_KEEP, 30000, 250, 250, 1000, 250, 50, 500, 1000},
+  // GOV_NIGHT
+  {GOV_KEEP, 1000, 1000, GOV_KEEP, 60000, 1000, 1000, 1000, 1000, 1000, 1000,
+    1000},
+  // GOV_RINGING
+  {GOV_KEEP, RTC_UPDATE_TIME, ACCEL_UPDATE_TIME, GOV_KEEP,
+    BATT_UPDATE_TIME, SPKR_UPDATE_TIME, LED_UPDATE_TIME, LCD_UPDATE_TIME,
+    FSM_UPDATE_TIME, ALM_UPDATE_TIME, STATS_UPDATE_TIME, 1000},
+  // GOV_LOW_BATT: as night; the DS3231 interrupt starts the alarm check
+  {GOV_KEEP, 1000, 1000, GOV_KEEP, 60000, 1000, 2000, 1000, 1000, 1000, 2000,
+    1000},
+};
+
+//------------------------------------------------------------------------------
+//      __            __
+//     /__` \ / |\ | /  `
+//     .__/  |  | \| \__,
+//
+//------------------------------------------------------------------------------
+
+// Sync request handlers, indexed by request type
+static const sync_handler_t sync_handlers[SYNC_NUM_TYPES] = {
+  {0, 0},
+  {0, sync_hello},
+  {SYNC_ANY_LEN, sync_time_set},
+  {0, sync_time_get},
+  {SYNC_ANY_LEN, sync_alarms_put},
+  {2, sync_alarms_get},
+  {sizeof(uint32_t), sync_prefs_put},
+  {0, sync_prefs_get},
+  {0, sync_telemetry},
+};
 
 //------------------------------------------------------------------------------
 //      __        __          __
@@ -191,562 +467,359 @@ void rtc_isr();
 //==============================================================================
 void setup() {
   // System and driver initialization
+  Serial.begin(SERIAL_BAUD);
   rtc_ext.begin();
   rtc_int.begin();
+  systime_begin();
   lcd.begin(LCD_WIDTH, LCD_HEIGHT);
   accel.begin(ACCEL_ADDR);
   //wdt.enable(5000);
 
   //Pin configuration
-  pinMode(PIN_BTN_PLUS, INPUT);
-  pinMode(PIN_BTN_MINUS, INPUT);
-  pinMode(PIN_BTN_SEL, INPUT);
-  pinMode(PIN_BTN_SET, INPUT);
-
-  pinMode(PIN_QI_CHG, INPUT);
-  pinMode(PIN_BATT_LOW, INPUT);
+  buttons_begin(button_pins, NUM_BUTTONS);
+  charger_begin(PIN_QI_CHG);
+  charging = charger_on();
 
   pinMode(PIN_ACCEL_IRQ1, INPUT);
   pinMode(PIN_ACCEL_IRQ2, INPUT);
 
   pinMode(PIN_LED_WAIT, OUTPUT);
-  pinMode(PIN_BUZZER, OUTPUT);
 
   
   // Output configuration
   digitalWrite(PIN_LED_WAIT, LOW);
   lcd.setBacklight(HIGH);
+  lcd_fb_begin(LCD_ADDR);
 
   // RTC configuration
-  rtc_ext_time = rtc_ext.now();
-  rtc_int.setDate(rtc_ext_time.day(), rtc_ext_time.month(), rtc_ext_time.year());
-  rtc_int.setTime(rtc_ext_time.hour(), rtc_ext_time.minute(), rtc_ext_time.second());
-  rtc_int.setAlarmSeconds((rtc_int.getSeconds() + 1) % 60);
-  rtc_int.enableAlarm(rtc_int.MATCH_SS);
+  rtc_time_begin(&rtc_ext, &rtc_int, PIN_RTC_INT, systime_ms());
+  cur_time = rtc_time_now();
+  stats_reset(rtc_time_epoch(), millis());
+  trace_reset();
+
+  // I2C from here on goes through the transaction queue, not Wire
+  i2c_begin();
 
   // Alarm initialization
-  for(i = 0; i < NUM_ALARMS; i++) {
-    alarms[i] = rtc_ext_time;
-  }
+  alarm_t alarm_tmp;
+  alarm_tmp.minute = cur_time.hour * 60 + cur_time.minute;
+  alarm_tmp.days = ALARM_DAYS_ALL;
+  alarm_tmp.enabled = 0;
+  alarm_tmp.sound = 0;
+  alarms_begin(alarm_tmp);
+
+  // Buzzer
+  sound_begin(PIN_BUZZER);
+
+  // Battery gauge
+  battery_begin(PIN_BATT_LOW, BATT_FULL_SCALE_MV);
+
+  // Stored alarms, preferences and clock calibration
+  store_begin();
+  settings_load(rtc_time_epoch());
+  menu_begin(screens, MENU_DATE);
 
   // Accelerometer initialization
-  accel.writeRegister(ADXL343_REG_ACT_INACT_CTL, 0xE6);
-  accel.writeRegister(ADXL343_REG_THRESH_ACT, 0x10);
-  union int_config cfg;
-  cfg.value = 0x10;
-  accel.enableInterrupts(cfg);
-  cfg.value = 0x00;
-  accel.mapInterrupts(cfg);
+  motion_begin(ACCEL_ADDR, PIN_ACCEL_IRQ2);
+
+  // Bluefruit comes up advertising; task_ble() stops it with the display
+  ble_ready = ble.begin();
+  if(ble_ready) {
+    ble.echo(false);
+    ble.setMode(BLUEFRUIT_MODE_DATA);
+    ble_on = 1;
+  }
+  sync_reset(&sync_rx);
+
+  // Power states and the interrupts that end a sleep
+  power_begin(&rtc_int);
+  power_hooks(POWER_ACTIVE, display_on, display_off);
+  power_wake(STATS_WAKE_BUTTON, buttons_pending, TIMER_BUTTONS);
+  power_wake(STATS_WAKE_TICK, rtc_time_pending, TIMER_RTC);
+  power_wake(STATS_WAKE_ALARM, rtc_time_pending, TIMER_RTC);
+  power_wake(STATS_WAKE_ACCEL, motion_pending, TIMER_ACCEL);
+  power_wake(STATS_WAKE_QI, charger_pending, TIMER_QI);
+
+  // Task registration
+  sys_time = systime_ms();
+  sched_add(TIMER_BUTTONS, SCHED_IDLE_FOREVER, task_buttons, sys_time);
+  sched_add(TIMER_RTC, RTC_UPDATE_TIME, task_rtc, sys_time);
+  sched_add(TIMER_ACCEL, ACCEL_UPDATE_TIME, task_accel, sys_time);
+  sched_add(TIMER_QI, SCHED_IDLE_FOREVER, task_qi, sys_time);
+  sched_add(TIMER_BATT, BATT_UPDATE_TIME, task_batt, sys_time);
+  sched_add(TIMER_SPKR, SPKR_UPDATE_TIME, task_spkr, sys_time);
+  sched_add(TIMER_LED, LED_UPDATE_TIME, task_led, sys_time);
+  sched_add(TIMER_LCD, LCD_UPDATE_TIME, task_lcd, sys_time);
+  sched_add(TIMER_FSM, FSM_UPDATE_TIME, task_fsm, sys_time);
+  sched_add(TIMER_ALM, ALM_UPDATE_TIME, task_alm, sys_time);
+  sched_add(TIMER_STATS, STATS_UPDATE_TIME, task_stats, sys_time);
+  sched_add(TIMER_BLE, BLE_UPDATE_TIME, task_ble, sys_time);
+  gov_begin(profiles[0], NUM_TIMERS, GOV_INTERACTIVE);
 }
 
 //==============================================================================
 // Infinite loop of science!
 //==============================================================================
 void loop() {
-  // Local Variables.
-  static uint8_t sleep_mode = 0;
-  static uint8_t charging = 0;
-  static uint8_t shaking = 0;
-  static uint8_t cur_alarm = 0;
-  static uint8_t alarm_ringing = 0;
-  static uint8_t alarm_armed = 0;
-  static uint8_t alarm_rearmed = 0;
-  static uint8_t alarms_en[NUM_ALARMS];
-  static uint8_t buttons[NUM_BUTTONS];
-  static uint8_t buttons_d[NUM_BUTTONS];
-  static uint8_t buttons_risen[NUM_BUTTONS];
-  static uint32_t sys_time_tmp = 0;
-  static uint64_t sys_time = 0;
-  static uint64_t delta = 0;
-  static uint64_t update_time = 0;
-  static uint64_t alarm_rearm_time;
-  static uint64_t lcd_timeout;
-  static uint64_t timers[NUM_TIMERS];
-  static char* lcd_line_0 = new char[16];
-  static char* lcd_line_1 = new char[16];
-  static fsm_t fsm_state = MENU_DATE;
-  static DateTime time_tmp;
-  static TimeSpan offset;
-
-  // Get current millis() value and update 64-bit counter.
-  if(millis() != sys_time_tmp) {
-    sys_time_tmp = millis();
-    if(sys_time_tmp < (sys_time & 0x00000000FFFFFFFF)) {
-      sys_time = ((sys_time & 0xFFFFFFFF00000000) | sys_time_tmp) +
-        0x0000000100000000;
-    }
-    else {
-      sys_time = (sys_time & 0xFFFFFFFF00000000) | sys_time_tmp;
-    }
-  }
+  sys_time = systime_ms();
+
+  // Finish the I2C transaction on the bus and start the next, then run
+  // whatever is due, retune the task periods and the power state to the
+  // state that left, and sleep until anything else is due or an interrupt.
+  // Events from a wake source make its task due at once, as does a display
+  // update the full queue put off. Nothing here waits for the bus.
+  i2c_poll();
+  power_poll();
+  if(lcd_fb_pending()) sched_trigger(TIMER_LCD);
+  sched_run(sys_time);
+  power_update(sys_time);
+  power_sleep(sched_idle(sys_time));
+}
 
-  delta = sys_time - timers[TIMER_BUTTONS];
-  if(delta >= BUTTON_UPDATE_TIME) {
-    timers[TIMER_BUTTONS] = sys_time;
 
-    for(i = 0; i < NUM_BUTTONS; i++) {
-      buttons_d[i] = buttons[i];
-      if(buttons[i]) lcd_timeout = sys_time + LCD_TIMEOUT;
+//------------------------------------------------------------------------------
+//     ___       __        __
+//      |   /\  /__` |__/ /__`
+//      |  /~~\ .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Takes the queued button events and hands them to the menu on this pass.
+// Runs when the ISR queues an event, and while a button is held, when its
+// next long-press or repeat is due; otherwise never.
+//==============================================================================
+static void task_buttons(uint64_t now) {
+  buttons_event_t e;
+
+  while(buttons_read(&e, now)) {
+    if(e.type == BUTTONS_RELEASE) continue;
+    if(e.type == BUTTONS_PRESS) btn_pressed |= 1 << e.button;
+    if(e.type == BUTTONS_REPEAT || e.type == BUTTONS_LONG) {
+      btn_repeated |= 1 << e.button;
     }
+    lcd_timeout = now + backlight_ms;
+  }
+  if(btn_pressed || btn_repeated) sched_trigger(TIMER_FSM);
+  sched_set_period(TIMER_BUTTONS, buttons_due(now));
+}
+
+//==============================================================================
+// Picks up the current time from the time service. Changes are latched until
+// the alarm check has seen them. Runs on each tick; a DS3231 alarm runs the
+// alarm check on the same pass.
+//==============================================================================
+static void task_rtc(uint64_t now) {
+  uint8_t changed = rtc_time_update(now);
+
+  time_changed |= changed;
+  menu_changed |= changed;
+  cur_time = rtc_time_now();
+  if(changed & RTC_TIME_ALARM) sched_trigger(TIMER_ALM);
+  if(changed & RTC_TIME_CALIB) calib_save();
+}
 
-    buttons[BTN_PLUS] = digitalRead(PIN_BTN_PLUS);
-    buttons[BTN_MINUS] = digitalRead(PIN_BTN_MINUS);
-    buttons[BTN_SEL] = digitalRead(PIN_BTN_SEL);
-    buttons[BTN_SET] = digitalRead(PIN_BTN_SET);
+//==============================================================================
+// Handles accelerometer interrupts. Samples are only streamed while the
+// alarm rings; otherwise any movement just wakes the display.
+//==============================================================================
+static void task_accel(uint64_t now) {
+  uint8_t motion;
 
-    for(i = 0; i < NUM_BUTTONS; i++) {
-      buttons_risen[i] = buttons[i] && !buttons_d[i];
-    }
+  motion_arm(alarm_ringing);
+  motion = motion_update();
+  if(motion) lcd_timeout = now + backlight_ms;
+  shaking = (motion & MOTION_SHAKE) ? 1 : 0;
+}
 
+//==============================================================================
+// Takes charger changes from its interrupt. Going on the pad silences the
+// alarm on this pass rather than at the next alarm check. Runs on an edge,
+// and once more if the pin bounced, when it has settled; otherwise never.
+//==============================================================================
+static void task_qi(uint64_t now) {
+  if(charger_update(now)) {
+    charging = charger_on();
+    if(charging) alarm_cancel();
   }
+  sched_set_period(TIMER_QI, charger_due(now));
+}
 
-  delta = sys_time - timers[TIMER_RTC];
-  if(delta >= RTC_UPDATE_TIME) {
-    timers[TIMER_RTC] = sys_time;
-    rtc_ext_time = rtc_ext.now();
+//==============================================================================
+// Measures the battery and updates the gauge on the clock face.
+//==============================================================================
+static void task_batt(uint64_t now) {
+  if(battery_update()) menu_changed |= CHG_BATT;
+}
+
+//==============================================================================
+// Starts and stops the alarm sound with the alarm and steps its volume ramp.
+// The notes themselves play from the timers.
+//==============================================================================
+static void task_spkr(uint64_t now) {
+  static uint64_t last = 0;
+
+  if(alarm_ringing && !sound_playing()) sound_start(alarm_sound, now);
+  else if(!alarm_ringing && sound_playing()) sound_stop();
+  else if(sound_playing()) stats_load(STATS_LOAD_BUZZER, now - last);
+
+  if(alarm_ringing) {
+    sound_update(now);
+    lcd_timeout = now + backlight_ms;
   }
+  last = now;
+}
 
-  delta = sys_time - timers[TIMER_ACCEL];
-  if(delta >= ACCEL_UPDATE_TIME) {
-    timers[TIMER_ACCEL] = sys_time;
-    if(accel.getX() > 100) {
-      shaking = 1;
-      lcd_timeout = sys_time + LCD_TIMEOUT;
-    }
-    else {
-      shaking = 0;
-    }
+//==============================================================================
+// Lights the wait LED while an alarm is armed.
+//==============================================================================
+static void task_led(uint64_t now) {
+  if(alarm_armed || alarm_rearmed) {
+    digitalWrite(PIN_LED_WAIT, HIGH);
   }
-  
-  delta = sys_time - timers[TIMER_QI];
-  if(delta >= QI_UPDATE_TIME) {
-    timers[TIMER_QI] = sys_time;
-    charging = !digitalRead(PIN_QI_CHG);
+  else {
+    digitalWrite(PIN_LED_WAIT, LOW);
   }
+}
 
-  delta = sys_time - timers[TIMER_BATT];
-  if(delta >= BATT_UPDATE_TIME) {
-    timers[TIMER_BATT] = sys_time;
-  }
+//==============================================================================
+// Pushes changed cells of the line buffers to the display and counts
+// backlight on-time; the POWER_ACTIVE hooks switch it. The first flush after
+// a button is traced.
+//==============================================================================
+static void task_lcd(uint64_t now) {
+  static uint64_t last = 0;
+  uint8_t cells;
 
-  delta = sys_time - timers[TIMER_SPKR];
-  if(delta >= SPKR_UPDATE_TIME) {
-    timers[TIMER_SPKR] = sys_time;
-    if(alarm_ringing) {
-      tone(PIN_BUZZER, 440, 50);
-      lcd_timeout = sys_time + LCD_TIMEOUT;
-    }
+  if(power_state() == POWER_ACTIVE && last) {
+    stats_load(STATS_LOAD_BACKLIGHT, now - last);
   }
+  lcd_fb_write(0, lcd_line_0);
+  lcd_fb_write(1, lcd_line_1);
+  cells = lcd_fb_flush();
+  if(btn_flush && !lcd_fb_deferred()) {
+    trace_log(TRACE_LCD_FLUSH, cells);
+    btn_flush = 0;
+  }
+  last = now;
+}
 
-  delta = sys_time - timers[TIMER_LED];
-  if(delta >= LED_UPDATE_TIME) {
-    if(alarm_armed || alarm_rearmed) {
-      digitalWrite(PIN_LED_WAIT, HIGH);
-    }
-    else {
-      digitalWrite(PIN_LED_WAIT, LOW);
-    }
+//==============================================================================
+// Feeds button events and time changes to the menu. A screen changed by a
+// button goes out to the display on the same pass.
+//==============================================================================
+static void task_fsm(uint64_t now) {
+  menu_update(btn_pressed, btn_repeated, menu_changed, now);
+  if(btn_pressed || btn_repeated) {
+    sched_trigger(TIMER_LCD);
+    btn_flush = 1;
   }
+  btn_pressed = 0;
+  btn_repeated = 0;
+  menu_changed = 0;
+}
 
-  delta = sys_time - timers[TIMER_LCD];
-  if(delta >= LCD_UPDATE_TIME) {
-    timers[TIMER_LCD] = sys_time;
-    lcd.noCursor();
-    lcd.setCursor(0, 0);
-    lcd.print(lcd_line_0);
-    lcd.setCursor(0, 1);
-    lcd.print(lcd_line_1);
-    if(sys_time < lcd_timeout) {
-      if(sleep_mode) change_sleep_mode = 1;
-      lcd.setBacklight(HIGH);
-    }
-    else {
-      if(!sleep_mode) change_sleep_mode = 1;
-      lcd.setBacklight(LOW);
-    }
+//==============================================================================
+// Starts the alarm when the DS3231 reports it fired, keeps the DS3231 loaded
+// with the next one and handles shake and charge.
+//==============================================================================
+static void task_alm(uint64_t now) {
+  if((time_changed & RTC_TIME_ALARM) && !alarm_armed) {
+    alarm_sound = alarms_get(alarm_id).sound;
+    lcd_timeout = now + backlight_ms;
+    alarm_armed = 1;
+    alarm_rearmed = 0;
+    alarm_ringing = 1;
+    trace_log(TRACE_ALARM_RING, alarm_id);
+  }
+  if(alarm_dirty || (time_changed & RTC_TIME_ALARM)) {
+    alarm_program(time_changed & RTC_TIME_ALARM);
+    alarm_dirty = 0;
   }
+  time_changed = 0;
+  if(shaking && alarm_ringing && !alarm_rearmed) {
+    alarm_ringing = 0;
+    alarm_rearmed = 1;
+    alarm_rearm_time = now + prefs.snooze * MINUTE_MS;
+    trace_log(TRACE_ALARM_QUIET, TRACE_BY_SHAKE);
+  }
+  if((now >= alarm_rearm_time) && alarm_rearmed && !alarm_ringing) {
+    alarm_ringing = 1;
+    trace_log(TRACE_ALARM_RING, TRACE_SNOOZE);
+  }
+  if(charging) alarm_cancel();
 
-  delta = sys_time - timers[TIMER_FSM];
-  if(delta >= FSM_UPDATE_TIME) {
-    timers[TIMER_FSM] = sys_time;
-    switch(fsm_state) {
-      case MENU_DATE:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          rtc_ext_time.hour(), rtc_ext_time.minute(), rtc_ext_time.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(rtc_ext_time.dayOfTheWeek()), rtc_ext_time.year(),
-          rtc_ext_time.month(), rtc_ext_time.day());
-        // sprintf_P(lcd_line_1, "x:%.2dy:%.2dz:%.2d",
-        //   accel.getX(), accel.getY(), accel.getZ());
-        if(buttons_risen[BTN_SET]) {
-          time_tmp = rtc_ext_time;
-          fsm_state = MENU_SET_DATE_HR;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_ALM;
-        }
-        break;
-      case MENU_SET_DATE_HR:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(HR_LCD_POS_X, TIME_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(HOUR);
-          time_tmp = time_tmp + offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(HOUR);
-          time_tmp = time_tmp - offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_MIN;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
-        break;
-      case MENU_SET_DATE_MIN:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(MIN_LCD_POS_X, TIME_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(MINUTE);
-          time_tmp = time_tmp + offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(MINUTE);
-          time_tmp = time_tmp - offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_SEC;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
-        break;
-      case MENU_SET_DATE_SEC:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(SEC_LCD_POS_X, TIME_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(SECOND);
-          time_tmp = time_tmp + offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(SECOND);
-          time_tmp = time_tmp - offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_YR;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
-        break;
-      case MENU_SET_DATE_YR:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(YR_LCD_POS_X, DATE_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          if(time_tmp.year() < 2099) {
-            time_tmp = DateTime(time_tmp.year() + 1, time_tmp.month(),
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(2000, time_tmp.month(),
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          if(time_tmp.year() > 2000) {
-            time_tmp = DateTime(time_tmp.year() - 1, time_tmp.month(),
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(2099, time_tmp.month(),
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_MO;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
-        break;
-      case MENU_SET_DATE_MO:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(MO_LCD_POS_X, DATE_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          if(time_tmp.month() < 12) {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month() + 1,
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(time_tmp.year(), 0,
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          if(time_tmp.month() > 1) {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month() - 1,
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(time_tmp.year(), 12,
-              time_tmp.day(), time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_DY;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
-        break;
-      case MENU_SET_DATE_DY:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          time_tmp.hour(), time_tmp.minute(), time_tmp.second());
-        sprintf_P(lcd_line_1, " %s %.4d-%.2d-%.2d ",
-          to_weekday(time_tmp.dayOfTheWeek()), time_tmp.year(),
-          time_tmp.month(), time_tmp.day());
-        lcd.setCursor(DY_LCD_POS_X, DATE_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          if(time_tmp.month() < 31) {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month(),
-              time_tmp.day() + 1, time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month(),
-              1, time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          if(time_tmp.day() > 1) {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month(),
-              time_tmp.day() - 1, time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          else {
-            time_tmp = DateTime(time_tmp.year(), time_tmp.month(),
-              31, time_tmp.hour(),
-              time_tmp.minute(), time_tmp.second());
-          }
-          
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_DATE_HR;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          rtc_ext.adjust(time_tmp);
-          lcd.noCursor();
-          fsm_state = MENU_DATE;
-        }
+  // Start or stop the sound now rather than on the next ramp step.
+  if(alarm_ringing != sound_playing()) sched_trigger(TIMER_SPKR);
+}
+
+
+//==============================================================================
+// Answers stats and trace requests on the USB serial port. See
+// tools/stats_decode.py and tools/trace_decode.py for the host side.
+//==============================================================================
+static void task_stats(uint64_t now) {
+  const stats_t *s;
+  uint64_t wall_ms;
+  uint32_t ua;
+
+  while(Serial.available()) {
+    switch(Serial.read()) {
+      case CMD_SNAPSHOT:
+        serial_frame(FRAME_STATS,
+          stats_get(rtc_time_epoch(), millis()), sizeof(stats_t));
         break;
-      case MENU_ALM:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          rtc_ext_time.hour(), rtc_ext_time.minute(), rtc_ext_time.second());
-        sprintf_P(lcd_line_1, "Alrm %d %.2d:%.2d %s",
-          cur_alarm + 1, alarms[cur_alarm].hour(), alarms[cur_alarm].minute(),
-          alarms_en[cur_alarm] ? "on " : "off");
-        if(buttons_risen[BTN_PLUS]) {
-          cur_alarm = (cur_alarm + 1) % NUM_ALARMS;
-        }
-        else if(buttons_risen[BTN_MINUS]) {
-          alarms_en[cur_alarm] = !alarms_en[cur_alarm];
-        }
-        else if(buttons_risen[BTN_SET]) {
-          time_tmp = alarms[cur_alarm];
-          fsm_state = MENU_SET_ALM_HR;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_DATE;
-        }
+      case CMD_TRACE:
+        serial_frame(FRAME_TRACE, trace_get(), sizeof(trace_t));
         break;
-      case MENU_SET_ALM_HR:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          rtc_ext_time.hour(), rtc_ext_time.minute(), rtc_ext_time.second());
-        sprintf_P(lcd_line_1, "Alrm %d %.2d:%.2d %s",
-          cur_alarm + 1, time_tmp.hour(), time_tmp.minute(),
-          alarms_en[cur_alarm] ? "on " : "off");
-        lcd.setCursor(ALM_HR_LCD_POS_X, ALM_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(HOUR - time_tmp.second());
-          time_tmp = time_tmp + offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(HOUR - time_tmp.second());
-          time_tmp = time_tmp - offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_ALM_MIN;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          alarms[cur_alarm] = time_tmp;
-          lcd.noCursor();
-          fsm_state = MENU_ALM;
-        }
+      case CMD_ESTIMATE:
+        s = stats_get(rtc_time_epoch(), millis());
+        ua = stats_avg_ua(s);
+        wall_ms = (uint64_t)s->wall_s * 1000;
+        Serial.print("avg ");
+        Serial.print(ua);
+        Serial.print(" uA, ");
+        Serial.print(ua * 24 / 1000.0);
+        Serial.print(" mAh/day, ");
+        Serial.print(wall_ms > s->awake_ms ?
+          (wall_ms - s->awake_ms) * 100.0 / wall_ms : 0.0);
+        Serial.println("% in standby");
         break;
-      case MENU_SET_ALM_MIN:
-        sprintf_P(lcd_line_0, "    %.2d:%.2d:%.2d    ",
-          rtc_ext_time.hour(), rtc_ext_time.minute(), rtc_ext_time.second());
-        sprintf_P(lcd_line_1, "Alrm %d %.2d:%.2d %s",
-          cur_alarm + 1, time_tmp.hour(), time_tmp.minute(),
-          alarms_en[cur_alarm] ? "on " : "off");
-        lcd.setCursor(ALM_MIN_LCD_POS_X, ALM_LCD_POS_Y);
-        lcd.cursor();
-
-        if(buttons_risen[BTN_PLUS] ||
-          (buttons[BTN_PLUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(MINUTE - time_tmp.second());
-          time_tmp = time_tmp + offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        if(buttons_risen[BTN_MINUS] ||
-          (buttons[BTN_MINUS] && (sys_time >= update_time))) {
-          offset = TimeSpan(MINUTE - time_tmp.second());
-          time_tmp = time_tmp - offset;
-          update_time = sys_time + UPDATE_DELAY;
-        }
-        else if(buttons_risen[BTN_SEL]) {
-          fsm_state = MENU_SET_ALM_HR;
-        }
-        else if(buttons_risen[BTN_SET]) {
-          alarms[cur_alarm] = time_tmp;
-          lcd.noCursor();
-          fsm_state = MENU_ALM;
-        }
+      case CMD_RESET:
+        stats_reset(rtc_time_epoch(), millis());
+        trace_reset();
         break;
     }
   }
+}
 
-  delta = sys_time - timers[TIMER_ALM];
-  if(delta >= ALM_UPDATE_TIME) {
-    timers[TIMER_ALM] = sys_time;
-    for(i = 0; i < NUM_ALARMS; i++) {
-      if(alarms_en[i] && (rtc_ext_time.hour() == alarms[i].hour()) &&
-        (rtc_ext_time.minute() == alarms[i].minute()) &&
-        (rtc_ext_time.second() <= alarms[i].second() + 2)&& !alarm_armed) {
-          lcd_timeout = sys_time + LCD_TIMEOUT;
-          alarm_armed = 1;
-          alarm_rearmed = 0;
-          alarm_ringing = 1;
-        }
-    }
-    if(shaking && alarm_ringing && !alarm_rearmed) {
-      alarm_ringing = 0;
-      alarm_rearmed = 1;
-      alarm_rearm_time = sys_time + ALARM_REARM_DELAY;
-    }
-    if((sys_time >= alarm_rearm_time) && alarm_rearmed) {
-      alarm_ringing = 1;
+//==============================================================================
+// Keeps the radio up while the display is on or a sync is running, and
+// answers sync requests from the BLE UART. Each good frame holds the radio
+// up for another BLE_LINGER_MS.
+//==============================================================================
+static void task_ble(uint64_t now) {
+  uint8_t want = now < lcd_timeout || now < ble_timeout;
+
+  if(!ble_ready) return;
+  if(want != ble_on) {
+    if(want) {
+      ble.sendCommandCheckOK("AT+GAPSTARTADV");
     }
-    if(charging) {
-      alarm_armed = 0;
-      alarm_ringing = 0;
-      alarm_rearmed = 0;
+    else {
+      ble.sendCommandCheckOK("AT+GAPSTOPADV");
+      ble.sendCommandCheckOK("AT+GAPDISCONNECT");
+      sync_reset(&sync_rx);
     }
+    ble_on = want;
   }
 
-  if(sleep_mode) {
-    attachInterrupt(digitalPinToInterrupt(PIN_BTN_PLUS), button_isr, RISING);
-    attachInterrupt(digitalPinToInterrupt(PIN_BTN_MINUS), button_isr, RISING);
-    attachInterrupt(digitalPinToInterrupt(PIN_BTN_SEL), button_isr, RISING);
-    attachInterrupt(digitalPinToInterrupt(PIN_BTN_SET), button_isr, RISING);
-    rtc_int.setAlarmSeconds((rtc_int.getSeconds()) + 1 % 60);
-    rtc_int.standbyMode();
-  }
-  else {
-    detachInterrupt(digitalPinToInterrupt(PIN_BTN_PLUS));
-    detachInterrupt(digitalPinToInterrupt(PIN_BTN_MINUS));
-    detachInterrupt(digitalPinToInterrupt(PIN_BTN_SEL));
-    detachInterrupt(digitalPinToInterrupt(PIN_BTN_SET));
-    rtc_int.disableAlarm();
+  while(ble_on && ble.available()) {
+    if(sync_feed(&sync_rx, ble.read())) {
+      sync_reply(now);
+      ble_timeout = now + BLE_LINGER_MS;
+    }
   }
-  
 }
 
 
@@ -758,45 +831,526 @@ void loop() {
 //------------------------------------------------------------------------------
 
 //==============================================================================
-static char* to_weekday(uint8_t day_of_week) {
-  static char* weekday = new char[3];
-  switch(day_of_week) {
-    case 0:
-      sprintf_P(weekday, "Sun", 0);
-      break;
-    case 1:
-      sprintf_P(weekday, "Mon", 0);
-      break;
-    case 2:
-      sprintf_P(weekday, "Tue", 0);
-      break;
-    case 3:
-      sprintf_P(weekday, "Wed", 0);
-      break;
-    case 4:
-      sprintf_P(weekday, "Thu", 0);
-      break;
-    case 5:
-      sprintf_P(weekday, "Fri", 0);
-      break;
-    case 6:
-      sprintf_P(weekday, "Sat", 0);
-      break;
-  }
-  return weekday;
+// Clock face.
+//==============================================================================
+static void clock_draw(const int16_t *v, uint8_t changed) {
+  clock_face_draw(lcd_line_0, lcd_line_1, cur_time, changed);
+  if((changed & RTC_TIME_CHG_ALL) == RTC_TIME_CHG_ALL || (changed & CHG_BATT)) {
+    clock_face_battery(lcd_line_0, battery_percent(), battery_low());
+  }
 }
 
-//------------------------------------------------------------------------------
-//        __   __   __
-//     | /__` |__) /__`
-//     | .__/ |  \ .__/
+//==============================================================================
+// Date editor. Each field wraps on its own, the day at the end of the month
+// shown, and the weekday follows the date.
+//==============================================================================
+static void date_enter(int16_t *v) {
+  v[DATE_HR] = cur_time.hour;
+  v[DATE_MIN] = cur_time.minute;
+  v[DATE_SEC] = cur_time.second;
+  v[DATE_YR] = cur_time.year;
+  v[DATE_MO] = cur_time.month;
+  v[DATE_DY] = cur_time.day;
+}
+
+//==============================================================================
+static void date_draw(const int16_t *v, uint8_t changed) {
+  cal_time_t t;
+
+  date_time(v, &t);
+  clock_face_draw(lcd_line_0, lcd_line_1, t, MENU_DRAW_ALL);
+}
+
+//==============================================================================
+static void date_commit(const int16_t *v, uint64_t now) {
+  cal_time_t t;
+
+  date_time(v, &t);
+  rtc_time_set(cal_join(&t), now);
+  alarm_dirty = 1;
+}
+
+//==============================================================================
+static void date_step(int16_t *v, uint8_t field, int16_t n) {
+  static const uint8_t cal_fields[NUM_DATE_FIELDS] = {
+    CAL_HOUR, CAL_MINUTE, CAL_SECOND, CAL_YEAR, CAL_MONTH, CAL_DAY
+  };
+  cal_time_t t;
+
+  date_time(v, &t);
+  cal_step(&t, cal_fields[field], n);
+  v[DATE_YR] = t.year;
+  v[DATE_MO] = t.month;
+  v[DATE_DY] = t.day;
+  v[DATE_HR] = t.hour;
+  v[DATE_MIN] = t.minute;
+  v[DATE_SEC] = t.second;
+}
+
+//==============================================================================
+// Alarm list. PLUS shows the next alarm, MINUS turns this one on or off.
+//==============================================================================
+static void alarm_view_draw(const int16_t *v, uint8_t changed) {
+  alarm_lines(cur_alarm, alarms_get(cur_alarm));
+}
+
+//==============================================================================
+static void alarm_view_adjust(int8_t dir) {
+  alarm_t a;
+
+  if(dir > 0) {
+    cur_alarm = (cur_alarm + 1) % ALARM_MAX;
+  }
+  else {
+    a = alarms_get(cur_alarm);
+    a.enabled = !a.enabled;
+    alarm_save(cur_alarm, a);
+  }
+}
+
+//==============================================================================
+// Alarm editor: hour, minute, each weekday and sound.
+//==============================================================================
+static void alarm_enter(int16_t *v) {
+  alarm_t a = alarms_get(cur_alarm);
+  uint8_t d;
+
+  v[ALM_HR] = a.minute / 60;
+  v[ALM_MIN] = a.minute % 60;
+  for(d = 0; d < 7; d++) {
+    v[ALM_DAY + d] = (a.days >> d) & 1;
+  }
+  v[ALM_SND] = a.sound;
+}
+
+//==============================================================================
+static void alarm_draw(const int16_t *v, uint8_t changed) {
+  alarm_lines(cur_alarm, alarm_from(v));
+}
+
+//==============================================================================
+static void alarm_commit(const int16_t *v, uint64_t now) {
+  alarm_save(cur_alarm, alarm_from(v));
+}
+
+//==============================================================================
+// Display preferences.
+//==============================================================================
+static void prefs_enter(int16_t *v) {
+  v[PREF_BACKLIGHT] = prefs.backlight;
+  v[PREF_SNOOZE] = prefs.snooze;
+}
+
+//==============================================================================
+static void prefs_draw(const int16_t *v, uint8_t changed) {
+  // Both stay within the menu's limits; as bytes they fit the line.
+  sprintf_P(lcd_line_0, "Backlight %3u s ", (uint8_t)v[PREF_BACKLIGHT]);
+  sprintf_P(lcd_line_1, "Snooze    %3u m ", (uint8_t)v[PREF_SNOOZE]);
+}
+
+//==============================================================================
+static void prefs_commit(const int16_t *v, uint64_t now) {
+  prefs.backlight = v[PREF_BACKLIGHT];
+  prefs.snooze = v[PREF_SNOOZE];
+  backlight_ms = prefs.backlight * 1000ul;
+  prefs_save();
+}
+
+//==============================================================================
+// Sends a binary frame on the USB serial port for the host tools.
+//==============================================================================
+static void serial_frame(uint8_t type, const void *data, uint16_t len) {
+  uint16_t crc = crc16(data, len, CRC16_INIT);
+
+  Serial.write(FRAME_SYNC_0);
+  Serial.write(type);
+  Serial.write((const uint8_t *)&len, sizeof(len));
+  Serial.write((const uint8_t *)data, len);
+  Serial.write((const uint8_t *)&crc, sizeof(crc));
+}
+
+//==============================================================================
+// Runs the request in sync_rx and sends its reply or a NAK.
+//==============================================================================
+static void sync_reply(uint64_t now) {
+  static uint8_t frame[SYNC_MAX_FRAME];
+  uint8_t out[SYNC_MAX_PAYLOAD];
+  uint8_t out_len = 0;
+  uint8_t err = SYNC_ERR_TYPE;
+  const sync_handler_t *h;
+  uint16_t n;
+
+  if(sync_rx.type < SYNC_NUM_TYPES && sync_handlers[sync_rx.type].fn) {
+    h = &sync_handlers[sync_rx.type];
+    if(h->len != SYNC_ANY_LEN && h->len != sync_rx.len) {
+      err = SYNC_ERR_LENGTH;
+    }
+    else {
+      err = h->fn(sync_rx.payload, sync_rx.len, out, &out_len, now);
+    }
+  }
+
+  if(err) {
+    out[0] = sync_rx.type;
+    out[1] = err;
+    n = sync_frame(frame, SYNC_NAK, sync_rx.seq, out, 2);
+  }
+  else {
+    n = sync_frame(frame, sync_rx.type | SYNC_REPLY, sync_rx.seq, out,
+      out_len);
+  }
+  ble.write(frame, n);
+}
+
+//==============================================================================
+static uint8_t sync_hello(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  out[0] = SYNC_VERSION;
+  out[1] = ALARM_MAX;
+  out[2] = NUM_SOUNDS;
+  out[3] = 0;
+  *out_len = 4;
+  return 0;
+}
+
+//==============================================================================
+// With the milliseconds the phone's time also trims the DS3231; without, as
+// from a version 1 app, it only sets the clocks.
+//==============================================================================
+static uint8_t sync_time_set(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  uint32_t epoch;
+  uint16_t ms;
+
+  if(len != sizeof(epoch) && len != sizeof(epoch) + sizeof(ms)) {
+    return SYNC_ERR_LENGTH;
+  }
+  memcpy(&epoch, in, sizeof(epoch));
+  if(epoch < CAL_EPOCH_MIN || epoch > CAL_EPOCH_MAX) return SYNC_ERR_RANGE;
+  if(len == sizeof(epoch)) {
+    rtc_time_set(epoch, now);
+  }
+  else {
+    memcpy(&ms, in + sizeof(epoch), sizeof(ms));
+    if(ms >= 1000) return SYNC_ERR_RANGE;
+    rtc_time_sync(epoch, ms, now);
+  }
+  alarm_dirty = 1;
+  return 0;
+}
+
+//==============================================================================
+static uint8_t sync_time_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  uint32_t epoch = rtc_time_epoch();
+
+  memcpy(out, &epoch, sizeof(epoch));
+  *out_len = sizeof(epoch);
+  return 0;
+}
+
+//==============================================================================
+// Checks every record before storing any, so a bad upload changes nothing.
+//==============================================================================
+static uint8_t sync_alarms_put(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  uint8_t first, count;
+  alarm_t a;
+  uint8_t k;
+
+  if(len < 2) return SYNC_ERR_LENGTH;
+  first = in[0];
+  count = in[1];
+  if(len != 2 + count * sizeof(alarm_t)) return SYNC_ERR_LENGTH;
+  if(first + count > ALARM_MAX) return SYNC_ERR_RANGE;
+  for(k = 0; k < count; k++) {
+    memcpy(&a, in + 2 + k * sizeof(a), sizeof(a));
+    if(a.minute >= ALARM_MINUTES || a.sound >= NUM_SOUNDS) {
+      return SYNC_ERR_RANGE;
+    }
+  }
+  for(k = 0; k < count; k++) {
+    memcpy(&a, in + 2 + k * sizeof(a), sizeof(a));
+    alarm_save(first + k, a);
+  }
+  return 0;
+}
+
+//==============================================================================
+static uint8_t sync_alarms_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  const uint8_t first = in[0];
+  const uint8_t count = in[1];
+  alarm_t a;
+  uint8_t k;
+
+  if(first + count > ALARM_MAX ||
+    2 + count * sizeof(alarm_t) > SYNC_MAX_PAYLOAD) {
+    return SYNC_ERR_RANGE;
+  }
+  out[0] = first;
+  out[1] = count;
+  for(k = 0; k < count; k++) {
+    a = alarms_get(first + k);
+    memcpy(out + 2 + k * sizeof(a), &a, sizeof(a));
+  }
+  *out_len = 2 + count * sizeof(alarm_t);
+  return 0;
+}
+
+//==============================================================================
+// Takes the same values the preferences screen allows.
+//==============================================================================
+static uint8_t sync_prefs_put(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  prefs_t p;
+
+  memcpy(&p, in, sizeof(p));
+  if(p.backlight < BACKLIGHT_STEP || p.backlight > BACKLIGHT_MAX ||
+    p.backlight % BACKLIGHT_STEP || !p.snooze || p.snooze > SNOOZE_MAX) {
+    return SYNC_ERR_RANGE;
+  }
+  prefs = p;
+  backlight_ms = prefs.backlight * 1000ul;
+  prefs_save();
+  return 0;
+}
+
+//==============================================================================
+static uint8_t sync_prefs_get(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  memcpy(out, &prefs, sizeof(prefs));
+  *out_len = sizeof(prefs);
+  return 0;
+}
+
+//==============================================================================
+static uint8_t sync_telemetry(const uint8_t *in, uint8_t len, uint8_t *out,
+  uint8_t *out_len, uint64_t now) {
+  sync_telemetry_t t;
+  const stats_t *s;
+
+  t.epoch = rtc_time_epoch();
+  s = stats_get(t.epoch, millis());
+  t.uptime_s = s->wall_s;
+  t.avg_ua = stats_avg_ua(s);
+  t.batt_mv = battery_mv();
+  t.batt_pct = battery_percent();
+  t.flags = 0;
+  if(battery_low()) t.flags |= SYNC_TEL_LOW_BATT;
+  if(charging) t.flags |= SYNC_TEL_CHARGING;
+  if(alarm_ringing) t.flags |= SYNC_TEL_RINGING;
+  t.profile = gov_profile();
+  t.next_alarm = alarm_id;
+  memcpy(out, &t, sizeof(t));
+  *out_len = sizeof(t);
+  return 0;
+}
+
+//==============================================================================
+// Loads the DS3231 with the next alarm due.
 //
-//------------------------------------------------------------------------------
+// param fired  Nonzero if called for the alarm that just fired.
+//==============================================================================
+static void alarm_program(uint8_t fired) {
+  uint32_t next;
+
+  // The internal RTC can be up to a second off the DS3231, so right after a
+  // fire step past it rather than searching from "now".
+  if(fired) {
+    alarms_advance();
+  }
+  else {
+    alarms_seek(rtc_time_epoch());
+  }
+
+  next = alarms_next(&alarm_id);
+  if(next) {
+    rtc_time_set_alarm(next);
+  }
+  else {
+    rtc_time_clear_alarm();
+  }
+  alarm_next_time = next;
+}
+
+//==============================================================================
+// Drops a ringing or snoozed alarm for the clock going on the charger, and
+// stops the sound on this pass.
+//==============================================================================
+static void alarm_cancel() {
+  if(alarm_ringing) trace_log(TRACE_ALARM_QUIET, TRACE_BY_CHARGER);
+  alarm_armed = 0;
+  alarm_ringing = 0;
+  alarm_rearmed = 0;
+  if(sound_playing()) sched_trigger(TIMER_SPKR);
+}
+
+//==============================================================================
+// Updates an alarm in the index and in flash.
+//==============================================================================
+static void alarm_save(uint8_t id, alarm_t a) {
+  uint32_t raw;
 
+  alarms_set(id, a, rtc_time_epoch());
+  memcpy(&raw, &a, sizeof(raw));
+  store_put(KEY_ALARM + id, raw);
+  alarm_dirty = 1;
+}
+
+//==============================================================================
+// Writes the display preferences to flash.
 //==============================================================================
-void button_isr() {
-  change_sleep_mode = 1;
+static void prefs_save() {
+  uint32_t raw;
+
+  memcpy(&raw, &prefs, sizeof(raw));
+  store_put(KEY_PREFS, raw);
 }
-void rtc_isr() {
 
-}
\ No newline at end of file
+//==============================================================================
+// Writes the clock calibration to flash. Unchanged halves are not written.
+//==============================================================================
+static void calib_save() {
+  uint32_t raw[CALIB_WORDS];
+  uint8_t k;
+
+  memcpy(raw, calib_coef(), sizeof(raw));
+  for(k = 0; k < CALIB_WORDS; k++) store_put(KEY_CALIB + k, raw[k]);
+}
+
+//==============================================================================
+// Restores alarms, preferences and the clock calibration from flash.
+// Anything never stored keeps its default.
+//
+// param now  Current time as Unix time.
+//==============================================================================
+static void settings_load(uint32_t now) {
+  uint32_t raw, calib_raw[CALIB_WORDS];
+  alarm_t a;
+  calib_coef_t c;
+  uint8_t id, k;
+
+  for(id = 0; id < ALARM_MAX; id++) {
+    if(!store_get(KEY_ALARM + id, &raw)) continue;
+    memcpy(&a, &raw, sizeof(a));
+    alarms_set(id, a, now);
+  }
+
+  prefs.backlight = BACKLIGHT_DEFAULT;
+  prefs.snooze = SNOOZE_DEFAULT;
+  if(store_get(KEY_PREFS, &raw)) memcpy(&prefs, &raw, sizeof(prefs));
+  if(!prefs.backlight) prefs.backlight = BACKLIGHT_DEFAULT;
+  if(!prefs.snooze) prefs.snooze = SNOOZE_DEFAULT;
+  backlight_ms = prefs.backlight * 1000ul;
+
+  for(k = 0; k < CALIB_WORDS; k++) {
+    if(!store_get(KEY_CALIB + k, &calib_raw[k])) break;
+  }
+  if(k == CALIB_WORDS) {
+    memcpy(&c, calib_raw, sizeof(c));
+    calib_begin(&c);
+  }
+  else {
+    calib_begin(0);
+  }
+}
+
+//==============================================================================
+// Hands the governor the state it picks a power profile from, and picks the
+// power state: lit while the backlight timeout runs, idle while the radio or
+// the buzzer is on, otherwise standby.
+//==============================================================================
+static void power_update(uint64_t now) {
+  gov_state_t s;
+  uint32_t epoch = rtc_time_epoch();
+  uint32_t snooze;
+
+  if(now < lcd_timeout) {
+    power_set(POWER_ACTIVE);
+  }
+  else if(ble_on || now < ble_timeout || alarm_ringing || sound_playing()) {
+    power_set(POWER_IDLE);
+  }
+  else {
+    power_set(POWER_STANDBY);
+  }
+
+  s.display_on = now < lcd_timeout || now < ble_timeout;
+  s.ringing = alarm_ringing;
+  s.charging = charging;
+  s.battery_low = battery_low();
+  s.alarm_in = GOV_NO_ALARM;
+  if(alarm_next_time > epoch) s.alarm_in = alarm_next_time - epoch;
+  if(alarm_rearmed) {
+    snooze = alarm_rearm_time > now ? (alarm_rearm_time - now) / 1000 : 0;
+    if(snooze < s.alarm_in) s.alarm_in = snooze;
+  }
+  gov_update(&s);
+}
+
+//==============================================================================
+// POWER_ACTIVE hooks. The backlight change goes out on the next pass, before
+// the core can sleep.
+//==============================================================================
+static void display_on() {
+  lcd_fb_backlight(HIGH);
+  sched_trigger(TIMER_LCD);
+}
+
+//==============================================================================
+static void display_off() {
+  lcd_fb_backlight(LOW);
+  sched_trigger(TIMER_LCD);
+}
+
+//==============================================================================
+// Formats an alarm as
+//   Alarm 01     on
+//   07:30 -MTWTF- s0
+//==============================================================================
+static void alarm_lines(uint8_t id, alarm_t a) {
+  static const char days[] = "SMTWTFS";
+  char mask[8];
+  uint8_t d;
+
+  for(d = 0; d < 7; d++) {
+    mask[d] = (a.days & (1 << d)) ? days[d] : '-';
+  }
+  mask[7] = 0;
+
+  // Id and sound bounded so gcc can see the lines fit
+  sprintf_P(lcd_line_0, "Alarm %.2u     %s", id % ALARM_MAX + 1,
+    a.enabled ? "on " : "off");
+  sprintf_P(lcd_line_1, "%.2u:%.2u %s s%u", a.minute / 60,
+    a.minute % 60, mask, a.sound % NUM_SOUNDS);
+}
+
+//==============================================================================
+// Builds an alarm record from the alarm editor's values.
+//==============================================================================
+static alarm_t alarm_from(const int16_t *v) {
+  alarm_t a = alarms_get(cur_alarm);
+  uint8_t d;
+
+  a.minute = v[ALM_HR] * 60 + v[ALM_MIN];
+  a.days = 0;
+  for(d = 0; d < 7; d++) {
+    if(v[ALM_DAY + d]) a.days |= 1 << d;
+  }
+  a.sound = v[ALM_SND];
+  return a;
+}
+
+//==============================================================================
+// Editor values as a time, weekday included.
+//==============================================================================
+static void date_time(const int16_t *v, cal_time_t *t) {
+  t->year = v[DATE_YR];
+  t->month = v[DATE_MO];
+  t->day = v[DATE_DY];
+  t->hour = v[DATE_HR];
+  t->minute = v[DATE_MIN];
+  t->second = v[DATE_SEC];
+  t->wday = cal_weekday(t->year, t->month, t->day);
+}
@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+// Getup! Menu Engine
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "lcd_fb.h"
+#include "menu.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const menu_screen_t *screens = 0;
+static const menu_screen_t *screen = 0;
+static uint8_t field = 0;
+static int16_t values[MENU_MAX_VALUES];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void go(uint8_t id);
+static void leave(uint8_t id, uint64_t now);
+static void step(int8_t dir);
+static void draw(uint8_t changed);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void menu_begin(const menu_screen_t *table, uint8_t first) {
+  screens = table;
+  go(first);
+}
+
+//==============================================================================
+void menu_update(uint8_t pressed, uint8_t repeated, uint8_t changed,
+  uint64_t now) {
+  int8_t dir = 0;
+
+  if(pressed & MENU_PLUS) {
+    dir = 1;
+  }
+  else if(pressed & MENU_MINUS) {
+    dir = -1;
+  }
+  else if((repeated & (MENU_PLUS | MENU_MINUS)) && screen->num_fields &&
+    (screen->fields[field].flags & MENU_REPEAT)) {
+    dir = (repeated & MENU_PLUS) ? 1 : -1;
+  }
+
+  if(dir) {
+    if(screen->num_fields) {
+      step(dir);
+    }
+    else if(screen->adjust) {
+      screen->adjust(dir);
+    }
+  }
+  else if(pressed & MENU_SEL) {
+    if(field + 1 < screen->num_fields) {
+      field++;
+    }
+    else if(screen->next == MENU_STAY) {
+      field = 0;
+    }
+    else {
+      leave(screen->next, now);
+      return;
+    }
+  }
+  else if(pressed & MENU_SET) {
+    leave(screen->done, now);
+    return;
+  }
+  else {
+    changed &= screen->live;
+    if(changed) draw(changed);
+    return;
+  }
+  draw(MENU_DRAW_ALL);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static void go(uint8_t id) {
+  screen = &screens[id];
+  field = 0;
+  if(screen->enter) screen->enter(values);
+  draw(MENU_DRAW_ALL);
+}
+
+//==============================================================================
+// Commits the current screen and moves on.
+//==============================================================================
+static void leave(uint8_t id, uint64_t now) {
+  if(screen->commit) screen->commit(values, now);
+  go(id);
+}
+
+//==============================================================================
+static void step(int8_t dir) {
+  const menu_field_t *f = &screen->fields[field];
+  int16_t v;
+
+  if(screen->step) {
+    screen->step(values, field, dir * f->step);
+    return;
+  }
+
+  v = values[field] + dir * f->step;
+
+  if(v > f->max) v = (f->flags & MENU_WRAP) ? f->min : f->max;
+  if(v < f->min) v = (f->flags & MENU_WRAP) ? f->max : f->min;
+  values[field] = v;
+}
+
+//==============================================================================
+static void draw(uint8_t changed) {
+  const menu_field_t *f;
+
+  if(screen->draw) screen->draw(values, changed);
+  if(screen->num_fields) {
+    f = &screen->fields[field];
+    lcd_fb_cursor(f->x, f->y);
+  }
+  else {
+    lcd_fb_no_cursor();
+  }
+}
@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------
+// Getup! Motion Sensing
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "i2c.h"
+#include "motion.h"
+#include "shake.h"
+#include "stats.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define POWER_MEASURE       (0x08)
+#define FIFO_BYPASS         (0x00)
+#define FIFO_STREAM         (0x80)
+#define FIFO_ENTRIES        (0x3F)
+// AC-coupled activity on X, Y and Z
+#define ACT_AC_XYZ          (0xF0)
+#define INT_ALL_TO_INT2     (0xFF)
+
+// INT_SOURCE bits
+#define INT_ACTIVITY        (0x10)
+#define INT_WATERMARK       (0x02)
+
+#define SAMPLE_BYTES        (6)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t accel_addr = 0;
+static uint8_t pin = 0;
+static uint8_t armed = 0;
+static volatile uint8_t irq_pending = 0;
+static shake_t detector;
+
+// Interrupt service in progress on the I2C queue, and what it found
+static uint8_t busy = 0;
+static uint8_t found = 0;
+static uint8_t left = 0;
+static uint8_t rx[SAMPLE_BYTES];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void configure(uint8_t on);
+static void write_reg(uint8_t reg, uint8_t value);
+static uint8_t read_regs(uint8_t reg, uint8_t len, i2c_done_t cb);
+static void source_done(void *ctx, uint8_t err);
+static void fifo_done(void *ctx, uint8_t err);
+static void sample_done(void *ctx, uint8_t err);
+static void next_sample();
+void motion_isr();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void motion_begin(uint8_t addr, uint8_t irq_pin) {
+  accel_addr = addr;
+  pin = irq_pin;
+
+  write_reg(ADXL343_REG_ACT_INACT_CTL, ACT_AC_XYZ);
+  write_reg(ADXL343_REG_THRESH_ACT, MOTION_ACT_THRESH);
+
+  // INT1 shares EXTINT2 with the Qi charger pin on the Zero, so everything
+  // goes out on INT2.
+  write_reg(ADXL343_REG_INT_MAP, INT_ALL_TO_INT2);
+
+  configure(0);
+  read_regs(ADXL343_REG_INT_SOURCE, 1, 0);
+
+  pinMode(pin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(pin), motion_isr, RISING);
+}
+
+//==============================================================================
+void motion_arm(uint8_t on) {
+  on = on ? 1 : 0;
+  if(on == armed) return;
+  configure(on);
+  armed = on;
+}
+
+//==============================================================================
+uint8_t motion_update() {
+  uint8_t flags;
+
+  // INT2 stays high until the source is read, so a missed edge still shows.
+  if(!busy && (irq_pending || digitalRead(pin))) {
+    irq_pending = 0;
+    busy = read_regs(ADXL343_REG_INT_SOURCE, 1, source_done);
+  }
+
+  flags = found;
+  found = 0;
+  return flags;
+}
+
+//==============================================================================
+uint8_t motion_pending() {
+  return found != 0 || (irq_pending && !busy);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Reprograms rate, FIFO and interrupt sources. The part is put in standby
+// while this happens so the FIFO restarts clean.
+//==============================================================================
+static void configure(uint8_t on) {
+  write_reg(ADXL343_REG_POWER_CTL, 0);
+  if(on) {
+    shake_init(&detector);
+    write_reg(ADXL343_REG_BW_RATE, MOTION_ARMED_RATE);
+    write_reg(ADXL343_REG_FIFO_CTL, FIFO_STREAM | MOTION_BATCH);
+    write_reg(ADXL343_REG_INT_ENABLE, INT_WATERMARK);
+  }
+  else {
+    write_reg(ADXL343_REG_BW_RATE, MOTION_IDLE_RATE);
+    write_reg(ADXL343_REG_FIFO_CTL, FIFO_BYPASS);
+    write_reg(ADXL343_REG_INT_ENABLE, INT_ACTIVITY);
+  }
+  write_reg(ADXL343_REG_POWER_CTL, POWER_MEASURE);
+}
+
+//==============================================================================
+// Queues a register write. A full queue drops it; there is room for a
+// whole configure() whenever the other users keep to their own limits.
+//==============================================================================
+static void write_reg(uint8_t reg, uint8_t value) {
+  uint8_t buf[2] = {reg, value};
+
+  i2c_write(accel_addr, buf, sizeof(buf), I2C_PRIO_HIGH, 0, 0, 0);
+}
+
+//==============================================================================
+// Queues a read into rx.
+//
+// return  Nonzero if queued.
+//==============================================================================
+static uint8_t read_regs(uint8_t reg, uint8_t len, i2c_done_t cb) {
+  return i2c_read(accel_addr, reg, rx, len, I2C_PRIO_HIGH, cb, 0);
+}
+
+//==============================================================================
+// INT_SOURCE is in, which also released INT2. A watermark goes on to read
+// how many samples the FIFO holds.
+//==============================================================================
+static void source_done(void *ctx, uint8_t err) {
+  uint8_t src = rx[0];
+
+  (void)ctx;
+  busy = 0;
+  if(err) return;
+  if(src & INT_ACTIVITY) found |= MOTION_ACTIVITY;
+  if(armed && (src & INT_WATERMARK)) {
+    busy = read_regs(ADXL343_REG_FIFO_STATUS, 1, fifo_done);
+  }
+}
+
+//==============================================================================
+static void fifo_done(void *ctx, uint8_t err) {
+  (void)ctx;
+  left = err ? 0 : rx[0] & FIFO_ENTRIES;
+  next_sample();
+}
+
+//==============================================================================
+// One sample into the shake classifier, then the next.
+//==============================================================================
+static void sample_done(void *ctx, uint8_t err) {
+  int16_t x, y, z;
+
+  (void)ctx;
+  if(err) {
+    left = 0;
+  }
+  else {
+    x = (int16_t)(rx[0] | (rx[1] << 8));
+    y = (int16_t)(rx[2] | (rx[3] << 8));
+    z = (int16_t)(rx[4] | (rx[5] << 8));
+    if(shake_feed(&detector, x, y, z)) {
+      if(!(found & MOTION_SHAKE)) trace_log(TRACE_SHAKE, 0);
+      found |= MOTION_SHAKE;
+    }
+    left--;
+  }
+  next_sample();
+}
+
+//==============================================================================
+// Empties the FIFO one 6-byte read per sample; the ADXL343 pops an entry
+// only once all three axes of it have been read. Each read is queued from
+// the last one's callback, so the batch never blocks the loop.
+//==============================================================================
+static void next_sample() {
+  busy = left && read_regs(ADXL343_REG_DATAX0, SAMPLE_BYTES, sample_done);
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// ADXL343 INT2, rising edge.
+//==============================================================================
+void motion_isr() {
+  stats_irq(STATS_WAKE_ACCEL);
+  irq_pending = 1;
+}
@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+// Getup! Power States
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "power.h"
+#include "i2c.h"
+#include "scheduler.h"
+#include "stats.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Generic clock generator for the EIC in standby; ArduinoLowPower uses the
+// same one
+#define EIC_GCLK            (6)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef struct {
+  power_pending_fn pending;
+  uint8_t source;
+  uint8_t task;
+} wake_t;
+
+typedef struct {
+  power_hook_fn enter;
+  power_hook_fn exit;
+} hooks_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static RTCZero *rtc = 0;
+static uint8_t state = POWER_ACTIVE;
+static wake_t wakes[POWER_MAX_WAKE];
+static uint8_t num_wakes = 0;
+static hooks_t hooks[POWER_NUM_STATES];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t pending();
+static void standby();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void power_begin(RTCZero *in) {
+  rtc = in;
+  state = POWER_ACTIVE;
+
+#ifndef GETUP_NATIVE
+  // The EIC runs from GCLK0, which stops in standby and takes edge detection
+  // with it. Move it to the ultra-low-power 32 kHz oscillator instead.
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(EIC_GCLK) | GCLK_GENCTRL_SRC_OSCULP32K |
+    GCLK_GENCTRL_GENEN | GCLK_GENCTRL_RUNSTDBY;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_EIC | GCLK_CLKCTRL_GEN(EIC_GCLK) |
+    GCLK_CLKCTRL_CLKEN;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+
+  // Errata: the flash must not power all the way down in sleep.
+  NVMCTRL->CTRLB.bit.SLEEPPRM = NVMCTRL_CTRLB_SLEEPPRM_DISABLED_Val;
+#endif
+}
+
+//==============================================================================
+void power_wake(uint8_t source, power_pending_fn pending, uint8_t task) {
+  uint8_t n;
+
+  for(n = 0; n < num_wakes && wakes[n].source != source; n++);
+  if(n == num_wakes) {
+    if(num_wakes >= POWER_MAX_WAKE) return;
+    num_wakes++;
+  }
+  wakes[n].pending = pending;
+  wakes[n].source = source;
+  wakes[n].task = task;
+}
+
+//==============================================================================
+void power_hooks(uint8_t s, power_hook_fn enter, power_hook_fn exit) {
+  if(s >= POWER_NUM_STATES) return;
+  hooks[s].enter = enter;
+  hooks[s].exit = exit;
+}
+
+//==============================================================================
+uint8_t power_poll() {
+  uint8_t n, any = 0;
+
+  for(n = 0; n < num_wakes; n++) {
+    if(wakes[n].pending()) {
+      sched_trigger(wakes[n].task);
+      any = 1;
+    }
+  }
+  return any;
+}
+
+//==============================================================================
+void power_set(uint8_t s) {
+  if(s >= POWER_NUM_STATES || s == state) return;
+  if(hooks[state].exit) hooks[state].exit();
+  state = s;
+  if(hooks[state].enter) hooks[state].enter();
+}
+
+//==============================================================================
+uint8_t power_state() {
+  return state;
+}
+
+//==============================================================================
+void power_sleep(uint32_t idle_ms) {
+  uint32_t halt_us;
+
+  if(!idle_ms) return;
+
+  // An interrupt between the check and the halt would leave its event
+  // waiting for the next wake, a whole second away in standby. With
+  // interrupts masked the halt still ends on one, and its ISR runs as they
+  // come back on.
+  __disable_irq();
+  if(pending()) {
+    __enable_irq();
+    return;
+  }
+
+  // Standby would stop SERCOM3 mid-transaction, so the queue drains first.
+  if(state == POWER_STANDBY && idle_ms >= POWER_STANDBY_MIN_MS &&
+    i2c_idle()) {
+    standby();
+    __enable_irq();
+    return;
+  }
+
+  halt_us = micros();
+  __WFI();
+  __enable_irq();
+  stats_idle(micros() - halt_us);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Nonzero if any wake source has events its task has not taken.
+//==============================================================================
+static uint8_t pending() {
+  uint8_t n;
+
+  for(n = 0; n < num_wakes; n++) {
+    if(wakes[n].pending()) return 1;
+  }
+  return 0;
+}
+
+//==============================================================================
+// Standby until an interrupt. Called with interrupts masked.
+//==============================================================================
+static void standby() {
+  stats_standby();
+
+#ifndef GETUP_NATIVE
+  // A SysTick interrupt landing as the core goes down can leave it stuck in
+  // standby; ArduinoLowPower masks it for the same reason.
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+#endif
+  rtc->standbyMode();
+#ifndef GETUP_NATIVE
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+#endif
+}
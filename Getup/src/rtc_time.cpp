@@ -0,0 +1,633 @@
+//------------------------------------------------------------------------------
+// Getup! Time Service
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <string.h>
+#include "calendar.h"
+#include "calib.h"
+#include "i2c.h"
+#include "rtc_time.h"
+#include "stats.h"
+#include "systime.h"
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// DS3231 control: INTCN with both alarms off, and Alarm1 interrupt enable.
+// Clearing INTCN and RS puts the 1 Hz square wave on INT/SQW.
+#define CTRL_IDLE           (DS3231_OFF)
+#define CTRL_A1IE           (0x01)
+#define CTRL_SQW_OFF        (DS3231_OFF)
+#define STATUS_A1F          (0x01)
+
+#define TIME_REGS           (7)
+
+// A measurement reads the time through the status register
+#define MEASURE_REGS        (DS3231_STATUSREG + 1)
+
+// Measurement states
+#define MEASURE_IDLE        (0)
+#define MEASURE_EDGES       (1)   // Square wave on, waiting for a DS3231 second
+#define MEASURE_READ        (2)   // Read and control restore queued
+
+// Square wave falling edges this close to a second apart are DS3231
+// seconds; the first after switching it on may not be. Seconds to wait for
+// one before reading the DS3231 without.
+#define EDGE_SLACK          (SYSTIME_HZ / 64)
+#define EDGE_TIMEOUT        (4)
+
+// The time registers still hold the edge's second this long after it
+#define READ_LATE           (SYSTIME_HZ / 2)
+
+// aging_set before the first write
+#define AGING_UNKNOWN       (0x7FFF)
+
+// Reference comparison: ms into the RTC's second when no tick has been
+// stamped since a seed, and the largest difference worth counting, s
+#define SYNC_FRAC_UNKNOWN   (500)
+#define SYNC_SECS_MAX       (86400L)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static RTC_DS3231 *rtc_ext = 0;
+static RTCZero *rtc_int = 0;
+static cal_time_t cur_time;
+static uint32_t cur_epoch = 0;
+static uint32_t resync_epoch = 0;
+static uint64_t last_tick = 0;
+static uint8_t changed_pending = 0;
+static volatile uint8_t ticks = 0;
+static volatile uint8_t alarm_fired = 0;
+
+// systime of the latest tick, and the internal RTC's second that it began
+// unless ticks are pending
+static volatile uint64_t tick_stamp = 0;
+static uint32_t stamp_epoch = 0;
+static uint8_t stamp_ok = 0;
+
+// DS3231 control as the alarm wants it
+static uint8_t ctrl = CTRL_IDLE;
+
+// Measurement of the internal RTC against the DS3231 on the I2C queue
+static volatile uint8_t measure = MEASURE_IDLE;
+static volatile uint8_t edge_taken = 0;
+static volatile uint64_t edge_stamp = 0;
+static uint64_t edge_at = 0;
+static uint8_t edge_ok = 0;
+static uint8_t measure_void = 0;
+static uint32_t measure_until = 0;
+static uint64_t measure_now = 0;
+static int16_t step = 0;
+static uint8_t raw[MEASURE_REGS];
+
+// A falling edge during the read may have been the alarm; A1F decides once
+// INT is the alarm's again, unless the read already found it.
+static volatile uint8_t alarm_held = 0;
+static uint8_t a1f_seen = 0;
+static uint8_t held_status;
+
+// Trims as last applied, and coefficients as last reported
+static int8_t freqcorr_set = 0;
+static int16_t aging_set = AGING_UNKNOWN;
+static calib_coef_t coef_seen;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t set_epoch(uint32_t epoch);
+static void arm_tick(uint32_t epoch);
+static uint32_t seed(uint32_t epoch, uint64_t now);
+static void set_time(uint32_t epoch, uint64_t now);
+static void measure_start(uint32_t epoch);
+static void measure_read(uint64_t now);
+static void measure_done(void *ctx, uint8_t err);
+static void measure_end(void *ctx, uint8_t err);
+static void alarm_check(void *ctx, uint8_t err);
+static void trim();
+static void set_freqcorr(int8_t value);
+static void write_ctrl(uint8_t value);
+static void write_regs(const uint8_t *buf, uint8_t len);
+static void write_reg(uint8_t reg, uint8_t value);
+static uint8_t bcd(uint8_t v);
+static uint8_t unbcd(uint8_t v);
+void rtc_time_isr();
+void rtc_time_alarm_isr();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void rtc_time_begin(RTC_DS3231 *ext, RTCZero *in, uint8_t int_pin,
+  uint64_t now) {
+  rtc_ext = ext;
+  rtc_int = in;
+
+  set_epoch(seed(rtc_ext->now().unixtime(), now));
+  resync_epoch = cur_epoch + calib_interval();
+  rtc_int->attachInterrupt(rtc_time_isr);
+  rtc_int->enableAlarm(rtc_int->MATCH_SS);
+
+  // Start with INT released so the first alarm gives a clean falling edge.
+  rtc_ext->writeSqwPinMode(DS3231_OFF);
+  rtc_ext->disableAlarm(1);
+  rtc_ext->disableAlarm(2);
+  rtc_ext->clearAlarm(1);
+  rtc_ext->clearAlarm(2);
+  pinMode(int_pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(int_pin), rtc_time_alarm_isr, FALLING);
+}
+
+//==============================================================================
+uint8_t rtc_time_update(uint64_t now) {
+  uint8_t n, edge, changed;
+  uint32_t epoch = cur_epoch;
+
+  noInterrupts();
+  n = ticks;
+  ticks = 0;
+  edge = edge_taken;
+  edge_taken = 0;
+  edge_at = edge_stamp;
+  if(alarm_fired) {
+    alarm_fired = 0;
+    changed_pending |= RTC_TIME_ALARM;
+  }
+  interrupts();
+
+  // Release INT so the next alarm can pull it low again.
+  if(changed_pending & RTC_TIME_ALARM) write_reg(DS3231_STATUSREG, 0);
+
+  if(n) {
+    epoch += n;
+
+    // The second has only just begun, so a step cannot race the next.
+    if(step) {
+      epoch += step;
+      rtc_int->setEpoch(epoch);
+      step = 0;
+    }
+    stamp_epoch = epoch;
+    stamp_ok = 1;
+    last_tick = now;
+    arm_tick(epoch);
+  }
+  else if(now - last_tick >= RTC_TIME_TICK_LATE) {
+    // The alarm was re-armed after its second had already passed and will
+    // not match again for a minute. Catch up from the counter itself.
+    epoch = rtc_int->getEpoch();
+    stamp_ok = 0;
+    last_tick = now;
+    arm_tick(epoch);
+  }
+
+  // The read finishes on a later pass; measure_done() takes it from there.
+  if(measure == MEASURE_EDGES && (edge || epoch >= measure_until)) {
+    edge_ok = edge;
+    measure_read(now);
+  }
+  else if(measure == MEASURE_IDLE && epoch >= resync_epoch) {
+    measure_start(epoch);
+  }
+
+  trim();
+  changed = set_epoch(epoch) | changed_pending;
+  changed_pending = 0;
+  return changed;
+}
+
+//==============================================================================
+uint8_t rtc_time_pending() {
+  return ticks != 0 || alarm_fired || edge_taken;
+}
+
+//==============================================================================
+const cal_time_t &rtc_time_now() {
+  return cur_time;
+}
+
+//==============================================================================
+uint32_t rtc_time_epoch() {
+  return cur_epoch;
+}
+
+//==============================================================================
+void rtc_time_set(uint32_t epoch, uint64_t now) {
+  calib_unreferenced();
+  set_time(epoch, now);
+}
+
+//==============================================================================
+// The internal RTC stands in for the DS3231: the calibration keeps its
+// second within a few tens of ms of the DS3231's, and the systime since its
+// latest tick gives the rest. Right after a seed there is no tick to go by
+// yet and the middle of the second is assumed.
+//==============================================================================
+void rtc_time_sync(uint32_t epoch, uint16_t ms, uint64_t now) {
+  uint32_t at = cur_epoch;
+  int32_t secs, err;
+  int16_t frac = SYNC_FRAC_UNKNOWN, after;
+  uint8_t up = ms >= 500;
+
+  noInterrupts();
+  if(stamp_ok) {
+    at = stamp_epoch + ticks;
+    frac = (systime_ticks() - tick_stamp) * 1000 / SYSTIME_HZ;
+  }
+  interrupts();
+
+  // Far enough off for the calibration to count as lost either way
+  secs = (int32_t)(at - epoch);
+  if(secs > SYNC_SECS_MAX) secs = SYNC_SECS_MAX;
+  if(secs < -SYNC_SECS_MAX) secs = -SYNC_SECS_MAX;
+
+  err = secs * 1000 + frac - ms;
+  after = up ? 1000 - ms : -ms;
+  if(calib_reference(err, after, epoch)) set_time(epoch + up, now);
+}
+
+//==============================================================================
+void rtc_time_resync() {
+  resync_epoch = 0;
+}
+
+//==============================================================================
+// Alarm1 mask bits all clear: match seconds, minutes, hours and date.
+//==============================================================================
+void rtc_time_set_alarm(uint32_t when) {
+  cal_time_t t;
+  uint8_t buf[5];
+
+  cal_split(when, &t);
+  buf[0] = DS3231_ALARM1;
+  buf[1] = bcd(t.second);
+  buf[2] = bcd(t.minute);
+  buf[3] = bcd(t.hour);
+  buf[4] = bcd(t.day);
+
+  write_reg(DS3231_STATUSREG, 0);
+  write_regs(buf, sizeof(buf));
+  write_ctrl(CTRL_IDLE | CTRL_A1IE);
+}
+
+//==============================================================================
+void rtc_time_clear_alarm() {
+  write_ctrl(CTRL_IDLE);
+  write_reg(DS3231_STATUSREG, 0);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Moves the cached time and reports which fields rolled over.
+//==============================================================================
+static uint8_t set_epoch(uint32_t epoch) {
+  uint8_t changed = 0;
+
+  if(epoch == cur_epoch) return 0;
+  changed |= RTC_TIME_CHG_SEC;
+  if(epoch / 60 != cur_epoch / 60) changed |= RTC_TIME_CHG_MIN;
+  if(epoch / 3600 != cur_epoch / 3600) changed |= RTC_TIME_CHG_HOUR;
+  if(epoch / 86400 != cur_epoch / 86400) changed |= RTC_TIME_CHG_DAY;
+
+  cur_epoch = epoch;
+  cal_split(epoch, &cur_time);
+  return changed;
+}
+
+//==============================================================================
+// Points the internal RTC alarm at the start of the next second.
+//==============================================================================
+static void arm_tick(uint32_t epoch) {
+  rtc_int->setAlarmSeconds((epoch + 1) % 60);
+}
+
+//==============================================================================
+// Re-seeds the internal RTC from DS3231 time. Going through the epoch keeps
+// the full year; setDate() only holds years since 2000. The RTC's second
+// keeps its phase, so it may trail the DS3231 by up to a second until the
+// next measurement.
+//
+// param epoch  DS3231 time as Unix time.
+// param now    System time in ms when it was read.
+// return  epoch.
+//==============================================================================
+static uint32_t seed(uint32_t epoch, uint64_t now) {
+  rtc_int->setEpoch(epoch);
+  last_tick = now;
+  stamp_ok = 0;
+  step = 0;
+  noInterrupts();
+  ticks = 0;
+  interrupts();
+  arm_tick(epoch);
+  calib_restart();
+  return epoch;
+}
+
+//==============================================================================
+// Sets both clocks and drops any measurement under way, whose DS3231 second
+// the write restarts.
+//==============================================================================
+static void set_time(uint32_t epoch, uint64_t now) {
+  cal_time_t t;
+  uint8_t buf[TIME_REGS + 1];
+
+  cal_split(epoch, &t);
+  buf[0] = DS3231_TIME;
+  buf[1] = bcd(t.second);
+  buf[2] = bcd(t.minute);
+  buf[3] = bcd(t.hour);
+  buf[4] = bcd(t.wday == 0 ? 7 : t.wday);
+  buf[5] = bcd(t.day);
+  buf[6] = bcd(t.month);
+  buf[7] = bcd(t.year - CAL_YEAR_MIN);
+
+  if(measure == MEASURE_EDGES) {
+    edge_ok = 0;
+    measure_read(now);
+  }
+  measure_void = 1;
+
+  // Also clears the oscillator-stopped flag, as RTClib's adjust() does.
+  write_regs(buf, sizeof(buf));
+  write_reg(DS3231_STATUSREG, 0);
+  changed_pending |= set_epoch(seed(cal_join(&t), now));
+  resync_epoch = cur_epoch + calib_interval();
+}
+
+//==============================================================================
+// Puts the 1 Hz square wave on INT/SQW. The alarm ISR takes its edges until
+// the control register is restored; an alarm that matches meanwhile is
+// left flagged for measure_done().
+//==============================================================================
+static void measure_start(uint32_t epoch) {
+  measure_void = 0;
+  a1f_seen = 0;
+  measure_until = epoch + EDGE_TIMEOUT;
+  noInterrupts();
+  edge_taken = 0;
+  edge_stamp = 0;
+  alarm_held = 0;
+  measure = MEASURE_EDGES;
+  interrupts();
+  write_reg(DS3231_CONTROL, ctrl & ~CTRL_SQW_OFF);
+}
+
+//==============================================================================
+// Reads the DS3231 in the second the edge began, if there was one, and
+// gives INT back to the alarm.
+//==============================================================================
+static void measure_read(uint64_t now) {
+  uint8_t buf[2];
+
+  measure = MEASURE_READ;
+  measure_now = now;
+  i2c_read(DS3231_ADDRESS, DS3231_TIME, raw, MEASURE_REGS, I2C_PRIO_HIGH,
+    measure_done, 0);
+  buf[0] = DS3231_CONTROL;
+  buf[1] = ctrl;
+  i2c_write(DS3231_ADDRESS, buf, sizeof(buf), I2C_PRIO_HIGH, 0, measure_end,
+    0);
+}
+
+//==============================================================================
+// The measurement read is in. Applied here rather than at the next
+// rtc_time_update(), which in the slower power profiles may be seconds away.
+// The internal RTC's time at the edge is its time at the latest tick plus
+// the systime since; the offset is the DS3231's time less that. Without an
+// edge, or one read too late, the internal RTC is seeded as before.
+//==============================================================================
+static void measure_done(void *ctx, uint8_t err) {
+  cal_time_t t;
+  uint32_t ext, epoch;
+  uint64_t stamp;
+  uint8_t n;
+  int32_t offset;
+
+  (void)ctx;
+  if(err || measure_void) {
+    resync_epoch = cur_epoch + CALIB_INTERVAL_FIRST;
+    return;
+  }
+
+  // An alarm that matched with the square wave on has not pulled INT.
+  if(raw[DS3231_STATUSREG] & STATUS_A1F) {
+    trace_log(TRACE_ALARM_IRQ, 0);
+    changed_pending |= RTC_TIME_ALARM;
+    a1f_seen = 1;
+  }
+
+  t.year = CAL_YEAR_MIN + unbcd(raw[6]);
+  t.month = unbcd(raw[5] & 0x7F);
+  t.day = unbcd(raw[4]);
+  t.hour = unbcd(raw[2] & 0x3F);
+  t.minute = unbcd(raw[1]);
+  t.second = unbcd(raw[0] & 0x7F);
+  ext = cal_join(&t);
+
+  noInterrupts();
+  n = ticks;
+  stamp = tick_stamp;
+  interrupts();
+
+  if(!edge_ok || !stamp_ok || systime_ticks() - edge_at > READ_LATE) {
+    changed_pending |= set_epoch(seed(ext, measure_now));
+    resync_epoch = ext + (edge_ok ? calib_interval() : RTC_TIME_RESYNC);
+    return;
+  }
+
+  epoch = stamp_epoch + n;
+  offset = (int32_t)(ext - epoch) * SYSTIME_HZ - (int32_t)(edge_at - stamp);
+  step = calib_measure(ext, offset);
+  resync_epoch = ext + calib_interval();
+}
+
+//==============================================================================
+// INT is the alarm's again. Retried until it is, since alarms cannot ring
+// through the square wave. A second that began during the read gave a
+// falling edge either way, so whether the alarm matched then is read back
+// from A1F.
+//==============================================================================
+static void measure_end(void *ctx, uint8_t err) {
+  uint8_t buf[2];
+  uint8_t held;
+
+  (void)ctx;
+  if(err) {
+    buf[0] = DS3231_CONTROL;
+    buf[1] = ctrl;
+    i2c_write(DS3231_ADDRESS, buf, sizeof(buf), I2C_PRIO_HIGH, 0,
+      measure_end, 0);
+    return;
+  }
+  noInterrupts();
+  measure = MEASURE_IDLE;
+  held = alarm_held;
+  alarm_held = 0;
+  interrupts();
+  if(held && !a1f_seen) {
+    i2c_read(DS3231_ADDRESS, DS3231_STATUSREG, &held_status, 1,
+      I2C_PRIO_HIGH, alarm_check, 0);
+  }
+}
+
+//==============================================================================
+// Status read for an edge the measurement held back. Retried until it is
+// in, as a missed alarm does not ring.
+//==============================================================================
+static void alarm_check(void *ctx, uint8_t err) {
+  (void)ctx;
+  if(err) {
+    i2c_read(DS3231_ADDRESS, DS3231_STATUSREG, &held_status, 1,
+      I2C_PRIO_HIGH, alarm_check, 0);
+    return;
+  }
+  if(held_status & STATUS_A1F) {
+    trace_log(TRACE_ALARM_IRQ, 0);
+    changed_pending |= RTC_TIME_ALARM;
+  }
+}
+
+//==============================================================================
+// Applies the calibration's trims as they change, and reports the
+// coefficients for storing when they do.
+//==============================================================================
+static void trim() {
+  const calib_coef_t *c = calib_coef();
+  int8_t freqcorr = calib_freqcorr();
+
+  if(freqcorr != freqcorr_set) {
+    set_freqcorr(freqcorr);
+    freqcorr_set = freqcorr;
+  }
+  if(c->aging != aging_set) {
+    write_reg(DS3231_AGINGREG, (uint8_t)c->aging);
+    aging_set = c->aging;
+  }
+  if(memcmp(c, &coef_seen, sizeof(coef_seen))) {
+    coef_seen = *c;
+    changed_pending |= RTC_TIME_CALIB;
+  }
+}
+
+//==============================================================================
+// RTCZero has no call for the frequency correction register. value is
+// positive to speed the RTC up, which the register does with SIGN set; a
+// correction with SIGN clear lowers the frequency.
+//==============================================================================
+static void set_freqcorr(int8_t value) {
+#ifdef GETUP_NATIVE
+  rtc_int->sim_freqcorr(-value);
+#else
+  RTC->MODE2.FREQCORR.reg = value > 0 ?
+    RTC_FREQCORR_SIGN | RTC_FREQCORR_VALUE(value) :
+    RTC_FREQCORR_VALUE(-value);
+  while(RTC->MODE2.STATUS.bit.SYNCBUSY);
+#endif
+}
+
+//==============================================================================
+// Sets the control register the alarm wants. With the square wave on, it
+// is written when the measurement restores it.
+//==============================================================================
+static void write_ctrl(uint8_t value) {
+  ctrl = value;
+  if(measure != MEASURE_EDGES) write_reg(DS3231_CONTROL, ctrl);
+}
+
+//==============================================================================
+// Queues a write to consecutive DS3231 registers, first register first.
+//==============================================================================
+static void write_regs(const uint8_t *buf, uint8_t len) {
+  i2c_write(DS3231_ADDRESS, buf, len, I2C_PRIO_HIGH, 0, 0, 0);
+}
+
+//==============================================================================
+static void write_reg(uint8_t reg, uint8_t value) {
+  uint8_t buf[2] = {reg, value};
+
+  write_regs(buf, sizeof(buf));
+}
+
+//==============================================================================
+static uint8_t bcd(uint8_t v) {
+  return v + 6 * (v / 10);
+}
+
+//==============================================================================
+static uint8_t unbcd(uint8_t v) {
+  return v - 6 * (v >> 4);
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Internal RTC alarm, once a second.
+//==============================================================================
+void rtc_time_isr() {
+  stats_irq(STATS_WAKE_TICK);
+  tick_stamp = systime_ticks();
+  ticks++;
+}
+
+//==============================================================================
+// DS3231 INT, falling edge: the alarm, or while measuring, the start of a
+// DS3231 second. Edges during the measurement read are held for
+// measure_end().
+//==============================================================================
+void rtc_time_alarm_isr() {
+  uint64_t t, since;
+
+  stats_irq(STATS_WAKE_ALARM);
+  if(measure == MEASURE_EDGES) {
+    t = systime_ticks();
+    since = t - edge_stamp;
+    if(since >= SYSTIME_HZ - EDGE_SLACK && since <= SYSTIME_HZ + EDGE_SLACK) {
+      edge_taken = 1;
+    }
+    edge_stamp = t;
+    return;
+  }
+  if(measure == MEASURE_READ) {
+    alarm_held = 1;
+    return;
+  }
+  trace_log(TRACE_ALARM_IRQ, 0);
+  alarm_fired = 1;
+}
@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+// Getup! Task Scheduler
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "scheduler.h"
+#include "profile.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define NOT_QUEUED          (0xFF)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef struct {
+  task_fn_t fn;
+  uint32_t period;
+  uint64_t deadline;
+  uint64_t last_run;
+  uint8_t period_changed;   // Set by sched_set_period() while the task runs
+} task_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static task_t tasks[SCHED_MAX_TASKS];
+static uint8_t heap[SCHED_MAX_TASKS];
+static uint8_t heap_pos[SCHED_MAX_TASKS];
+static uint8_t heap_len = 0;
+static uint8_t initialized = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t before(uint8_t a, uint8_t b);
+static void swap(uint8_t i, uint8_t j);
+static void sift_up(uint8_t i);
+static void sift_down(uint8_t i);
+static void requeue(uint8_t id);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void sched_add(uint8_t id, uint32_t period, task_fn_t fn, uint64_t now) {
+  uint8_t i;
+
+  if(!initialized) {
+    for(i = 0; i < SCHED_MAX_TASKS; i++) heap_pos[i] = NOT_QUEUED;
+    initialized = 1;
+  }
+  if(id >= SCHED_MAX_TASKS || !fn) return;
+
+  tasks[id].fn = fn;
+  tasks[id].period = period ? period : 1;
+  tasks[id].deadline = now;
+  tasks[id].last_run = now;
+
+  if(heap_pos[id] == NOT_QUEUED) {
+    heap[heap_len] = id;
+    heap_pos[id] = heap_len;
+    heap_len++;
+  }
+  requeue(id);
+}
+
+//==============================================================================
+void sched_set_period(uint8_t id, uint32_t period) {
+  if(id >= SCHED_MAX_TASKS || !tasks[id].fn) return;
+  if(!period) period = 1;
+  if(period == tasks[id].period) return;
+
+  tasks[id].period = period;
+  tasks[id].period_changed = 1;
+  tasks[id].deadline = tasks[id].last_run + period;
+  requeue(id);
+}
+
+//==============================================================================
+uint32_t sched_period(uint8_t id) {
+  return id < SCHED_MAX_TASKS ? tasks[id].period : 0;
+}
+
+//==============================================================================
+void sched_trigger(uint8_t id) {
+  if(id >= SCHED_MAX_TASKS || !tasks[id].fn) return;
+  tasks[id].deadline = 0;
+  requeue(id);
+}
+
+//==============================================================================
+uint32_t sched_run(uint64_t now) {
+  task_t *t;
+  uint8_t id;
+
+  while(heap_len && tasks[heap[0]].deadline <= now) {
+    id = heap[0];
+    t = &tasks[id];
+
+    t->period_changed = 0;
+    PROFILE_BEGIN(id);
+    t->fn(now);
+    PROFILE_END();
+
+    // A task that set its own period wants the next run that far from this
+    // one. Otherwise keep the task on its grid unless it has fallen a whole
+    // period behind, in which case skip the missed runs rather than bursting
+    // through them.
+    t->last_run = now;
+    if(t->period_changed) {
+      t->deadline = now + t->period;
+    }
+    else {
+      t->deadline += t->period;
+      if(t->deadline <= now) t->deadline = now + t->period;
+    }
+    requeue(id);
+  }
+
+  return sched_idle(now);
+}
+
+//==============================================================================
+uint32_t sched_idle(uint64_t now) {
+  uint64_t next;
+
+  if(!heap_len) return SCHED_IDLE_FOREVER;
+  next = tasks[heap[0]].deadline;
+  if(next <= now) return 0;
+  if(next - now >= SCHED_IDLE_FOREVER) return SCHED_IDLE_FOREVER - 1;
+  return (uint32_t)(next - now);
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static uint8_t before(uint8_t a, uint8_t b) {
+  if(tasks[a].deadline != tasks[b].deadline) {
+    return tasks[a].deadline < tasks[b].deadline;
+  }
+  return a < b;
+}
+
+//==============================================================================
+static void swap(uint8_t i, uint8_t j) {
+  uint8_t tmp = heap[i];
+  heap[i] = heap[j];
+  heap[j] = tmp;
+  heap_pos[heap[i]] = i;
+  heap_pos[heap[j]] = j;
+}
+
+//==============================================================================
+static void sift_up(uint8_t i) {
+  while(i && before(heap[i], heap[(i - 1) / 2])) {
+    swap(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+//==============================================================================
+static void sift_down(uint8_t i) {
+  uint8_t l, r, m;
+
+  for(;;) {
+    l = 2 * i + 1;
+    r = l + 1;
+    m = i;
+    if(l < heap_len && before(heap[l], heap[m])) m = l;
+    if(r < heap_len && before(heap[r], heap[m])) m = r;
+    if(m == i) return;
+    swap(i, m);
+    i = m;
+  }
+}
+
+//==============================================================================
+static void requeue(uint8_t id) {
+  sift_up(heap_pos[id]);
+  sift_down(heap_pos[id]);
+}
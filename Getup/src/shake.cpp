@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+// Getup! Shake Classifier
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "shake.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void shake_init(shake_t *s) {
+  memset(s, 0, sizeof(*s));
+}
+
+//==============================================================================
+uint8_t shake_feed(shake_t *s, int16_t x, int16_t y, int16_t z) {
+  int32_t in[3];
+  int32_t hp;
+  uint32_t e = 0;
+  int8_t sign;
+  uint8_t a;
+
+  in[0] = x;
+  in[1] = y;
+  in[2] = z;
+
+  if(!s->index) {
+    for(a = 0; a < 3; a++) s->gravity[a] = in[a] << 8;
+  }
+  s->index++;
+
+  for(a = 0; a < 3; a++) {
+    // High-pass: subtract a slow exponential average of the input.
+    s->gravity[a] += ((in[a] << 8) - s->gravity[a]) >> SHAKE_HPF_SHIFT;
+    hp = in[a] - (s->gravity[a] >> 8);
+    if(hp > SHAKE_HP_MAX) hp = SHAKE_HP_MAX;
+    if(hp < -SHAKE_HP_MAX) hp = -SHAKE_HP_MAX;
+    e += (uint32_t)(hp * hp);
+
+    // Reversal on this axis, ignoring ringing faster than a hand can move.
+    if(hp > SHAKE_REV_LEVEL || hp < -SHAKE_REV_LEVEL) {
+      sign = hp > 0 ? 1 : -1;
+      if(s->sign[a] && sign != s->sign[a] &&
+        s->index - s->last_rev[a] >= SHAKE_REV_GAP) {
+        s->reversal[s->rev_head] = s->index;
+        s->rev_head = (s->rev_head + 1) % SHAKE_REVERSALS;
+        if(s->rev_count < SHAKE_REVERSALS) s->rev_count++;
+        s->last_rev[a] = s->index;
+      }
+      s->sign[a] = sign;
+    }
+  }
+
+  // Sliding sum of |a|^2 over the window.
+  s->energy_sum += e - s->energy[s->head];
+  s->energy[s->head] = e;
+  s->head = (s->head + 1) % SHAKE_WINDOW;
+
+  // rev_head now points at the oldest of the last SHAKE_REVERSALS.
+  return s->energy_sum > SHAKE_ENERGY &&
+    s->rev_count == SHAKE_REVERSALS &&
+    s->index - s->reversal[s->rev_head] <= SHAKE_REV_SPAN;
+}
@@ -0,0 +1,351 @@
+//------------------------------------------------------------------------------
+// Getup! Alarm Sounds
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "dma.h"
+#include "sound.h"
+#include "trace.h"
+
+#ifdef GETUP_NATIVE
+#include "sim.h"
+#else
+#include "wiring_private.h"
+#endif
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// TCC0 counts the 48 MHz core clock; TC4 counts it divided by 1024
+#define TONE_CLOCK          (48000000ul)
+#define TIME_CLOCK          (TONE_CLOCK / 1024)
+
+// Timer settings while resting
+#define REST_HZ             (1000)
+
+// Full volume is a square wave; duty above half gets no louder
+#define DUTY_DIV            (2ul * 255 * SOUND_RAMP_STEPS)
+
+#define COUNT(a)            (sizeof(a) / sizeof((a)[0]))
+
+static_assert((uint64_t)SOUND_MAX_MS * TIME_CLOCK / 1000 <= 0x10000,
+  "notes must fit the 16-bit TC4");
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Values the note DMA channel copies into TCC0 PERB and CCB0, in register
+// order
+typedef struct {
+  uint32_t per;
+  uint32_t cc;
+} frame_t;
+
+typedef struct {
+  const sound_note_t *notes;
+  uint8_t count;
+} pattern_t;
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static constexpr sound_note_t beep[] = {
+  {440, 50, 255}, {0, 50, 0}
+};
+
+static constexpr sound_note_t chirp[] = {
+  {2093, 40, 255}, {0, 40, 0}, {2093, 40, 255}, {0, 600, 0}
+};
+
+static constexpr sound_note_t siren[] = {
+  {800, 60, 200}, {1000, 60, 220}, {1200, 60, 240}, {1400, 60, 255},
+  {1600, 60, 255}, {1400, 60, 255}, {1200, 60, 240}, {1000, 60, 220}
+};
+
+static constexpr sound_note_t melody[] = {
+  {1047, 150, 255}, {1319, 150, 255}, {1568, 150, 255}, {2093, 300, 255},
+  {0, 500, 0}
+};
+
+// Indexed by sound_t
+static const pattern_t patterns[NUM_SOUNDS] = {
+  {beep, COUNT(beep)},
+  {chirp, COUNT(chirp)},
+  {siren, COUNT(siren)},
+  {melody, COUNT(melody)},
+};
+
+// Both tables start at the pattern's second note: each TC4 overflow ends a
+// note and loads the one after it. The first note is loaded directly, and
+// sits in the last slot.
+static frame_t frames[SOUND_MAX_NOTES];
+static uint16_t ticks[SOUND_MAX_NOTES];
+
+static const pattern_t *pattern = 0;
+static uint64_t start_time = 0;
+static uint8_t level = 0;
+static uint8_t playing = 0;
+static uint8_t pin = 0;
+
+#ifdef GETUP_NATIVE
+static uint8_t slot = 0;
+#else
+__attribute__((__aligned__(16))) static DmacDescriptor
+  chain[SOUND_MAX_NOTES - 1];
+#endif
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void load(uint8_t sound);
+static void set_volume();
+static void hw_begin();
+static void hw_start();
+static void hw_stop();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void sound_begin(uint8_t buzzer_pin) {
+  pin = buzzer_pin;
+  hw_begin();
+}
+
+//==============================================================================
+void sound_start(uint8_t sound, uint64_t now) {
+  if(playing) hw_stop();
+
+  start_time = now;
+  level = 1;
+  load(sound < NUM_SOUNDS ? sound : (uint8_t)SOUND_BEEP);
+  hw_start();
+  playing = 1;
+  trace_log(TRACE_SOUND_START, sound);
+}
+
+//==============================================================================
+void sound_stop() {
+  if(!playing) return;
+  hw_stop();
+  playing = 0;
+  trace_log(TRACE_SOUND_STOP, 0);
+}
+
+//==============================================================================
+uint8_t sound_playing() {
+  return playing;
+}
+
+//==============================================================================
+void sound_update(uint64_t now) {
+  uint32_t step;
+
+  if(!playing || level == SOUND_RAMP_STEPS) return;
+
+  step = 1 + (now - start_time) * (SOUND_RAMP_STEPS - 1) / SOUND_RAMP_MS;
+  if(step > SOUND_RAMP_STEPS) step = SOUND_RAMP_STEPS;
+  if(step == level) return;
+
+  // The DMA picks the new duty up the next time each note comes round.
+  level = step;
+  set_volume();
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Fills the period and length tables for a pattern.
+//==============================================================================
+static void load(uint8_t sound) {
+  const sound_note_t *note;
+  uint8_t n, k;
+  uint16_t ms;
+
+  pattern = &patterns[sound];
+  n = pattern->count;
+  for(k = 0; k < n; k++) {
+    note = &pattern->notes[(k + 1) % n];
+    ms = note->ms < SOUND_MAX_MS ? note->ms : SOUND_MAX_MS;
+    frames[k].per = TONE_CLOCK / (note->hz ? note->hz : REST_HZ) - 1;
+    ticks[k] = (uint32_t)ms * TIME_CLOCK / 1000 - 1;
+  }
+  set_volume();
+}
+
+//==============================================================================
+// Sets each note's duty from its volume and the ramp.
+//==============================================================================
+static void set_volume() {
+  uint8_t n = pattern->count;
+  uint8_t k;
+
+  for(k = 0; k < n; k++) {
+    frames[k].cc = (frames[k].per + 1) *
+      pattern->notes[(k + 1) % n].volume * level / DUTY_DIV;
+  }
+}
+
+#ifndef GETUP_NATIVE
+
+//==============================================================================
+// TCC0 in normal PWM with every output driven from CC0, so PERB and CCB0 are
+// adjacent for the DMA. TC4 in match-frequency mode, CC0 setting the note
+// length.
+//==============================================================================
+static void hw_begin() {
+  PM->APBCMASK.reg |= PM_APBCMASK_TCC0 | PM_APBCMASK_TC4;
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+    GCLK_CLKCTRL_ID_TCC0_TCC1;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+    GCLK_CLKCTRL_ID_TC4_TC5;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+
+  TCC0->CTRLA.reg = TCC_CTRLA_SWRST;
+  while(TCC0->SYNCBUSY.bit.SWRST);
+  TCC0->WEXCTRL.reg = TCC_WEXCTRL_OTMX(2);
+  TCC0->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+  while(TCC0->SYNCBUSY.bit.WAVE);
+
+  TC4->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while(TC4->COUNT16.CTRLA.bit.SWRST);
+  TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ |
+    TC_CTRLA_PRESCALER_DIV1024;
+  while(TC4->COUNT16.STATUS.bit.SYNCBUSY);
+
+  dma_begin();
+  dma_channel(DMA_CH_SOUND_NOTE, TC4_DMAC_ID_OVF, DMAC_CHCTRLB_TRIGACT_BLOCK,
+    0);
+  dma_channel(DMA_CH_SOUND_TIME, TC4_DMAC_ID_OVF, DMAC_CHCTRLB_TRIGACT_BEAT,
+    0);
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+}
+
+//==============================================================================
+// Builds the descriptor rings and starts the timers on the first note. The
+// note ring has one two-word block per note; the length ring is a single
+// descriptor linked to itself, moving one halfword per overflow.
+//==============================================================================
+static void hw_start() {
+  uint8_t n = pattern->count;
+  DmacDescriptor *first = dma_descriptor(DMA_CH_SOUND_NOTE);
+  DmacDescriptor *d, *time = dma_descriptor(DMA_CH_SOUND_TIME);
+  uint8_t k;
+
+  for(k = 0; k < n; k++) {
+    d = k ? &chain[k - 1] : first;
+    d->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD |
+      DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_DSTINC;
+    d->BTCNT.reg = 2;
+    d->SRCADDR.reg = (uint32_t)&frames[k] + sizeof(frame_t);
+    d->DSTADDR.reg = (uint32_t)&TCC0->PERB.reg + sizeof(frame_t);
+    d->DESCADDR.reg = (uint32_t)(k + 1 < n ? &chain[k] : first);
+  }
+
+  time->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD |
+    DMAC_BTCTRL_SRCINC;
+  time->BTCNT.reg = n;
+  time->SRCADDR.reg = (uint32_t)&ticks[n];
+  time->DSTADDR.reg = (uint32_t)&TC4->COUNT16.CC[0].reg;
+  time->DESCADDR.reg = (uint32_t)time;
+
+  TCC0->PER.reg = frames[n - 1].per;
+  TCC0->CC[0].reg = frames[n - 1].cc;
+  while(TCC0->SYNCBUSY.reg);
+  TC4->COUNT16.CC[0].reg = ticks[n - 1];
+  TC4->COUNT16.COUNT.reg = 0;
+  while(TC4->COUNT16.STATUS.bit.SYNCBUSY);
+
+  dma_enable(DMA_CH_SOUND_NOTE);
+  dma_enable(DMA_CH_SOUND_TIME);
+  pinPeripheral(pin, PIO_TIMER);
+  TCC0->CTRLA.reg |= TCC_CTRLA_ENABLE;
+  while(TCC0->SYNCBUSY.bit.ENABLE);
+  TC4->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  while(TC4->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+//==============================================================================
+static void hw_stop() {
+  TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  while(TC4->COUNT16.STATUS.bit.SYNCBUSY);
+  dma_disable(DMA_CH_SOUND_TIME);
+  dma_disable(DMA_CH_SOUND_NOTE);
+  TCC0->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+  while(TCC0->SYNCBUSY.bit.ENABLE);
+
+  // Back to a GPIO so the buzzer is not left driven
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+}
+
+#else
+
+//==============================================================================
+// Host stand-in for the timers and DMA: a virtual-clock event per note
+// boundary, sounding each note through the tone() stand-in. Nothing runs in
+// the firmware's loop.
+//==============================================================================
+static void note_event(void *ctx) {
+  const sound_note_t *note = &pattern->notes[slot];
+
+  (void)ctx;
+  if(note->hz) tone(pin, note->hz);
+  else noTone(pin);
+  sim_at(sim_micros() + (uint64_t)note->ms * 1000, note_event, 0);
+  slot = (slot + 1) % pattern->count;
+}
+
+//==============================================================================
+static void hw_begin() {
+  pinMode(pin, OUTPUT);
+}
+
+//==============================================================================
+static void hw_start() {
+  slot = 0;
+  note_event(0);
+}
+
+//==============================================================================
+static void hw_stop() {
+  sim_cancel(note_event, 0);
+  noTone(pin);
+}
+
+#endif
@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+// Getup! Power and Bus Statistics
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <Arduino.h>
+#include "stats.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static stats_t stats;
+static uint32_t start_epoch = 0;
+static uint32_t start_ms = 0;
+static uint32_t enter_us = 0;
+static uint8_t block = STATS_OTHER;
+static volatile uint8_t asleep = 0;
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void stats_reset(uint32_t epoch, uint32_t ms) {
+  memset(&stats, 0, sizeof(stats));
+  stats.magic = STATS_MAGIC;
+  stats.version = STATS_VERSION;
+  stats.num_blocks = STATS_BLOCKS;
+  stats.num_wake = STATS_NUM_WAKE;
+  stats.num_loads = STATS_NUM_LOADS;
+  stats.weights.active_ua = STATS_UA_ACTIVE;
+  stats.weights.idle_ua = STATS_UA_IDLE;
+  stats.weights.standby_ua = STATS_UA_STANDBY;
+  stats.weights.base_ua = STATS_UA_BASE;
+  stats.weights.load_ua[STATS_LOAD_BACKLIGHT] = STATS_UA_BACKLIGHT;
+  stats.weights.load_ua[STATS_LOAD_BUZZER] = STATS_UA_BUZZER;
+  stats.weights.i2c_byte_nas = STATS_NAS_I2C_BYTE;
+  start_epoch = epoch;
+  start_ms = ms;
+}
+
+//==============================================================================
+const stats_t *stats_get(uint32_t epoch, uint32_t ms) {
+  stats.wall_s = epoch - start_epoch;
+  stats.awake_ms = ms - start_ms;
+  return &stats;
+}
+
+//==============================================================================
+uint32_t stats_avg_ua(const stats_t *s) {
+  const stats_weights_t *w = &s->weights;
+  uint64_t wall_ms = (uint64_t)s->wall_s * 1000;
+  uint64_t awake_ms = s->awake_ms;
+  uint64_t idle_ms = s->idle_us / 1000;
+  uint64_t q, bytes = 0;
+  uint8_t n;
+
+  // wall_s only has whole seconds, so an always-awake unit can appear to
+  // have been awake slightly longer.
+  if(!wall_ms) wall_ms = awake_ms;
+  if(!wall_ms) return 0;
+  if(awake_ms > wall_ms) awake_ms = wall_ms;
+  if(idle_ms > awake_ms) idle_ms = awake_ms;
+
+  // Charge in uA*ms, which is also nA*s.
+  q = (awake_ms - idle_ms) * w->active_ua;
+  q += idle_ms * w->idle_ua;
+  q += (wall_ms - awake_ms) * w->standby_ua;
+  q += wall_ms * w->base_ua;
+  for(n = 0; n < STATS_NUM_LOADS; n++) {
+    q += (uint64_t)s->load_ms[n] * w->load_ua[n];
+  }
+  for(n = 0; n < STATS_BLOCKS; n++) bytes += s->blocks[n].i2c_bytes;
+  q += bytes * w->i2c_byte_nas;
+
+  return (uint32_t)(q / wall_ms);
+}
+
+//==============================================================================
+void stats_enter(uint8_t id) {
+  block = id < STATS_OTHER ? id : STATS_OTHER;
+  enter_us = micros();
+}
+
+//==============================================================================
+void stats_exit() {
+  stats_block_t *b = &stats.blocks[block];
+  uint32_t us = micros() - enter_us;
+
+  b->runs++;
+  b->active_us += us;
+  if(us > b->max_us) b->max_us = us;
+  block = STATS_OTHER;
+}
+
+//==============================================================================
+void stats_i2c_txn() {
+  stats.blocks[block].i2c_txn++;
+}
+
+//==============================================================================
+void stats_i2c_bytes(uint32_t n) {
+  stats.blocks[block].i2c_bytes += n;
+}
+
+//==============================================================================
+void stats_irq(uint8_t source) {
+  if(source >= STATS_NUM_WAKE) return;
+  stats.irqs[source]++;
+  if(asleep) {
+    stats.wakeups[source]++;
+    asleep = 0;
+  }
+}
+
+//==============================================================================
+void stats_idle(uint32_t us) {
+  stats.idle_us += us;
+}
+
+//==============================================================================
+void stats_standby() {
+  stats.standby_count++;
+  asleep = 1;
+}
+
+//==============================================================================
+void stats_load(uint8_t load, uint32_t ms) {
+  if(load < STATS_NUM_LOADS) stats.load_ms[load] += ms;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+#ifndef GETUP_NATIVE
+#include "SERCOM.h"
+
+// Every Wire transfer goes through these SERCOM calls; platformio.ini links
+// with -Wl,--wrap for each so the calls from Wire land here first.
+#define START_WIRE  _ZN6SERCOM21startTransmissionWIREEh23SercomWireReadWriteFlag
+#define SEND_WIRE   _ZN6SERCOM18sendDataMasterWIREEh
+#define READ_WIRE   _ZN6SERCOM12readDataWIREEv
+
+#define WRAP(f)     WRAP_(f)
+#define WRAP_(f)    __wrap_##f
+#define REAL(f)     REAL_(f)
+#define REAL_(f)    __real_##f
+
+extern "C" {
+bool REAL(START_WIRE)(SERCOM *s, uint8_t addr, SercomWireReadWriteFlag flag);
+bool REAL(SEND_WIRE)(SERCOM *s, uint8_t data);
+uint8_t REAL(READ_WIRE)(SERCOM *s);
+
+//==============================================================================
+bool WRAP(START_WIRE)(SERCOM *s, uint8_t addr, SercomWireReadWriteFlag flag) {
+  stats_i2c_txn();
+  return REAL(START_WIRE)(s, addr, flag);
+}
+
+//==============================================================================
+bool WRAP(SEND_WIRE)(SERCOM *s, uint8_t data) {
+  stats_i2c_bytes(1);
+  return REAL(SEND_WIRE)(s, data);
+}
+
+//==============================================================================
+uint8_t WRAP(READ_WIRE)(SERCOM *s) {
+  stats_i2c_bytes(1);
+  return REAL(READ_WIRE)(s);
+}
+}
+#endif
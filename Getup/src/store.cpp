@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+// Getup! Settings Store
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "FlashStorage.h"
+#include "crc16.h"
+#include "store.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define NVM_ROW             (256)
+#define NVM_PAGE            (64)
+
+// Slot 0 of every segment is its header; the key marks it and the value is
+// the segment's generation, which grows by one per compaction.
+#define KEY_HEADER          (0xC0DE)
+#define KEY_ERASED          (0xFFFF)
+
+#define SLOTS               (STORE_SEGMENT / sizeof(record_t))
+#define PAGE_SLOTS          (NVM_PAGE / sizeof(record_t))
+#define NO_SEGMENT          (0xFF)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// One log entry. Eight bytes, so a record never straddles an NVM page.
+//==============================================================================
+typedef struct {
+  uint16_t key;
+  uint16_t crc;
+  uint32_t value;
+} record_t;
+
+static_assert(STORE_KEYS < SLOTS - 1, "a compacted segment must have room");
+static_assert(STORE_SEGMENT % NVM_ROW == 0, "segments are whole rows");
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Spelled out rather than through Flash() so the base address is in reach.
+__attribute__((__aligned__(NVM_ROW)))
+static const uint8_t area[STORE_SIZE] = { };
+static FlashClass flash(area, STORE_SIZE);
+
+static uint32_t values[STORE_KEYS];
+static uint64_t present = 0;
+static uint32_t generation = 0;
+static uint8_t segment = NO_SEGMENT;
+static uint8_t next_slot = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const uint8_t *slot_addr(uint8_t seg, uint8_t slot);
+static void read_slot(uint8_t seg, uint8_t slot, record_t *r);
+static void make_record(record_t *r, uint16_t key, uint32_t value);
+static uint8_t is_valid(const record_t *r);
+static uint8_t is_erased(const record_t *r);
+static uint16_t record_crc(const record_t *r);
+static void load();
+static void compact();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void store_begin() {
+  record_t r;
+  uint8_t s;
+
+  segment = NO_SEGMENT;
+  for(s = 0; s < STORE_SEGMENTS; s++) {
+    read_slot(s, 0, &r);
+    if(!is_valid(&r) || r.key != KEY_HEADER) continue;
+    if(segment == NO_SEGMENT || (int32_t)(r.value - generation) > 0) {
+      segment = s;
+      generation = r.value;
+    }
+  }
+
+  present = 0;
+  if(segment == NO_SEGMENT) {
+    // Nothing valid; compacting an empty set formats the first segment.
+    segment = STORE_SEGMENTS - 1;
+    generation = 0;
+    compact();
+  }
+  else {
+    load();
+  }
+}
+
+//==============================================================================
+uint8_t store_get(uint8_t key, uint32_t *value) {
+  if(key >= STORE_KEYS || !(present & (1ull << key))) return 0;
+  *value = values[key];
+  return 1;
+}
+
+//==============================================================================
+void store_put(uint8_t key, uint32_t value) {
+  record_t r;
+
+  if(key >= STORE_KEYS) return;
+  if((present & (1ull << key)) && values[key] == value) return;
+  values[key] = value;
+  present |= 1ull << key;
+
+  if(next_slot >= SLOTS) {
+    compact();
+    return;
+  }
+  make_record(&r, key, value);
+  flash.write(slot_addr(segment, next_slot), &r, sizeof(r));
+  next_slot++;
+}
+
+//------------------------------------------------------------------------------
+//      __   __              ___  ___
+//     |__) |__) | \  /  /\   |  |__
+//     |    |  \ |  \/  /~~\  |  |___
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+static const uint8_t *slot_addr(uint8_t seg, uint8_t slot) {
+  return area + seg * STORE_SEGMENT + slot * sizeof(record_t);
+}
+
+//==============================================================================
+static void read_slot(uint8_t seg, uint8_t slot, record_t *r) {
+  flash.read(slot_addr(seg, slot), r, sizeof(*r));
+}
+
+//==============================================================================
+static void make_record(record_t *r, uint16_t key, uint32_t value) {
+  r->key = key;
+  r->value = value;
+  r->crc = record_crc(r);
+}
+
+//==============================================================================
+static uint8_t is_valid(const record_t *r) {
+  return r->crc == record_crc(r);
+}
+
+//==============================================================================
+static uint8_t is_erased(const record_t *r) {
+  return r->key == KEY_ERASED && r->crc == 0xFFFF && r->value == 0xFFFFFFFF;
+}
+
+//==============================================================================
+// CRC over key and value.
+//==============================================================================
+static uint16_t record_crc(const record_t *r) {
+  return crc16(&r->value, sizeof(r->value),
+    crc16(&r->key, sizeof(r->key), CRC16_INIT));
+}
+
+//==============================================================================
+// Replays the current segment. Later records win. A record torn by a reset
+// fails its CRC and is skipped; appending resumes after the last slot that
+// is not blank, since a torn slot cannot be rewritten without an erase.
+//==============================================================================
+static void load() {
+  record_t r;
+  uint8_t slot;
+
+  for(slot = 1; slot < SLOTS; slot++) {
+    read_slot(segment, slot, &r);
+    if(is_erased(&r)) break;
+    if(!is_valid(&r) || r.key >= STORE_KEYS) continue;
+    values[r.key] = r.value;
+    present |= 1ull << r.key;
+  }
+  next_slot = slot;
+}
+
+//==============================================================================
+// Writes every stored value into the next segment. The header goes in last,
+// so a reset part way through leaves the old segment as the newest valid
+// one.
+//==============================================================================
+static void compact() {
+  record_t page[PAGE_SLOTS];
+  uint8_t target = (segment + 1) % STORE_SEGMENTS;
+  uint8_t slot = 1;
+  uint8_t key = 0;
+  uint8_t n;
+
+  flash.erase(slot_addr(target, 0), STORE_SEGMENT);
+
+  while(key < STORE_KEYS) {
+    memset(page, 0xFF, sizeof(page));
+    for(n = slot % PAGE_SLOTS; n < PAGE_SLOTS && key < STORE_KEYS; key++) {
+      if(!(present & (1ull << key))) continue;
+      make_record(&page[n++], key, values[key]);
+    }
+    if(n == slot % PAGE_SLOTS) break;
+    flash.write(slot_addr(target, slot - slot % PAGE_SLOTS), page,
+      sizeof(page));
+    slot += n - slot % PAGE_SLOTS;
+  }
+
+  make_record(&page[0], KEY_HEADER, generation + 1);
+  flash.write(slot_addr(target, 0), &page[0], sizeof(page[0]));
+
+  segment = target;
+  generation++;
+  next_slot = slot;
+}
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// Getup! Sync Protocol
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "crc16.h"
+#include "sync.h"
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef enum {
+  WAIT_SOF,
+  WAIT_TYPE,
+  WAIT_SEQ,
+  WAIT_LEN,
+  WAIT_PAYLOAD,
+  WAIT_CRC_LO,
+  WAIT_CRC_HI
+} parse_state_t;
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void sync_reset(sync_parser_t *p) {
+  p->state = WAIT_SOF;
+}
+
+//==============================================================================
+uint8_t sync_feed(sync_parser_t *p, uint8_t byte) {
+  switch(p->state) {
+    case WAIT_SOF:
+      if(byte == SYNC_SOF) {
+        p->crc = CRC16_INIT;
+        p->state = WAIT_TYPE;
+      }
+      return 0;
+    case WAIT_TYPE:
+      p->type = byte;
+      p->state = WAIT_SEQ;
+      break;
+    case WAIT_SEQ:
+      p->seq = byte;
+      p->state = WAIT_LEN;
+      break;
+    case WAIT_LEN:
+      if(byte > SYNC_MAX_PAYLOAD) {
+        p->errors++;
+        p->state = WAIT_SOF;
+        return 0;
+      }
+      p->len = byte;
+      p->pos = 0;
+      p->state = byte ? WAIT_PAYLOAD : WAIT_CRC_LO;
+      break;
+    case WAIT_PAYLOAD:
+      p->payload[p->pos++] = byte;
+      if(p->pos == p->len) p->state = WAIT_CRC_LO;
+      break;
+    case WAIT_CRC_LO:
+      p->crc ^= byte;
+      p->state = WAIT_CRC_HI;
+      return 0;
+    case WAIT_CRC_HI:
+      p->crc ^= (uint16_t)byte << 8;
+      p->state = WAIT_SOF;
+      if(p->crc) p->errors++;
+      return !p->crc;
+  }
+
+  p->crc = crc16(&byte, 1, p->crc);
+  return 0;
+}
+
+//==============================================================================
+uint16_t sync_frame(uint8_t *out, uint8_t type, uint8_t seq,
+  const void *payload, uint8_t len) {
+  uint16_t crc;
+
+  out[0] = SYNC_SOF;
+  out[1] = type;
+  out[2] = seq;
+  out[3] = len;
+  if(len) memcpy(out + 4, payload, len);
+  crc = crc16(out + 1, len + 3, CRC16_INIT);
+  out[len + 4] = crc & 0xFF;
+  out[len + 5] = crc >> 8;
+  return len + SYNC_OVERHEAD;
+}
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+// Getup! System Time
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "systime.h"
+
+#ifdef GETUP_NATIVE
+#include "sim.h"
+#endif
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Generic clock generator for TC3: the 32 kHz crystal, running in standby.
+// GCLK0-3 are the core's and RTCZero's, GCLK6 the EIC's.
+#define TC3_GCLK            (4)
+
+// A count below this with the overflow flag set was read after the wrap
+#define COUNT_HALF          (0x8000)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#ifdef GETUP_NATIVE
+static uint64_t start_us = 0;
+#else
+// Upper 32 bits of the count; written only by the overflow ISR
+static volatile uint32_t high = 0;
+#endif
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void systime_begin() {
+#ifdef GETUP_NATIVE
+  start_us = sim_micros();
+#else
+  PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+
+  // The core has the crystal running in standby already; RTCZero asks the
+  // same of it.
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(TC3_GCLK) | GCLK_GENDIV_DIV(1);
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(TC3_GCLK) | GCLK_GENCTRL_SRC_XOSC32K |
+    GCLK_GENCTRL_GENEN | GCLK_GENCTRL_RUNSTDBY;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3 | GCLK_CLKCTRL_GEN(TC3_GCLK) |
+    GCLK_CLKCTRL_CLKEN;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while(TC3->COUNT16.CTRLA.bit.SWRST);
+
+  // 32768 Hz / 32 = SYSTIME_HZ. Continuous read sync keeps COUNT readable
+  // without waiting on the slow clock.
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_PRESCALER_DIV32 |
+    TC_CTRLA_RUNSTDBY;
+  TC3->COUNT16.READREQ.reg = TC_READREQ_RCONT |
+    TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+  TC3->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+  high = 0;
+
+  NVIC_ClearPendingIRQ(TC3_IRQn);
+  NVIC_EnableIRQ(TC3_IRQn);
+  TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  while(TC3->COUNT16.STATUS.bit.SYNCBUSY);
+#endif
+}
+
+//==============================================================================
+uint64_t systime_ticks() {
+#ifdef GETUP_NATIVE
+  // Always-on virtual time, which keeps running in sim_sleep()
+  return (sim_micros() - start_us) * SYSTIME_HZ / 1000000;
+#else
+  uint32_t hi, again;
+  uint16_t count;
+
+  do {
+    hi = high;
+    count = TC3->COUNT16.COUNT.reg;
+    again = high;
+  } while(hi != again);
+
+  // Wrapped, but the ISR has yet to carry
+  if((TC3->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) && count < COUNT_HALF) hi++;
+
+  return ((uint64_t)hi << 16) | count;
+#endif
+}
+
+//==============================================================================
+uint64_t systime_ms() {
+  // ticks * 1000 / 1024
+  return (systime_ticks() * 125) >> 7;
+}
+
+//------------------------------------------------------------------------------
+//        __   __   __
+//     | /__` |__) /__`
+//     | .__/ |  \ .__/
+//
+//------------------------------------------------------------------------------
+
+#ifndef GETUP_NATIVE
+
+//==============================================================================
+// TC3 overflow: carries into the high word.
+//==============================================================================
+void TC3_Handler() {
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+  high++;
+}
+
+#endif
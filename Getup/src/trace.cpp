@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+// Getup! Event Trace
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <Arduino.h>
+#include "trace.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define TRACE_MASK          (TRACE_DEPTH - 1)
+
+static_assert((TRACE_DEPTH & TRACE_MASK) == 0,
+  "TRACE_DEPTH must be a power of two");
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static trace_t trace;
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+void trace_reset() {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  memset(&trace, 0, sizeof(trace));
+  trace.magic = TRACE_MAGIC;
+  trace.version = TRACE_VERSION;
+  trace.depth = TRACE_DEPTH;
+  __set_PRIMASK(primask);
+}
+
+//==============================================================================
+void trace_log(uint8_t id, uint16_t arg) {
+  uint32_t primask = __get_PRIMASK();
+  trace_event_t *e;
+
+  // Called from ISRs and main alike, so the slot is claimed with interrupts
+  // off and whatever state the caller had put back.
+  __disable_irq();
+  e = &trace.events[trace.count & TRACE_MASK];
+  e->us = micros();
+  e->arg = arg;
+  e->id = id;
+  trace.count++;
+  __set_PRIMASK(primask);
+}
+
+//==============================================================================
+const trace_t *trace_get() {
+  return &trace;
+}
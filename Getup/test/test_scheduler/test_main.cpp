@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// Getup! Task Scheduler Tests
+// Deadlines after sched_set_period(), from outside a task and from the
+// task's own body.
+//
+// pio test -e native_test
+//------------------------------------------------------------------------------
+
+#include <unity.h>
+#include "scheduler.h"
+
+#define TASK_SHORTER        (0)
+#define TASK_LONGER         (1)
+#define TASK_OUTSIDE        (2)
+#define TASK_SAME           (3)
+
+// Each test starts its task this far after the last. Tasks from earlier
+// tests stay queued and run alongside, but only their own counts are
+// checked.
+#define TEST_SPAN           (1000000ull)
+
+static uint32_t runs[SCHED_MAX_TASKS];
+static uint64_t last_run[SCHED_MAX_TASKS];
+static uint32_t next_period[SCHED_MAX_TASKS];
+static uint64_t base = 0;
+
+//==============================================================================
+static void record(uint8_t id, uint64_t now) {
+  runs[id]++;
+  last_run[id] = now;
+  if(next_period[id]) sched_set_period(id, next_period[id]);
+}
+
+//==============================================================================
+static void task_shorter(uint64_t now) { record(TASK_SHORTER, now); }
+static void task_longer(uint64_t now) { record(TASK_LONGER, now); }
+static void task_outside(uint64_t now) { record(TASK_OUTSIDE, now); }
+static void task_same(uint64_t now) { record(TASK_SAME, now); }
+
+//==============================================================================
+// Runs the scheduler at now and returns how often id has run in total.
+//==============================================================================
+static uint32_t run_at(uint8_t id, uint64_t now) {
+  sched_run(base + now);
+  return runs[id];
+}
+
+//==============================================================================
+void setUp() {
+  base += TEST_SPAN;
+}
+
+//==============================================================================
+void tearDown() {
+}
+
+//==============================================================================
+void test_own_period_shorter() {
+  next_period[TASK_SHORTER] = 500;
+  sched_add(TASK_SHORTER, 1000, task_shorter, base);
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_SHORTER, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_SHORTER, 499));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_SHORTER, 500));
+  TEST_ASSERT_EQUAL_UINT64(base + 500, last_run[TASK_SHORTER]);
+}
+
+//==============================================================================
+void test_own_period_longer() {
+  sched_add(TASK_LONGER, 100, task_longer, base);
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_LONGER, 0));
+  next_period[TASK_LONGER] = 300;
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_LONGER, 100));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_LONGER, 399));
+  TEST_ASSERT_EQUAL_UINT32(3, run_at(TASK_LONGER, 400));
+  TEST_ASSERT_EQUAL_UINT32(300, sched_period(TASK_LONGER));
+}
+
+//==============================================================================
+void test_period_from_outside() {
+  sched_add(TASK_OUTSIDE, 1000, task_outside, base);
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_OUTSIDE, 0));
+  sched_run(base + 200);
+  sched_set_period(TASK_OUTSIDE, 400);
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_OUTSIDE, 399));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_OUTSIDE, 400));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_OUTSIDE, 799));
+  TEST_ASSERT_EQUAL_UINT32(3, run_at(TASK_OUTSIDE, 800));
+}
+
+//==============================================================================
+// Setting the period it already has keeps a late task on its grid.
+//==============================================================================
+void test_own_period_same() {
+  next_period[TASK_SAME] = 1000;
+  sched_add(TASK_SAME, 1000, task_same, base);
+  TEST_ASSERT_EQUAL_UINT32(1, run_at(TASK_SAME, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_SAME, 1200));
+  TEST_ASSERT_EQUAL_UINT32(2, run_at(TASK_SAME, 1999));
+  TEST_ASSERT_EQUAL_UINT32(3, run_at(TASK_SAME, 2000));
+}
+
+//==============================================================================
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_own_period_shorter);
+  RUN_TEST(test_own_period_longer);
+  RUN_TEST(test_period_from_outside);
+  RUN_TEST(test_own_period_same);
+  return UNITY_END();
+}
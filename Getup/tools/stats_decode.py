@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------------
+# Getup! Stats Decoder
+# Decodes a stats snapshot frame from the firmware (include/stats.h) and
+# prints the per-task counters, interrupts and wakeups, and the average
+# current and mAh/day worked out from the weights in the snapshot.
+#
+# usage: stats_decode.py [file]          frame from a file, or stdin
+#        stats_decode.py -p /dev/ttyACM0 ask the unit directly (pyserial)
+#-------------------------------------------------------------------------------
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x53505547
+VERSION = 1
+
+BLOCK_NAMES = ["BUTTONS", "RTC", "ACCEL", "QI", "BATT", "SPKR", "LED", "LCD",
+               "FSM", "ALM", "STATS", "BLE"]
+WAKE_NAMES = ["button", "tick", "alarm", "accel", "qi", "ble"]
+LOAD_NAMES = ["backlight", "buzzer"]
+
+HEADER = struct.Struct("<IBBBBIIQI")
+BLOCK = struct.Struct("<QIIII")
+
+
+#===============================================================================
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT, as src/crc16.cpp."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+#===============================================================================
+def read_frame(data):
+    """Finds the "GS" frame in data and returns its checked payload."""
+    start = data.find(b"GS")
+    if start < 0 or len(data) < start + 4:
+        raise ValueError("no snapshot frame")
+    (length,) = struct.unpack_from("<H", data, start + 2)
+    payload = data[start + 4:start + 4 + length]
+    tail = data[start + 4 + length:start + 6 + length]
+    if len(payload) != length or len(tail) != 2:
+        raise ValueError("short frame")
+    if struct.unpack("<H", tail)[0] != crc16(payload):
+        raise ValueError("CRC mismatch")
+    return payload
+
+
+#===============================================================================
+def decode(payload):
+    (magic, version, num_blocks, num_wake, num_loads, wall_s, awake_ms,
+     idle_us, standby_count) = HEADER.unpack_from(payload, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a version %d snapshot" % VERSION)
+
+    off = HEADER.size
+    s = dict(wall_s=wall_s, awake_ms=awake_ms, idle_us=idle_us,
+             standby_count=standby_count)
+
+    def take(n, fmt="I"):
+        nonlocal off
+        vals = struct.unpack_from("<%d%s" % (n, fmt), payload, off)
+        off += struct.calcsize("<%d%s" % (n, fmt))
+        return list(vals)
+
+    s["load_ms"] = take(num_loads)
+    s["irqs"] = take(num_wake)
+    s["wakeups"] = take(num_wake)
+    w = take(4 + num_loads + 1)
+    s["weights"] = dict(active=w[0], idle=w[1], standby=w[2], base=w[3],
+                        loads=w[4:4 + num_loads], i2c_byte_nas=w[-1])
+    off = (off + 7) & ~7
+    s["blocks"] = [BLOCK.unpack_from(payload, off + n * BLOCK.size)
+                   for n in range(num_blocks)]
+    return s
+
+
+#===============================================================================
+def average_ua(s):
+    """Same arithmetic as stats_avg_ua()."""
+    w = s["weights"]
+    wall_ms = s["wall_s"] * 1000 or s["awake_ms"]
+    if not wall_ms:
+        return 0
+    awake_ms = min(s["awake_ms"], wall_ms)
+    idle_ms = min(s["idle_us"] // 1000, awake_ms)
+    q = (awake_ms - idle_ms) * w["active"]
+    q += idle_ms * w["idle"]
+    q += (wall_ms - awake_ms) * w["standby"]
+    q += wall_ms * w["base"]
+    q += sum(ms * ua for ms, ua in zip(s["load_ms"], w["loads"]))
+    q += sum(b[4] for b in s["blocks"]) * w["i2c_byte_nas"]
+    return q // wall_ms
+
+
+#===============================================================================
+def report(s):
+    wall = s["wall_s"] or 1
+    print("wall time   %u s, awake %.1f s, halted %.1f s, standby entries %u"
+          % (s["wall_s"], s["awake_ms"] / 1e3, s["idle_us"] / 1e6,
+             s["standby_count"]))
+    print()
+    print("  %-8s %10s %12s %10s %10s %10s" %
+          ("block", "runs", "cpu ms", "max us", "txn/s", "bytes/s"))
+    for n, (active_us, runs, max_us, txn, nbytes) in enumerate(s["blocks"]):
+        name = BLOCK_NAMES[n] if n < len(BLOCK_NAMES) else "#%d" % n
+        if n == len(s["blocks"]) - 1:
+            name = "other"
+        if not runs and not txn:
+            continue
+        print("  %-8s %10u %12.1f %10u %10.2f %10.2f" %
+              (name, runs, active_us / 1e3, max_us, txn / wall, nbytes / wall))
+    print()
+    print("  %-8s %10s %10s" % ("source", "irqs", "wakeups"))
+    for name, irqs, wakeups in zip(WAKE_NAMES, s["irqs"], s["wakeups"]):
+        print("  %-8s %10u %10u" % (name, irqs, wakeups))
+    print()
+    for name, ms in zip(LOAD_NAMES, s["load_ms"]):
+        print("%-10s on %.1f s" % (name, ms / 1e3))
+    ua = average_ua(s)
+    wall_ms = s["wall_s"] * 1000
+    standby = 0
+    if wall_ms:
+        standby = max(wall_ms - s["awake_ms"], 0) * 100.0 / wall_ms
+    print("average     %u uA, %.2f mAh/day, %.1f%% in standby" %
+          (ua, ua * 24 / 1000.0, standby))
+
+
+#===============================================================================
+def main():
+    ap = argparse.ArgumentParser(description="Decode a Getup! stats snapshot.")
+    ap.add_argument("file", nargs="?", help="snapshot frame (default stdin)")
+    ap.add_argument("-p", "--port", help="serial port to request it from")
+    ap.add_argument("-b", "--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=1) as port:
+            port.reset_input_buffer()
+            port.write(b"s")
+            data = port.read(4096)
+    elif args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    try:
+        report(decode(read_frame(data)))
+    except ValueError as e:
+        sys.exit("stats_decode: %s" % e)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------------
+# Getup! Trace Decoder
+# Decodes event trace frames from the firmware (include/trace.h), pairs the
+# events into user-visible latencies (alarm to sound, shake to silence,
+# charger to silence, button to display) and prints a histogram of each.
+# Any number of frames may be given; events seen in more than one dump are
+# counted once, and no pair spans events the ring overwrote between dumps.
+#
+# usage: trace_decode.py [-l] [file...]   frames from files, or stdin
+#        trace_decode.py -p /dev/ttyACM0  ask the unit directly (pyserial)
+#   -l  Also list every event.
+#-------------------------------------------------------------------------------
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x54505547
+VERSION = 1
+
+ALARM_IRQ, ALARM_RING, ALARM_QUIET, SOUND_START, SOUND_STOP, SHAKE, QI, \
+    BUTTON, LCD_FLUSH = range(1, 10)
+EVENT_NAMES = {ALARM_IRQ: "alarm irq", ALARM_RING: "alarm ring",
+               ALARM_QUIET: "alarm quiet", SOUND_START: "sound start",
+               SOUND_STOP: "sound stop", SHAKE: "shake", QI: "charger",
+               BUTTON: "button", LCD_FLUSH: "lcd flush"}
+SNOOZE = 0xFFFF
+BY_SHAKE = 0
+BUTTON_PRESS = 0
+BUTTON_NAMES = ["PLUS", "MINUS", "SEL", "SET"]
+
+HEADER = struct.Struct("<IBBHI")
+EVENT = struct.Struct("<IHBB")
+
+# Latencies in report order; pair() says which events start and end each
+METRICS = ["alarm irq -> ring", "ring -> sound", "alarm irq -> sound",
+           "shake -> quiet", "quiet -> sound off", "charger -> sound off",
+           "button -> lcd"]
+
+BUCKETS_MS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000]
+BAR_WIDTH = 40
+
+
+#===============================================================================
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT, as src/crc16.cpp."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+#===============================================================================
+def read_frames(data):
+    """Yields the checked payload of every "GT" frame in data."""
+    start = data.find(b"GT")
+    while start >= 0 and len(data) >= start + 4:
+        (length,) = struct.unpack_from("<H", data, start + 2)
+        payload = data[start + 4:start + 4 + length]
+        tail = data[start + 4 + length:start + 6 + length]
+        if (len(payload) == length and len(tail) == 2 and
+                struct.unpack("<H", tail)[0] == crc16(payload)):
+            yield payload
+            start = data.find(b"GT", start + 6 + length)
+        else:
+            start = data.find(b"GT", start + 1)
+
+
+#===============================================================================
+def decode(payload):
+    """Returns the frame's event count and its events, oldest first."""
+    magic, version, _, depth, count = HEADER.unpack_from(payload, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a version %d trace" % VERSION)
+    ring = [EVENT.unpack_from(payload, HEADER.size + n * EVENT.size)
+            for n in range(depth)]
+    if count <= depth:
+        events = ring[:count]
+    else:
+        events = ring[count % depth:] + ring[:count % depth]
+    return count, [(us, ev_id, arg) for us, arg, ev_id, _ in events]
+
+
+#===============================================================================
+def merge(frames):
+    """Numbers events across frames. Returns {seq: (us, id, arg)}. A count
+    lower than the last frame's means the trace was reset."""
+    events = {}
+    base = 0
+    last = 0
+    for count, evs in frames:
+        if count < last:
+            base += last
+        last = count
+        first = count - len(evs)
+        for n, ev in enumerate(evs):
+            events[base + first + n] = ev
+    return events
+
+
+#===============================================================================
+def pair(events):
+    """Runs the events through the pairing rules and returns the latencies
+    in us for each metric."""
+    lat = {m: [] for m in METRICS}
+    pending = {}
+    playing = False
+    prev = None
+
+    def start(m, us):
+        pending.setdefault(m, us)
+
+    def end(m, us):
+        if m in pending:
+            lat[m].append((us - pending.pop(m)) & 0xFFFFFFFF)
+
+    for seq in sorted(events):
+        us, ev, arg = events[seq]
+        if prev is not None and seq != prev + 1:
+            pending.clear()
+        prev = seq
+
+        if ev == ALARM_IRQ:
+            start("alarm irq -> ring", us)
+            start("alarm irq -> sound", us)
+        elif ev == ALARM_RING:
+            end("alarm irq -> ring", us)
+            start("ring -> sound", us)
+        elif ev == SOUND_START:
+            end("ring -> sound", us)
+            end("alarm irq -> sound", us)
+            playing = True
+        elif ev == SHAKE and playing:
+            start("shake -> quiet", us)
+        elif ev == ALARM_QUIET:
+            # Stopped before it sounded, as on the charger
+            pending.pop("ring -> sound", None)
+            pending.pop("alarm irq -> sound", None)
+            if arg == BY_SHAKE:
+                end("shake -> quiet", us)
+            if playing:
+                start("quiet -> sound off", us)
+        elif ev == QI and arg and playing:
+            start("charger -> sound off", us)
+        elif ev == SOUND_STOP:
+            end("quiet -> sound off", us)
+            end("charger -> sound off", us)
+            pending.pop("shake -> quiet", None)
+            playing = False
+        elif ev == BUTTON and (arg & 0xFF) == BUTTON_PRESS:
+            start("button -> lcd", us)
+        elif ev == LCD_FLUSH:
+            end("button -> lcd", us)
+    return lat
+
+
+#===============================================================================
+def describe(ev, arg):
+    name = EVENT_NAMES.get(ev, "#%d" % ev)
+    if ev == ALARM_RING:
+        return name + (" snooze" if arg == SNOOZE else " %d" % (arg + 1))
+    if ev == ALARM_QUIET:
+        return name + (" shake" if arg == BY_SHAKE else " charger")
+    if ev == QI:
+        return name + (" on" if arg else " off")
+    if ev == BUTTON:
+        b = arg >> 8
+        kind = ["press", "release", "long", "repeat"][arg & 3]
+        return "%s %s %s" % (name, BUTTON_NAMES[b] if b < 4 else b, kind)
+    if ev in (SOUND_START, LCD_FLUSH):
+        return "%s %d" % (name, arg)
+    return name
+
+
+#===============================================================================
+def histogram(name, values):
+    values = sorted(values)
+    n = len(values)
+    print("%s: %d" % (name, n))
+    if not n:
+        print()
+        return
+    print("  min %.3f ms, median %.3f ms, p90 %.3f ms, max %.3f ms" %
+          (values[0] / 1e3, values[n // 2] / 1e3,
+           values[min(n - 1, n * 9 // 10)] / 1e3, values[-1] / 1e3))
+    counts = [0] * (len(BUCKETS_MS) + 1)
+    for v in values:
+        k = 0
+        while k < len(BUCKETS_MS) and v >= BUCKETS_MS[k] * 1000:
+            k += 1
+        counts[k] += 1
+    lo = next(k for k, c in enumerate(counts) if c)
+    hi = max(k for k, c in enumerate(counts) if c)
+    top = max(counts)
+    for k in range(lo, hi + 1):
+        label = ("< %d ms" % BUCKETS_MS[k] if k < len(BUCKETS_MS)
+                 else ">= %d ms" % BUCKETS_MS[-1])
+        bar = "#" * ((counts[k] * BAR_WIDTH + top - 1) // top)
+        print("  %10s %6d %s" % (label, counts[k], bar))
+    print()
+
+
+#===============================================================================
+def main():
+    ap = argparse.ArgumentParser(description="Decode Getup! event traces.")
+    ap.add_argument("files", nargs="*", help="trace frames (default stdin)")
+    ap.add_argument("-p", "--port", help="serial port to request it from")
+    ap.add_argument("-b", "--baud", type=int, default=115200)
+    ap.add_argument("-l", "--list", action="store_true",
+                    help="list every event")
+    args = ap.parse_args()
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=1) as port:
+            port.reset_input_buffer()
+            port.write(b"t")
+            data = port.read(4096)
+    elif args.files:
+        data = b""
+        for name in args.files:
+            with open(name, "rb") as f:
+                data += f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    try:
+        frames = [decode(p) for p in read_frames(data)]
+    except ValueError as e:
+        sys.exit("trace_decode: %s" % e)
+    if not frames:
+        sys.exit("trace_decode: no trace frame")
+    events = merge(frames)
+
+    seqs = sorted(events)
+    lost = seqs[-1] - seqs[0] + 1 - len(seqs)
+    print("%d frames, %d events, %d overwritten between dumps\n" %
+          (len(frames), len(events), lost))
+    if args.list:
+        for seq in seqs:
+            us, ev, arg = events[seq]
+            print("  %8d %10u us  %s" % (seq, us, describe(ev, arg)))
+        print()
+
+    lat = pair(events)
+    for m in METRICS:
+        histogram(m, lat[m])
+
+
+if __name__ == "__main__":
+    main()